@@ -0,0 +1,53 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "AllocationCounter.h"
+
+/**
+
+	This file contains the allocation counter used to check that the simulation steps don't
+	allocate memory (see AllocationCounter.h).  It is only active when compiled with -DSWD_ALLOC_CHECK.
+
+*/
+
+#ifdef SWD_ALLOC_CHECK
+
+#include <cstdlib>
+#include <new>
+
+// number of calls to operator new so far, per thread (so each thread only sees its own allocations, and a run
+// isn't blamed for the allocations of the other threads)
+static thread_local long allocationCount = 0;
+
+// replacement of the global operator new, which counts every allocation
+// (the array and nothrow versions call this one, so they are counted too)
+void* operator new(std::size_t size) {
+	allocationCount ++;
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == NULL)
+		throw std::bad_alloc();
+	return memory;
+}
+
+// matching replacement of the global operator delete
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+// method to get the number of allocations made so far by the calling thread
+long getAllocationCount() {
+	return allocationCount;
+}
+
+#else
+
+// method to get the number of allocations made so far (not counted without SWD_ALLOC_CHECK)
+long getAllocationCount() {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+/**
+
+	Header file for the AllocationCounter.cpp methods.
+
+	The timesteps of a simulation shouldn't allocate any memory (allocations every dt are slow, and
+	the threads of a multi-cell simulation would contend for the allocator).  To check this, compile
+	with -DSWD_ALLOC_CHECK: AllocationCounter.cpp then replaces the global operator new with one that
+	counts the allocations of each thread, and SWDSimulatorSingle::run asserts that its thread made
+	none while stepping the cell (so the check also holds when cells are run on several threads at once).
+	compileAllocCheck.sh builds and runs singleSim and ensembleSim with the flag.  Without the flag, nothing is replaced and the count is always 0.
+
+*/
+
+long getAllocationCount(); // (of the calling thread)
+
+#endif
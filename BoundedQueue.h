@@ -0,0 +1,131 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+/*
+
+	This class describes a BoundedQueue, which is a fixed-size lock-free queue that any number of
+	threads can push to and pop from at once (i.e. the worker threads of a multicell simulation push
+	their finished cells, and the writer threads pop them to print them).
+
+	Each slot of the ring holds a sequence number, which says whether it is ready to be pushed to or
+	popped from on the current lap of the ring, so a push or pop only needs one compare-and-swap of
+	the shared position (no locks).  The capacity is rounded up to a power of two.
+
+	push and pop wait when the queue is full or empty (by yielding, and then sleeping briefly), so a
+	full queue holds back the threads pushing to it until the threads popping catch up.
+
+*/
+
+template <typename T>
+class BoundedQueue {
+
+	struct Slot {
+		std::atomic<size_t> sequence; // position the slot is ready for (pushed to when = pos, popped from when = pos + 1)
+		T value;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t mask; // capacity - 1
+	alignas(64) std::atomic<size_t> pushPos; // (on separate cache lines, since different threads update them)
+	alignas(64) std::atomic<size_t> popPos;
+
+	// method to wait a little while the queue is full or empty: yield at first, then sleep
+	static void backOff(int &tries) {
+		if (tries ++ < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+
+public:
+
+	BoundedQueue(size_t capacity) : pushPos(0), popPos(0) {
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+		slots.reset(new Slot[size]);
+		for (size_t i = 0; i < size; i ++)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		mask = size - 1;
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	// method to push a value, if the queue isn't full
+	// returns false (without pushing) if it is full
+	bool tryPush(const T &value) {
+		size_t pos = pushPos.load(std::memory_order_relaxed);
+		while (true) {
+			Slot &slot = slots[pos & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			long difference = (long) sequence - (long) pos;
+			if (difference == 0) { // the slot is free on this lap, so claim it
+				if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					slot.value = value;
+					slot.sequence.store(pos + 1, std::memory_order_release); // (now it can be popped)
+					return true;
+				}
+			} else if (difference < 0) // the slot hasn't been popped since the last lap, so the queue is full
+				return false;
+			else // another thread pushed here first
+				pos = pushPos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// method to pop the oldest value into value, if the queue isn't empty
+	// returns false (without popping) if it is empty
+	bool tryPop(T &value) {
+		size_t pos = popPos.load(std::memory_order_relaxed);
+		while (true) {
+			Slot &slot = slots[pos & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			long difference = (long) sequence - (long) (pos + 1);
+			if (difference == 0) { // the slot has been pushed to on this lap, so claim it
+				if (popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					value = slot.value;
+					slot.sequence.store(pos + mask + 1, std::memory_order_release); // (now it can be pushed to on the next lap)
+					return true;
+				}
+			} else if (difference < 0) // nothing has been pushed here yet, so the queue is empty
+				return false;
+			else // another thread popped here first
+				pos = popPos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// method to push a value, waiting for room if the queue is full
+	void push(const T &value) {
+		int tries = 0;
+		while (!tryPush(value))
+			backOff(tries);
+	}
+
+	// method to pop the oldest value, waiting for one if the queue is empty
+	T pop() {
+		T value;
+		int tries = 0;
+		while (!tryPop(value))
+			backOff(tries);
+		return value;
+	}
+
+	size_t getCapacity() const { return mask + 1; }
+
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "SWDCalibration.h"
+#include "TemperatureFile.h"
+
+/*
+
+	This file is a runner for the calibration of the singlecell simulator to an observed series (see SWDCalibration.h).
+	It takes in command line arguments to run the calibration.
+	Run the calibration as follows:
+
+	First, compile the model.  Call it using:
+
+	./calibrateSim useDefault paramFileName tempFileName rangesFileName observedFileName observedStage ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop [method] [maxEvaluations] [numThreads]
+
+	useDefault = [0|1] 1 to start from the default parameters, 0 to read them from paramFileName
+	paramFileName = the extended parameters list for the parameters not calibrated (and the starting point of the
+	                ones calibrated).  Usually configparams.txt
+	tempFileName = a file with 365 single line entries of temperatures at the site (i.e. clark_2003.txt)
+	rangesFileName = the parameters to calibrate, one per line as "name: min max" (i.e. "fruit time lag: 30 70")
+	observedFileName = the observed series, one observation per line as "day value" (i.e. trap counts)
+	observedStage = the stage observed: eggs, instar1, instar2, instar3, pupae, males, females or adults
+	ignoreFruit = [0|1] 0, use the fruit model, 1 ignore the fruit model
+	ignoreDiapause = [0|1] 0, use the diapause model, 1 ignore the diapause model
+	outputFileName = destination for the calibrated parameters (a config file, which can be used as paramFileName)
+	addFliesDate = 0-364 for fly introduction date, -1 to use diapause termination date
+	startingFemPop = number of initial fecund females (> 0), unless "initial females1" is calibrated
+	method = (optional) neldermead (default) or cmaes
+	maxEvaluations = (optional) number of runs to stop after (2000 by default)
+	numThreads = (optional) number of runs at once, 0 for one per hardware thread (the default)
+
+	To skip parsing the temperature file on repeated runs, set the environment variable SWD_TEMPERATURE_CACHE to
+	a directory to cache the parsed temperatures in (see TemperatureFile.h).
+
+	The error (sum of squared differences from the observations), the number of runs, and the calibrated values
+	are also printed to the console.
+
+*/
+
+// main method to run the code; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	if ( argc < 12 || argc > 15)
+	{
+		printf( "Error, exiting now\nUsage: ./calibrateSim useDefault paramFileName tempFileName rangesFileName observedFileName observedStage ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop [neldermead|cmaes] [maxEvaluations] [numThreads]");
+		printf( "\n\nNote that: useDefault, ignoreFruit, ignoreDiapause are bools (0 = false)\nNote also that: addFliesDate as -1 specifies to add the flies on diapause cross date.\n");
+		exit( 0);
+	}
+
+	// read in all the arguments
+	std::stringstream sstm;
+	sstm << argv[1] << " " << argv[7] << " " << argv[ 8] << " " << argv[ 10] << " " << argv[ 11]; // need all the numbers saved here
+
+	std::string inputFileName = argv[ 2];
+	std::string tempFileName = argv[ 3];
+	std::string rangesFileName = argv[ 4];
+	std::string observedFileName = argv[ 5];
+	std::string observedStage = argv[ 6];
+	std::string outputFileName = argv[ 9];
+
+	bool useDefault;
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDate;
+	double startFemPop;
+
+	sstm >> useDefault;
+	sstm >> ignoreFruit;
+	sstm >> ignoreDiapause;
+	sstm >> startDate;
+	sstm >> startFemPop;
+
+	std::string method = ( argc >= 13) ? argv[ 12] : "neldermead";
+	int maxEvaluations = ( argc >= 14) ? atoi( argv[ 13]) : 2000;
+	int numThreads = ( argc == 15) ? atoi( argv[ 14]) : 0;
+
+	// read the parameters to start from (once)
+	Parameters params;
+	if ( useDefault == 0)
+		params.setConfigParams( inputFileName);
+	params.setParameter( "initial females1", startFemPop);
+
+	// read temperatures in from file (through the parsed temperatures cache, if SWD_TEMPERATURE_CACHE is set)
+	const char* cacheDirectory = getenv( "SWD_TEMPERATURE_CACHE");
+	if ( cacheDirectory != NULL)
+		setTemperatureCache( cacheDirectory);
+
+	std::vector< double> temperatures;
+	readTemperatureFile( tempFileName, temperatures);
+	if ( temperatures.size() == 0)
+	{
+		printf( "Error: could not read the temperature file %s\n", tempFileName.c_str());
+		exit( 1);
+	}
+
+	// set up the calibration
+	SWDCalibration calibration( params, temperatures);
+
+	errormsg status = calibration.loadRanges( rangesFileName);
+	if ( status.compare( "Success!") == 0)
+		status = calibration.loadObserved( observedFileName, observedStage);
+	if ( status.compare( "Success!") != 0)
+	{
+		printf( "%s\n", status.c_str());
+		exit( 1);
+	}
+
+	calibration.setRun( ignoreFruit, ignoreDiapause, startDate);
+	calibration.setMethod( method == "cmaes" ? CMA_ES_METHOD : NELDER_MEAD_METHOD);
+	calibration.setMaxEvaluations( maxEvaluations);
+	calibration.setNumThreads( numThreads);
+
+	// run it, and print the calibrated parameters to the output file
+	status = calibration.calibrate();
+	if ( status.compare( "Success!") == 0)
+		status = calibration.printBestParams( outputFileName);
+	if ( status.compare( "Success!") != 0)
+	{
+		printf( "%s\n", status.c_str());
+		exit( 1);
+	}
+
+	printf( "Error (SSE): %g\nRuns: %d (%d stopped early), iterations: %d\n", calibration.getBestError(), calibration.getNumEvaluations(), calibration.getNumTerminated(), calibration.getNumIterations());
+	std::vector< double> values = calibration.getBestValues();
+	for ( int i = 0; i < values.size(); i ++)
+		printf( "%s: %g\n", calibration.getRanges().getName( i).c_str(), values[ i]);
+
+	return 0;
+}
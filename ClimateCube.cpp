@@ -0,0 +1,172 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "ClimateCube.h"
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+
+	Implementation of the ClimateCube class.  The class definition and description (with the file layout)
+	are included in the ClimateCube header file.
+
+*/
+
+const char ClimateCube::MAGIC[9] = "SWDCUBE1";
+
+static const size_t HEADER_SIZE = 8 + 4 * sizeof(int32_t);
+
+// method to get the size of the per-cell section of a cube with the specified number of cells (padded to 8 bytes)
+static size_t getCellSectionSize(size_t numCells) {
+	size_t size = numCells * (2 * sizeof(double) + sizeof(int32_t) + 1);
+	return (size + 7) / 8 * 8;
+}
+
+// constructor for an (empty) ClimateCube
+ClimateCube::ClimateCube() : data(NULL), dataSize(0), rows(0), cols(0), days(0), valueSize(8), latitudes(NULL), longitudes(NULL), numDays(NULL), nanMask(NULL), payload(NULL) {}
+
+// destructor for the ClimateCube: unmaps the file
+ClimateCube::~ClimateCube() {
+	close();
+}
+
+// method to unmap the file (if one is mapped)
+void ClimateCube::close() {
+	if (data != NULL)
+		munmap(data, dataSize);
+	data = NULL;
+	dataSize = 0;
+	rows = cols = days = 0;
+}
+
+// method to map the specified cube file (replacing any file mapped before)
+// error message is returned if the file can't be mapped or isn't a valid cube, otherwise if all is well "Success!" is returned
+errormsg ClimateCube::open(std::string fileName) {
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return "Error: could not open the climate cube " + fileName;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < HEADER_SIZE) {
+		::close(fd);
+		return "Error: " + fileName + " is too short to be a climate cube";
+	}
+
+	void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // (the mapping stays valid)
+	if (mapped == MAP_FAILED)
+		return "Error: could not map the climate cube " + fileName;
+
+	// read the header
+	const char *bytes = (const char *) mapped;
+	int32_t header[4];
+	memcpy(header, bytes + 8, sizeof(header));
+	size_t numCells = (size_t) header[0] * header[1];
+	size_t expectedSize = HEADER_SIZE + getCellSectionSize(numCells) + numCells * header[2] * header[3];
+
+	bool valid = memcmp(bytes, MAGIC, 8) == 0 && header[0] >= 0 && header[1] >= 0 && header[2] >= 0 && (header[3] == 4 || header[3] == 8) && info.st_size == expectedSize;
+
+	// the series of each cell has to fit in its slot of the payload (days values)
+	const int32_t *cellDays = valid ? (const int32_t *) (bytes + HEADER_SIZE + 2 * numCells * sizeof(double)) : NULL;
+	for (size_t i = 0; valid && i < numCells; i ++)
+		valid = cellDays[i] >= 0 && cellDays[i] <= header[2];
+
+	if (!valid) {
+		munmap(mapped, info.st_size);
+		return "Error: " + fileName + " is not a valid climate cube";
+	}
+
+	data = mapped;
+	dataSize = info.st_size;
+	rows = header[0];
+	cols = header[1];
+	days = header[2];
+	valueSize = header[3];
+
+	const char *cells = bytes + HEADER_SIZE;
+	latitudes = (const double *) cells;
+	longitudes = latitudes + numCells;
+	numDays = (const int32_t *) (longitudes + numCells);
+	nanMask = (const unsigned char *) (numDays + numCells);
+	payload = cells + getCellSectionSize(numCells);
+
+	madvise(data, dataSize, MADV_WILLNEED); // (the whole cube is used in a run)
+
+	return "Success!";
+}
+
+// method to get a view of the temperatures of the specified cell (numbered row by row), in place in the mapped file
+TemperatureSeries ClimateCube::getSeries(int cell) const {
+	const char *values = payload + (size_t) cell * days * valueSize;
+	if (valueSize == 4)
+		return TemperatureSeries((const float *) values, numDays[cell]);
+	return TemperatureSeries((const double *) values, numDays[cell]);
+}
+
+// method to write a cube file with the specified temperatures, latitudes and longitudes of each cell (numbered row by row)
+// the temperatures are stored as float32 if singlePrecision is true (half the size, and plenty for temperatures), otherwise float64
+// error message is returned if the file can't be written, otherwise if all is well "Success!" is returned
+errormsg ClimateCube::write(std::string fileName, int rows, int cols, const std::vector<std::vector<double>> &temps, const std::vector<double> &latitudes, const std::vector<double> &longitudes, bool singlePrecision) {
+	size_t numCells = (size_t) rows * cols;
+	if (temps.size() != numCells || latitudes.size() != numCells || longitudes.size() != numCells)
+		return "Error: the climate cube needs temperatures, a latitude and a longitude for every cell";
+	if (numCells == 0)
+		return "Error: the climate cube needs at least one cell";
+
+	int32_t header[4] = {rows, cols, 0, singlePrecision ? 4 : 8};
+	for (size_t i = 0; i < numCells; i ++) {
+		if (temps[i].size() > header[2])
+			header[2] = temps[i].size();
+	}
+
+	std::ofstream fileOut(fileName.c_str(), std::ios::binary);
+	if (!fileOut)
+		return "Error: could not write the climate cube " + fileName;
+
+	fileOut.write(MAGIC, 8);
+	fileOut.write((const char *) header, sizeof(header));
+
+	// per-cell section
+	fileOut.write((const char *) &latitudes[0], numCells * sizeof(double));
+	fileOut.write((const char *) &longitudes[0], numCells * sizeof(double));
+	for (size_t i = 0; i < numCells; i ++) {
+		int32_t length = temps[i].size();
+		fileOut.write((const char *) &length, sizeof(length));
+	}
+	for (size_t i = 0; i < numCells; i ++) {
+		unsigned char hasNan = 0;
+		for (int d = 0; d < temps[i].size(); d ++) {
+			if (temps[i][d] != temps[i][d])
+				hasNan = 1;
+		}
+		fileOut.put(hasNan);
+	}
+	for (size_t i = numCells * (2 * sizeof(double) + sizeof(int32_t) + 1); i < getCellSectionSize(numCells); i ++)
+		fileOut.put(0);
+
+	// payload (each cell padded to the longest series)
+	for (size_t i = 0; i < numCells; i ++) {
+		for (int d = 0; d < header[2]; d ++) {
+			double value = d < temps[i].size() ? temps[i][d] : 0;
+			if (singlePrecision) {
+				float single = value;
+				fileOut.write((const char *) &single, sizeof(single));
+			} else
+				fileOut.write((const char *) &value, sizeof(value));
+		}
+	}
+
+	if (!fileOut)
+		return "Error: could not write the climate cube " + fileName;
+	return "Success!";
+}
@@ -0,0 +1,102 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef CLIMATE_CUBE_H
+#define CLIMATE_CUBE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Parameters.h"
+
+/*
+
+	Header file for ClimateCube.cpp.  Contains the TemperatureSeries struct and the ClimateCube class
+	definitions, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+
+/*
+	This struct is a view of the per-day temperatures of a cell (it doesn't own them): either a vector of
+	doubles (i.e. read from a text file), or the cell's values in a ClimateCube, which may be floats.
+*/
+struct TemperatureSeries {
+
+	const double *doubles;
+	const float *floats; // (only one of these is set)
+	int length; // number of days
+
+	TemperatureSeries() : doubles(NULL), floats(NULL), length(0) {}
+	TemperatureSeries(const std::vector<double> &values) : doubles(values.size() > 0 ? &values[0] : NULL), floats(NULL), length(values.size()) {}
+	TemperatureSeries(const double *values, int length1) : doubles(values), floats(NULL), length(length1) {}
+	TemperatureSeries(const float *values, int length1) : doubles(NULL), floats(values), length(length1) {}
+
+	int size() const { return length; }
+	double operator[](int day) const { return floats ? floats[day] : doubles[day]; }
+
+};
+
+
+/*
+	This class describes a ClimateCube object, which is a packed binary file of the temperatures of every cell
+	of a grid, memory-mapped so the cells' temperatures can be used in place (instead of reading and parsing a
+	text file per cell on every run).  Cubes are made from the text files with the convertClimate tool.
+
+	The file layout (in the byte order of the machine that wrote it) is:
+		header: "SWDCUBE1", then int32 rows, cols, days (the longest series) and valueSize (4 for float32, 8 for float64)
+		per cell (row by row): float64 latitudes, float64 longitudes, int32 number of days, uint8 NaN mask (1 if the
+		cell has any NaN temperatures), then padding to 8 bytes
+		payload: the temperatures of each cell (row by row), days values per cell (after the cell's own number of days,
+		the values are padding)
+*/
+class ClimateCube {
+
+	void *data; // the mapped file
+	size_t dataSize;
+
+	int rows, cols, days, valueSize;
+	const double *latitudes;
+	const double *longitudes;
+	const int32_t *numDays;
+	const unsigned char *nanMask;
+	const char *payload;
+
+	void close();
+
+public:
+
+	static const char MAGIC[9];
+
+	ClimateCube();
+	~ClimateCube();
+
+	// (the mapping is owned by the cube, so it can't be copied)
+	ClimateCube(const ClimateCube&) = delete;
+	ClimateCube& operator=(const ClimateCube&) = delete;
+
+	errormsg open(std::string fileName);
+	static errormsg write(std::string fileName, int rows, int cols, const std::vector<std::vector<double>> &temps, const std::vector<double> &latitudes, const std::vector<double> &longitudes, bool singlePrecision);
+
+	// accessors (the cells are numbered row by row)
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	int getDays() const { return days; }
+	int getValueSize() const { return valueSize; }
+	double getLatitude(int cell) const { return latitudes[cell]; }
+	double getLongitude(int cell) const { return longitudes[cell]; }
+	int getNumDays(int cell) const { return numDays[cell]; }
+	bool hasNan(int cell) const { return nanMask[cell] != 0; }
+	TemperatureSeries getSeries(int cell) const;
+
+};
+
+#endif
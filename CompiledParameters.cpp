@@ -0,0 +1,69 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "CompiledParameters.h"
+
+/*
+
+	Implementation of the CompiledParameters struct methods.  The struct definition
+	and description are included in the CompiledParameters header file.
+
+*/
+
+// no argument constructor -- compiles the default parameters
+CompiledParameters::CompiledParameters() {
+	compile(Parameters());
+}
+
+// constructor compiling the (already validated) parameters passed in
+CompiledParameters::CompiledParameters(const Parameters &params) {
+	compile(params);
+}
+
+// method to flatten the parameters object passed in into the index-addressed arrays
+// this does all the string lookups once, so the model never has to do them per timestep
+void CompiledParameters::compile(const Parameters &params) {
+
+	for (int i = 0; i < NUM_STAGES; i ++) {
+		std::string stage = params.getStage(i);
+
+		initial[i] = params.getParameter("initial " + stage);
+		mortalityMax[i] = params.getParameter(stage + " mortality max");
+		mortalityMinTemp[i] = params.getParameter(stage + " mortality min temp");
+		mortalityMaxTemp[i] = params.getParameter(stage + " mortality max temp");
+		mortalityTau[i] = params.getParameter(stage + " mortality tau");
+		mortalityPred[i] = params.getParameter(stage + " mortality due to predation");
+
+		std::vector<double> betas = params.getMortBetas(stage);
+		for (int j = 0; j < NUM_MORT_BETAS; j ++)
+			mortalityBetas[i][j] = betas[j];
+	}
+
+	std::vector<double> devMaxes = params.getArrayParameters("development max");
+	for (int i = 0; i < NUM_DEV_STAGES; i ++)
+		developmentMax[i] = devMaxes[i];
+
+	std::vector<double> eggViabilities = params.getArrayParameters("egg viability");
+	for (int i = 0; i < NUM_FEMALE_STAGES; i ++)
+		eggViability[i] = eggViabilities[i];
+
+	fruitN = params.getParameter("fruit n");
+	fruitM = params.getParameter("fruit m");
+	fruitTimeLag = params.getParameter("fruit time lag");
+	fruitBaseTemp = params.getParameter("fruit base temp");
+	fruitGtMultiplier = params.getParameter("fruit gt multiplier");
+	fruitHarvestCutoff = params.getParameter("fruit harvest cutoff");
+	fruitHarvestDrop = params.getParameter("fruit harvest drop");
+
+	diapauseCriticalTemp = params.getParameter("diapause critical temp");
+	diapauseDaylightHours = params.getParameter("diapause daylight hours");
+
+	maleProportion = params.getParameter("male proportion");
+	latitude = params.getParameter("latitude");
+	fertilityTmax = params.getParameter("fertility tmax");
+	constantTemp = params.getParameter("constant temp");
+}
@@ -0,0 +1,70 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef COMPILED_PARAMETERS_H
+#define COMPILED_PARAMETERS_H
+
+#include "Parameters.h"
+
+/*
+
+	This struct is a "compiled" version of a Parameters object, for use in the
+	integration hot path.  The Parameters object stays the user-facing layer (reading
+	config files, editing and validating parameters by name); once the parameters are
+	set, they are flattened into this struct so that the model code can read every
+	coefficient by stage index instead of building strings and searching the map.
+
+	Stage indices are the same as everywhere else in the model:
+	0-eggs, 1-instar1, 2-instar2, 3-instar3, 4-pupae, 5-males, 6..12-females1..females7
+	Development parameters only exist for the 11 stages that develop (i.e. not males
+	or females7), so they are indexed 0-4 for eggs..pupae and 5-10 for females1..females6
+	(this is the same order as Parameters::getArrayParameters("development max")).
+
+	The struct should be treated as immutable - it is rebuilt from the Parameters
+	object whenever the parameters change (see SWDCellSingle).
+
+	Methods described in the implementation file, CompiledParameters.cpp.
+
+*/
+
+struct CompiledParameters {
+
+	static const int NUM_STAGES = 13; // all lifestages
+	static const int NUM_DEV_STAGES = 11; // lifestages with a development rate
+	static const int NUM_FEMALE_STAGES = 7; // female lifestages
+	static const int NUM_MORT_BETAS = 4; // beta0..beta3 in the mortality equation
+
+	// stage-specific parameters
+	double initial[NUM_STAGES]; // initial populations
+	double mortalityMax[NUM_STAGES];
+	double mortalityMinTemp[NUM_STAGES];
+	double mortalityMaxTemp[NUM_STAGES];
+	double mortalityTau[NUM_STAGES];
+	double mortalityBetas[NUM_STAGES][NUM_MORT_BETAS];
+	double mortalityPred[NUM_STAGES]; // mortality due to predation
+	double developmentMax[NUM_DEV_STAGES];
+	double eggViability[NUM_FEMALE_STAGES];
+
+	// fruit parameters
+	double fruitN, fruitM, fruitTimeLag, fruitBaseTemp, fruitGtMultiplier, fruitHarvestCutoff, fruitHarvestDrop;
+
+	// diapause parameters
+	double diapauseCriticalTemp, diapauseDaylightHours;
+
+	// general parameters
+	double maleProportion, latitude, fertilityTmax, constantTemp;
+
+	CompiledParameters();
+	CompiledParameters(const Parameters &params);
+
+	void compile(const Parameters &params);
+
+};
+
+#endif
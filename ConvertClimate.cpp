@@ -0,0 +1,70 @@
+#include "ClimateCube.h"
+#include "TemperatureFile.h"
+#include "UtilityMethods.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+
+	This file is a tool to convert a grid of per-cell temperature text files (as read by the multicell
+	simulator) into a single packed binary climate cube (see ClimateCube.h), which the simulator can
+	memory-map instead (see SWDSimulatorMulti::useClimateCube).
+	Run the conversion as follows:
+
+	First, compile the tool.  Call it using:
+
+	./convertClimate rows cols filePattern cubeFileName [float64|float32] [firstLat latStep firstLon lonStep]
+
+	rows, cols = size of the grid
+	filePattern = name of the temperature file of each cell, where {row} and {col} are replaced with the
+	              row and column of the cell (starting at 1), i.e. TEMP_rcp85/model_rcp8.5_2060_lat{row}_lon{col}.txt
+	cubeFileName = destination file for the cube
+	float64|float32 = (optional) precision of the stored temperatures: float64 (default) gives exactly the
+	                  same simulation as the text files, float32 halves the size of the cube
+	firstLat latStep firstLon lonStep = (optional) latitude and longitude of the first cell, and the steps
+	                                    between rows/cols (default 24.5 1 0 1, as in MultiCellRCP.cpp)
+
+	Missing files are stored as cells with no temperatures (which aren't simulated, as with the text files).
+
+*/
+
+// main method to run the tool; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	if (argc != 5 && argc != 6 && argc != 10) {
+		printf("Error, exiting now\nUsage: ./convertClimate rows cols filePattern cubeFileName [float64|float32] [firstLat latStep firstLon lonStep]");
+		printf("\n\nNote that: {row} and {col} in filePattern are replaced with the row and column of each cell (starting at 1).\n");
+		exit(0);
+	}
+
+	int rows = atoi(argv[1]);
+	int cols = atoi(argv[2]);
+	std::string filePattern = argv[3];
+	std::string cubeFileName = argv[4];
+	bool singlePrecision = (argc >= 6 && std::string(argv[5]) == "float32");
+
+	double firstLat = 24.5, latStep = 1, firstLon = 0, lonStep = 1;
+	if (argc == 10) {
+		firstLat = atof(argv[6]);
+		latStep = atof(argv[7]);
+		firstLon = atof(argv[8]);
+		lonStep = atof(argv[9]);
+	}
+
+	std::vector<std::vector<double>> temps(rows * cols);
+	std::vector<double> latitudes(rows * cols), longitudes(rows * cols);
+	for (int r = 0; r < rows; r ++) {
+		for (int c = 0; c < cols; c ++) {
+			std::string fileName = replaceAll(replaceAll(filePattern, "{row}", r + 1), "{col}", c + 1);
+			readTemperatureFile(fileName, temps[r * cols + c]); // (parsed the same way as in the simulator)
+			latitudes[r * cols + c] = firstLat + r * latStep;
+			longitudes[r * cols + c] = firstLon + c * lonStep;
+		}
+	}
+
+	errormsg status = ClimateCube::write(cubeFileName, rows, cols, temps, latitudes, longitudes, singlePrecision);
+	std::cout << status << "\n";
+
+	return status.compare("Success!") == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include "SWDEnsemble.h"
+#include "TemperatureFile.h"
+
+/*
+
+	This file is a runner for an ensemble of singlecell simulations with different parameters (i.e. a
+	sensitivity study), all run in one process (see SWDEnsemble.h).
+	It takes in command line arguments to run the ensemble.
+	Run the ensemble as follows:
+
+	First, compile the model.  Call it using:
+
+	./ensembleSim useDefault paramFileName tempFileName variantsFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop [numThreads] [integrator]
+
+	useDefault = [0|1] 1 to start every variant from the default parameters, 0 to read them from paramFileName
+	paramFileName = the extended parameters list every variant starts from.  Usually configparams.txt
+	tempFileName = a file with 365 single line entries of temperatures (read once, for all the variants)
+	variantsFileName = CSV file of the variants: a header line with the names of the parameters to vary
+	                   (i.e. "initial females1, latitude"), then one line per variant with their values
+	ignoreFruit = [0|1] 0, use the fruit model, 1 ignore the fruit model
+	ignoreDiapause = [0|1] 0, use the diapause model, 1 ignore the diapause model
+	outputFileName = destination CSV file for the summaries (one line per variant)
+	addFliesDate = 0-364 for fly introduction date, -1 to use diapause termination date
+	startingFemPop = number of initial fecund females (> 0), unless a variant sets "initial females1"
+	numThreads = (optional) number of variants run at once, 0 for one per hardware thread (the default)
+	integrator = (optional) euler (default), exponential or rk45 (see IntegratorMode in SWDCellSingle.h)
+
+	To skip parsing the temperature file on repeated runs, set the environment variable SWD_TEMPERATURE_CACHE to
+	a directory to cache the parsed temperatures in (see TemperatureFile.h).
+
+	The output has a line per variant with: the number of the variant, its values of the varied parameters,
+	the total cumulative population, peak population and peak population day of each stage, the day diapause
+	was crossed and the day of max fruit quality (see SWDEnsemble::getSummaryNames).
+
+*/
+
+// main method to run the code; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	if ( argc < 10 || argc > 12)
+	{
+		printf( "Error, exiting now\nUsage: ./ensembleSim useDefault paramFileName tempFileName variantsFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop [numThreads] [euler|exponential|rk45]");
+		printf( "\n\nNote that: useDefault, ignoreFruit, ignoreDiapause are bools (0 = false)\nNote also that: addFliesDate as -1 specifies to add the flies on diapause cross date.\n");
+		exit( 0);
+	}
+
+	// read in all the arguments
+	std::stringstream sstm;
+	sstm << argv[1] << " " << argv[5] << " " << argv[ 6] << " " << argv[ 8] << " " << argv[ 9]; // need all the numbers saved here
+
+	int runTime = 360; // run simulation for a year
+
+	std::string inputFileName = argv[ 2];
+	std::string tempFileName = argv[ 3];
+	std::string variantsFileName = argv[ 4];
+	std::string outputFileName = argv[ 7];
+
+	bool useDefault;
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDate;
+	double startFemPop;
+
+	sstm >> useDefault;
+	sstm >> ignoreFruit;
+	sstm >> ignoreDiapause;
+	sstm >> startDate;
+	sstm >> startFemPop;
+
+	int numThreads = ( argc >= 11) ? atoi( argv[ 10]) : 0;
+	IntegratorMode integrator = EULER_INTEGRATOR;
+	if ( argc == 12 && !parseIntegratorMode( argv[ 11], integrator))
+	{
+		printf( "Error: unknown integrator %s (use euler, exponential or rk45)\n", argv[ 11]);
+		exit( 1);
+	}
+
+	// read the parameters every variant starts from (once)
+	Parameters params;
+	if ( useDefault == 0)
+		params.setConfigParams( inputFileName);
+	params.setParameter( "initial females1", startFemPop);
+
+	// read temperatures in from file (through the parsed temperatures cache, if SWD_TEMPERATURE_CACHE is set)
+	const char* cacheDirectory = getenv( "SWD_TEMPERATURE_CACHE");
+	if ( cacheDirectory != NULL)
+		setTemperatureCache( cacheDirectory);
+
+	std::vector< double> temperatures;
+	readTemperatureFile( tempFileName, temperatures);
+	if ( temperatures.size() == 0)
+	{
+		printf( "Error: could not read the temperature file %s\n", tempFileName.c_str());
+		exit( 1);
+	}
+
+	// set up and run the ensemble
+	SWDEnsemble ensemble( params, temperatures);
+
+	errormsg status = ensemble.loadVariants( variantsFileName);
+	if ( status.compare( "Success!") != 0)
+	{
+		printf( "%s\n", status.c_str());
+		exit( 1);
+	}
+
+	ensemble.setNumThreads( numThreads);
+	ensemble.setIntegrator( integrator); // (the exponential and Runge-Kutta integrators also set dt to 1)
+
+	ensemble.run( runTime, ignoreFruit, ignoreDiapause, startDate);
+
+	status = ensemble.printSummaries( outputFileName); // print the summary of every variant to the output file
+	if ( status.compare( "Success!") != 0)
+	{
+		printf( "%s\n", status.c_str());
+		exit( 1);
+	}
+
+	return 0;
+}
@@ -12,7 +12,7 @@
 */
 
 // method to solve for the number of eggs given the values for the previous timestep.
-double obtainEggs(double fertility, std::vector<double> eggViabilities, std::vector<double> femStagePopulations, double eggsI, 
+double obtainEggs(double fertility, const double eggViabilities[], const double femStagePopulations[], double eggsI, 
 											double eggMortalityNat, double eggMortalityPred, double eggDevelopment, double step) {
 	double dE_dt = 0;
 	for (int i = 0; i < 7; i ++)
@@ -71,11 +71,11 @@ double obtainFemalesX(double maleProportion, double stageX_1Development, double
 
 // method to solve for the fruit quality given the values for the previous timestep
 // fruit quality is also modelled by a differential equation, as given in the model
-double obtainFruitQuality(double gt, double fruitQualityI, double fruitQLag, double step, Parameters& params) {
+double obtainFruitQuality(double gt, double fruitQualityI, double fruitQLag, double step, const CompiledParameters& params) {
 	
-	double fruitHarvestCutoff = params.getParameter("fruit harvest cutoff");
-	double fruitHarvestDrop = params.getParameter("fruit harvest drop");
-	double gtMultiplier = params.getParameter("fruit gt multiplier");
+	double fruitHarvestCutoff = params.fruitHarvestCutoff;
+	double fruitHarvestDrop = params.fruitHarvestDrop;
+	double gtMultiplier = params.fruitGtMultiplier;
 	
 	double fruitHarvest = 0;
 	if (fruitQLag > fruitHarvestCutoff) // if the fruit quality lag steps ago if above the cutoff, harvest the drop
@@ -1,7 +1,7 @@
 #ifndef EULERS_METHOD_H
 #define EULERS_METHOD_H
 
-#include "Parameters.h"
+#include "CompiledParameters.h"
 
 /**
 
@@ -11,7 +11,7 @@
 
 */
 
-double obtainEggs(double fertility, std::vector<double> eggViabilities, std::vector<double> femStagePopulations, double eggsI, 
+double obtainEggs(double fertility, const double eggViabilities[], const double femStagePopulations[], double eggsI, 
 											double eggMortalityNat, double eggMortalityPred, double eggDevelopment, double step);
 
 
@@ -30,7 +30,7 @@ double obtainFemalesX(double maleProportion, double stageX_1Development, double
 									double femalesXMortalityPred, double femalesXDevelopment, double femalesXI, double step);
 
 
-double obtainFruitQuality(double gt, double fruitQualityI, double fruitQLag, double step, Parameters& params);
+double obtainFruitQuality(double gt, double fruitQualityI, double fruitQLag, double step, const CompiledParameters& params);
 
 
 #endif
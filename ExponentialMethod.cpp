@@ -0,0 +1,159 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "ExponentialMethod.h"
+
+/**
+
+	This file contains the exact solutions of the model's differential equations over one step,
+	for when the rates are constant over the step.  Since the temperature is given daily, all the
+	rates are constant over a day (except for the effect of the fruit quality, which changes slowly),
+	so a whole day can be done in one step instead of the 20 steps of Euler's method.
+
+	Stage populations: the 13 stage equations (see EulersMethod.cpp) are linear with constant
+	coefficients, i.e. dP/dt = A * P, so P(t + step) = exp(A * step) * P(t).  A is almost lower
+	triangular (each stage only gains from the stage before it), except for the eggs which gain
+	from all the female stages.  Instead of building the 13x13 exponential, the product
+	exp(A * step) * P is summed directly as a Taylor series (A is applied with its sparse structure),
+	over enough substeps that the series converges quickly.  The integral of P over the step (for
+	the cumulative populations) is summed from the same terms.
+
+	Fruit quality: dF/dt = F * (gtMultiplier / gt - harvest), which is exactly exponential growth
+	(or decay) with a constant rate.
+
+*/
+
+const int EXACT_MAX_TERMS = 40; // max Taylor terms per substep (the terms are negligible long before this)
+const double EXACT_TOLERANCE = 1E-17; // relative size of the last Taylor term summed
+
+// method to compute A * y (i.e. dP/dt for populations y) for the stage equations
+// loss[i] is the total loss rate of stage i, and stage i gains gain[i] * y[source[i]] (except eggs,
+// which gain eggGain[j] * y[j + 6] from every female stage j)
+static void applyStageMatrix(const double loss[], const double gain[], const int source[], const double eggGain[], const double y[], double out[]) {
+	out[0] = -loss[0] * y[0];
+	for (int j = 0; j < CompiledParameters::NUM_FEMALE_STAGES; j ++)
+		out[0] += eggGain[j] * y[j + 6];
+	for (int i = 1; i < CompiledParameters::NUM_STAGES; i ++)
+		out[i] = gain[i] * y[source[i]] - loss[i] * y[i];
+}
+
+// method to solve for the populations of all the stages after one step, given the (constant) rates
+// stages holds the populations at the beginning of the step, in stage index order, and is updated in place
+// stageIntegrals is set to the integral of each population over the step
+// the rates are the same as those passed to the Euler's method solutions (see SWDPopulation::applyStepRates)
+void obtainStagesExact(double fertility, const double devRate[], const double mortalityNat[], const CompiledParameters& params,
+								double stages[], double stageIntegrals[], double step) {
+	const int N = CompiledParameters::NUM_STAGES;
+	const double* mortalityPred = params.mortalityPred;
+	double maleProportion = params.maleProportion;
+
+	double loss[N], gain[N], eggGain[CompiledParameters::NUM_FEMALE_STAGES];
+	int source[N];
+
+	// losses (mortality and development out of the stage)
+	for (int i = 0; i < N; i ++)
+		loss[i] = mortalityNat[i] + mortalityPred[i];
+	for (int i = 0; i < 5; i ++) // eggs .. pupae
+		loss[i] += devRate[i];
+	for (int i = 6; i < N - 1; i ++) // females1 .. females6 (no development for males or females7)
+		loss[i] += devRate[i - 1];
+
+	// gains (development into the stage)
+	gain[0] = 0;
+	source[0] = 0;
+	for (int i = 1; i < 5; i ++) { // instars and pupae
+		gain[i] = devRate[i - 1];
+		source[i] = i - 1;
+	}
+	gain[5] = maleProportion * devRate[4]; // males, from pupae
+	source[5] = 4;
+	gain[6] = (1 - maleProportion) * devRate[4]; // females1, from pupae
+	source[6] = 4;
+	for (int i = 7; i < N; i ++) { // females2 .. females7, from the previous female stage
+		gain[i] = devRate[i - 2];
+		source[i] = i - 1;
+	}
+	for (int j = 0; j < CompiledParameters::NUM_FEMALE_STAGES; j ++)
+		eggGain[j] = fertility * params.eggViability[j];
+
+	// number of substeps: enough that the norm of A * substep is at most 1
+	double norm = 0; // max column sum of A
+	for (int j = 0; j < N; j ++) {
+		double colSum = std::fabs(loss[j]);
+		for (int i = 1; i < N; i ++)
+			if (source[i] == j)
+				colSum += std::fabs(gain[i]);
+		if (j >= 6)
+			colSum += std::fabs(eggGain[j - 6]);
+		if (colSum > norm)
+			norm = colSum;
+	}
+	int numSubsteps = 1;
+	if (norm * step > 1 && norm * step < 1E6) // (if the rates are NaN or absurd, the result is nonsense either way)
+		numSubsteps = (int) std::ceil(norm * step);
+	double h = step / numSubsteps;
+
+	double term[N], next[N];
+	for (int i = 0; i < N; i ++)
+		stageIntegrals[i] = 0;
+
+	for (int s = 0; s < numSubsteps; s ++) {
+		// sum exp(A h) y = sum_k (A h)^k y / k!, and its integral sum_k h (A h)^k y / (k + 1)!
+		for (int i = 0; i < N; i ++) {
+			term[i] = stages[i];
+			stageIntegrals[i] += h * stages[i];
+		}
+
+		for (int k = 1; k <= EXACT_MAX_TERMS; k ++) {
+			applyStageMatrix(loss, gain, source, eggGain, term, next);
+
+			double maxTerm = 0, maxSum = 0;
+			for (int i = 0; i < N; i ++) {
+				term[i] = next[i] * (h / k);
+				stages[i] += term[i];
+				stageIntegrals[i] += term[i] * (h / (k + 1));
+
+				maxTerm = std::max(maxTerm, std::fabs(term[i]));
+				maxSum = std::max(maxSum, std::fabs(stages[i]));
+			}
+
+			if (!(maxTerm > EXACT_TOLERANCE * maxSum)) // converged (or NaN)
+				break;
+		}
+	}
+
+	// the exact solution never goes negative, but the rounding of the sums can
+	for (int i = 0; i < N; i ++) {
+		if (stages[i] < 0)
+			stages[i] = 0;
+		if (stageIntegrals[i] < 0)
+			stageIntegrals[i] = 0;
+	}
+}
+
+// method to solve for the fruit quality after one step, given the fruit quality at the beginning of the step
+// this is the exact solution of the fruit quality equation in obtainFruitQuality (EulersMethod.cpp)
+// since the fruit quality only grows or decays over a step, clamping it at the end is the same as clamping it as it goes
+double obtainFruitQualityExact(double gt, double fruitQualityI, double fruitQLag, double step, const CompiledParameters& params) {
+
+	double fruitHarvest = 0;
+	if (fruitQLag > params.fruitHarvestCutoff) // if the fruit quality lag steps ago if above the cutoff, harvest the drop
+		fruitHarvest = params.fruitHarvestDrop;
+	double growthRate = params.fruitGtMultiplier / gt - fruitHarvest;
+
+	if (gt != gt) // if the gt multiplier is NaN, then treat it as 0
+		growthRate = -fruitHarvest;
+
+	double fruitDiam = fruitQualityI * std::exp(growthRate * step);
+
+	if (fruitDiam < 0.05) // min fruit quality is 0.05
+		fruitDiam = 0.05;
+	if (fruitDiam > 1) // max fruit quality is 1
+		fruitDiam = 1;
+
+	return fruitDiam;
+}
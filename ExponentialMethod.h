@@ -0,0 +1,31 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef EXPONENTIAL_METHOD_H
+#define EXPONENTIAL_METHOD_H
+
+#include <cmath>
+#include <algorithm>
+#include "CompiledParameters.h"
+
+/**
+
+	Header file for the ExponentialMethod.cpp methods.
+	These are the exact (matrix exponential) counterparts of the Euler's method solutions in
+	EulersMethod.h.  Refer to the commenting and implementation in ExponentialMethod.cpp for
+	explanations of what these methods do.
+
+*/
+
+double obtainFruitQualityExact(double gt, double fruitQualityI, double fruitQLag, double step, const CompiledParameters& params);
+
+void obtainStagesExact(double fertility, const double devRate[], const double mortalityNat[], const CompiledParameters& params,
+								double stages[], double stageIntegrals[], double step);
+
+#endif
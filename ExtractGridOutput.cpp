@@ -0,0 +1,76 @@
+#include "GridOutputFile.h"
+#include "UtilityMethods.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+
+	This file is a tool to reproduce the per-cell data and summary text files of a multicell run from the
+	single grid output file it was printed to (see GridOutputFile.h and SWDSimulatorMulti::useGridOutput).
+	The files are byte for byte the same as the simulator would have printed without the grid output file.
+	Run the extraction as follows:
+
+	First, compile the tool.  Call it using:
+
+	./extractGridOutput gridFile dataPattern summaryPattern [row col]
+
+	gridFile = grid output file written by the simulator
+	dataPattern, summaryPattern = names of the data file and summary file of each cell, where {row} and {col} are
+	                              replaced with the row and column of the cell (starting at 1), i.e.
+	                              DATA/output_model_rcp8.5_2060_lat{row}_lon{col}.txt (use - for dataPattern to skip
+	                              the data files)
+	row col = (optional) only extract the cell at this row and column (starting at 1), otherwise every cell with
+	          output is extracted
+
+*/
+
+// main method to run the tool; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	if (argc != 4 && argc != 6) {
+		printf("Error, exiting now\nUsage: ./extractGridOutput gridFile dataPattern summaryPattern [row col]");
+		printf("\n\nNote that: {row} and {col} in the patterns are replaced with the row and column of each cell (starting at 1).\n");
+		exit(0);
+	}
+
+	std::string dataPattern = argv[2];
+	std::string summaryPattern = argv[3];
+	if (dataPattern.compare("-") == 0)
+		dataPattern = "";
+
+	GridOutputReader reader;
+	errormsg status = reader.open(argv[1]);
+	if (status.compare("Success!") != 0) {
+		std::cout << status << "\n";
+		return 1;
+	}
+
+	int firstCell = 0, lastCell = reader.getRows() * reader.getCols() - 1;
+	if (argc == 6) {
+		int r = atoi(argv[4]) - 1, c = atoi(argv[5]) - 1;
+		if (r < 0 || r >= reader.getRows() || c < 0 || c >= reader.getCols()) {
+			std::cout << "Error: the grid is only " << reader.getRows() << "x" << reader.getCols() << "\n";
+			return 1;
+		}
+		firstCell = lastCell = r * reader.getCols() + c;
+	}
+
+	int numExtracted = 0;
+	for (int i = firstCell; i <= lastCell; i ++) {
+		if (!reader.hasCell(i))
+			continue;
+		int r = i / reader.getCols(), c = i % reader.getCols();
+		std::string dataFile = replaceAll(replaceAll(dataPattern, "{row}", r + 1), "{col}", c + 1);
+		std::string summaryFile = replaceAll(replaceAll(summaryPattern, "{row}", r + 1), "{col}", c + 1);
+		status = reader.extractCell(i, dataFile, summaryFile);
+		if (status.compare("Success!") != 0) {
+			std::cout << status << "\n";
+			return 1;
+		}
+		numExtracted ++;
+	}
+
+	std::cout << "Extracted " << numExtracted << " cells\n";
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include "ResultsFile.h"
+#include "TextBuffer.h"
+#include "UtilityMethods.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+
+	This file is a tool to extract the daily series of the cells of a multicell run from the binary results file
+	they were written to (see ResultsFile.h and SWDSimulatorMulti::useResultsFile) to CSV files, one per cell.
+	Each CSV file has a header line with the names of the columns (time, each life stage, fruit quality), then one
+	line per day of the cell's series.
+	Run the extraction as follows:
+
+	First, compile the tool.  Call it using:
+
+	./extractResults resultsFile csvPattern [row col] [firstDay lastDay]
+
+	resultsFile = results file written by the simulator
+	csvPattern = name of the CSV file of each cell, where {row} and {col} are replaced with the row and column of
+	             the cell (starting at 1), i.e. DATA/results_lat{row}_lon{col}.csv
+	row col = (optional) only extract the cell at this row and column (starting at 1), otherwise every cell with
+	          a series is extracted (use 0 0 for every cell, to give a range of days)
+	firstDay lastDay = (optional) only extract the days from firstDay up to (not including) lastDay, counted from
+	                   the start of each series (clipped to the days each cell has)
+
+*/
+
+// main method to run the tool; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	if (argc != 3 && argc != 5 && argc != 7) {
+		printf("Error, exiting now\nUsage: ./extractResults resultsFile csvPattern [row col] [firstDay lastDay]");
+		printf("\n\nNote that: {row} and {col} in the pattern are replaced with the row and column of each cell (starting at 1).\n");
+		exit(0);
+	}
+
+	std::string csvPattern = argv[2];
+
+	ResultsReader reader;
+	errormsg status = reader.open(argv[1]);
+	if (status.compare("Success!") != 0) {
+		std::cout << status << "\n";
+		return 1;
+	}
+
+	int firstCell = 0, lastCell = reader.getRows() * reader.getCols() - 1;
+	if (argc >= 5 && !(atoi(argv[3]) == 0 && atoi(argv[4]) == 0)) {
+		int r = atoi(argv[3]) - 1, c = atoi(argv[4]) - 1;
+		if (r < 0 || r >= reader.getRows() || c < 0 || c >= reader.getCols()) {
+			std::cout << "Error: the grid is only " << reader.getRows() << "x" << reader.getCols() << "\n";
+			return 1;
+		}
+		firstCell = lastCell = r * reader.getCols() + c;
+	}
+
+	int firstDay = 0, lastDay = -1; // (-1 for the whole series)
+	if (argc == 7) {
+		firstDay = atoi(argv[5]);
+		lastDay = atoi(argv[6]);
+	}
+
+	int numExtracted = 0;
+	std::vector<std::vector<double>> columns(reader.getNumColumns());
+	for (int i = firstCell; i <= lastCell; i ++) {
+		if (!reader.hasCell(i))
+			continue;
+
+		// read the range of days of every column (each is a contiguous run of values per chunk)
+		int cellLastDay = (lastDay < 0) ? reader.getNumDays(i) : lastDay;
+		for (int k = 0; k < columns.size(); k ++) {
+			columns[k].clear();
+			reader.getSeries(i, k, firstDay, cellLastDay, columns[k]);
+		}
+
+		TextBuffer fileOut;
+		for (int k = 0; k < columns.size(); k ++)
+			fileOut << (k > 0 ? "," : "") << reader.getColumnName(k);
+		fileOut << "\n";
+		int numDays = columns.size() > 0 ? columns[0].size() : 0;
+		for (int d = 0; d < numDays; d ++) {
+			for (int k = 0; k < columns.size(); k ++)
+				fileOut << (k > 0 ? "," : "") << columns[k][d];
+			fileOut << "\n";
+		}
+
+		int r = i / reader.getCols(), c = i % reader.getCols();
+		std::string csvFile = replaceAll(replaceAll(csvPattern, "{row}", r + 1), "{col}", c + 1);
+		if (!fileOut.writeFile(csvFile)) {
+			std::cout << "Error: could not write " << csvFile << "\n";
+			return 1;
+		}
+		numExtracted ++;
+	}
+
+	std::cout << "Extracted " << numExtracted << " cells\n";
+	return 0;
+}
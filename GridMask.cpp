@@ -0,0 +1,95 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "GridMask.h"
+#include <fstream>
+
+/*
+
+	Implementation of the GridMask class.  The class definition and description (with the mask file format)
+	are included in the GridMask header file.
+
+*/
+
+// constructor for a GridMask of the specified size, with every cell active
+GridMask::GridMask(int rows1, int cols1) {
+	setAll(rows1, cols1);
+}
+
+// method to make the mask the specified size, with every cell active
+void GridMask::setAll(int rows1, int cols1) {
+	rows = rows1;
+	cols = cols1;
+	active.assign(rows * cols, 1);
+	findActiveCells();
+}
+
+// method to make the specified cell (numbered row by row) active or masked
+void GridMask::setCell(int cell, bool isActive) {
+	active[cell] = isActive;
+	findActiveCells();
+}
+
+// method to rebuild the list of active cells from the per-cell flags
+void GridMask::findActiveCells() {
+	activeCells.clear();
+	for (int i = 0; i < active.size(); i ++) {
+		if (active[i])
+			activeCells.push_back(i);
+	}
+}
+
+// method to read the mask of a rows1 x cols1 grid from the specified mask file (see the class description)
+// error message is returned if the file can't be read or doesn't have a value for every cell (and the mask is left as it was),
+// otherwise if all is well "Success!" is returned
+errormsg GridMask::load(std::string fileName, int rows1, int cols1) {
+	std::ifstream infile(fileName);
+	if (!infile)
+		return "Error: could not open the mask file " + fileName;
+
+	std::vector<unsigned char> values;
+	int value;
+	while (infile >> value)
+		values.push_back(value != 0);
+
+	if (!infile.eof() || values.size() != rows1 * cols1)
+		return "Error: the mask file " + fileName + " doesn't have one 0 or 1 for each cell of the grid";
+
+	rows = rows1;
+	cols = cols1;
+	active = values;
+	findActiveCells();
+	return "Success!";
+}
+
+// method to write the mask to the specified mask file (see the class description)
+// error message is returned if the file can't be written, otherwise if all is well "Success!" is returned
+errormsg GridMask::write(std::string fileName) const {
+	std::ofstream fileOut(fileName);
+	for (int r = 0; r < rows; r ++) {
+		for (int c = 0; c < cols; c ++)
+			fileOut << (c > 0 ? " " : "") << (int) active[r * cols + c];
+		fileOut << "\n";
+	}
+	fileOut.close();
+
+	if (!fileOut)
+		return "Error: could not write the mask file " + fileName;
+	return "Success!";
+}
+
+// method to set the mask from a climate cube: the cells with NaN temperatures, or no temperatures at all (i.e. their
+// file was missing when the cube was made), are masked, since they wouldn't be simulated anyway
+// (this only reads the per-cell section of the cube, not the temperatures)
+void GridMask::setFromClimateCube(const ClimateCube &cube) {
+	rows = cube.getRows();
+	cols = cube.getCols();
+	active.resize(rows * cols);
+	for (int i = 0; i < active.size(); i ++)
+		active[i] = !cube.hasNan(i) && cube.getNumDays(i) > 0;
+	findActiveCells();
+}
@@ -0,0 +1,66 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef GRID_MASK_H
+#define GRID_MASK_H
+
+#include <vector>
+#include <string>
+#include "Parameters.h"
+#include "ClimateCube.h"
+
+/*
+
+	Header file for GridMask.cpp.  Contains the GridMask class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+
+/*
+	This class describes a GridMask object, which says which cells of a multicell grid are simulated (i.e. land
+	cells with temperature data), and which are masked out (ocean, or missing data).
+
+	The simulator only reads, sets up, schedules and runs the active cells, so it works through the list of
+	active cells (numbered row by row) rather than the whole grid; the masked cells just get placeholder output.
+
+	A mask can be read from a mask file, which has one line per row of the grid with one value per cell,
+	1 for an active cell and 0 for a masked one, separated by whitespace, i.e. for a 2x3 grid:
+		0 1 1
+		0 0 1
+	or taken from a climate cube (masking the cells with NaN temperatures, or no temperatures at all).
+*/
+class GridMask {
+
+	int rows, cols;
+	std::vector<unsigned char> active; // 1 for each active cell, 0 for each masked cell (row by row)
+	std::vector<int> activeCells; // numbers of the active cells, in order
+
+	void findActiveCells();
+
+public:
+
+	GridMask(int rows1 = 0, int cols1 = 0);
+
+	errormsg load(std::string fileName, int rows1, int cols1);
+	errormsg write(std::string fileName) const;
+	void setFromClimateCube(const ClimateCube &cube);
+	void setAll(int rows1, int cols1);
+	void setCell(int cell, bool isActive);
+
+	// accessors (the cells are numbered row by row)
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	bool isActive(int cell) const { return active[cell] != 0; }
+	int getNumActive() const { return activeCells.size(); }
+	int getActiveCell(int index) const { return activeCells[index]; }
+
+};
+
+#endif
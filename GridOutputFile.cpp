@@ -0,0 +1,225 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "GridOutputFile.h"
+#include "UtilityMethods.h"
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+
+	Implementation of the GridOutputWriter and GridOutputReader classes.  The class definitions and descriptions
+	(with the file layout) are included in the GridOutputFile header file.
+
+*/
+
+const char GridOutputWriter::MAGIC[9] = "SWDGRID1";
+const char GridOutputWriter::END_MAGIC[9] = "SWDGRIDX";
+
+static const size_t HEADER_SIZE = 8 + 2 * sizeof(int32_t);
+static const size_t FOOTER_SIZE = sizeof(int64_t) + 8;
+
+// constructor for a GridOutputWriter (with no file open)
+GridOutputWriter::GridOutputWriter() : fd(-1), rows(0), cols(0), offset(0), failed(false) {
+	pthread_mutex_init(&lock, NULL);
+}
+
+// destructor for the GridOutputWriter: finishes the file, if it is still open
+GridOutputWriter::~GridOutputWriter() {
+	close();
+	pthread_mutex_destroy(&lock);
+}
+
+// method to write the specified bytes at the end of the file (the lock must be held)
+// returns false if the write failed
+bool GridOutputWriter::writeAll(const char *bytes, size_t size) {
+	if (!writeFully(fd, bytes, size))
+		return false;
+	offset += size;
+	return true;
+}
+
+// method to start writing a grid output file for a rows1 x cols1 grid (replacing the file, if it exists)
+// error message is returned if the file can't be created, otherwise if all is well "Success!" is returned
+errormsg GridOutputWriter::open(std::string fileName1, int rows1, int cols1) {
+	close();
+
+	fd = ::open(fileName1.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return "Error: could not create the grid output file " + fileName1;
+
+	fileName = fileName1;
+	rows = rows1;
+	cols = cols1;
+	offset = 0;
+	index.assign(3 * (size_t) rows * cols, 0);
+	for (size_t i = 0; i < index.size(); i += 3)
+		index[i] = -1; // (no output yet)
+
+	int32_t header[2] = {rows, cols};
+	failed = !writeAll(MAGIC, 8) || !writeAll((const char *) header, sizeof(header));
+	return failed ? "Error: could not write the grid output file " + fileName : "Success!";
+}
+
+// method to append the output of the specified cell (numbered row by row): the text of its data file and of its
+// summary file (data is empty if there is no data file, i.e. in summary-only mode)
+void GridOutputWriter::writeCell(int cell, const std::string &data, const std::string &summary) {
+	writeCells(std::vector<int>(1, cell), data, summary);
+}
+
+// same as above, but the specified cells all have the same output, which is only written once (i.e. the placeholder
+// output of the masked cells)
+void GridOutputWriter::writeCells(const std::vector<int> &cells, const std::string &data, const std::string &summary) {
+	pthread_mutex_lock(&lock);
+	if (fd >= 0 && cells.size() > 0) {
+		int64_t start = offset;
+		if (!writeAll(data.data(), data.size()) || !writeAll(summary.data(), summary.size()))
+			failed = true;
+		for (int k = 0; k < cells.size(); k ++) {
+			index[3 * cells[k]] = start;
+			index[3 * cells[k] + 1] = data.size();
+			index[3 * cells[k] + 2] = summary.size();
+		}
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+// method to finish the file: the index and footer are written after the chunks (padded to 8 bytes), and the file is closed
+// error message is returned if any of the file couldn't be written, otherwise if all is well "Success!" is returned
+errormsg GridOutputWriter::close() {
+	if (fd < 0)
+		return "Success!";
+
+	const char padding[8] = {0};
+	if (!writeAll(padding, (8 - offset % 8) % 8)) // (so the index can be read in place)
+		failed = true;
+	int64_t indexOffset = offset;
+	if (index.size() > 0 && !writeAll((const char *) &index[0], index.size() * sizeof(int64_t)))
+		failed = true;
+	if (!writeAll((const char *) &indexOffset, sizeof(indexOffset)) || !writeAll(END_MAGIC, 8))
+		failed = true;
+	if (::close(fd) != 0)
+		failed = true;
+	fd = -1;
+
+	return failed ? "Error: could not write the grid output file " + fileName : "Success!";
+}
+
+// constructor for an (empty) GridOutputReader
+GridOutputReader::GridOutputReader() : data(NULL), dataSize(0), rows(0), cols(0), index(NULL) {}
+
+// destructor for the GridOutputReader: unmaps the file
+GridOutputReader::~GridOutputReader() {
+	close();
+}
+
+// method to unmap the file (if one is mapped)
+void GridOutputReader::close() {
+	if (data != NULL)
+		munmap(data, dataSize);
+	data = NULL;
+	dataSize = 0;
+	rows = cols = 0;
+	index = NULL;
+}
+
+// method to map the specified grid output file (replacing any file mapped before)
+// error message is returned if the file can't be mapped or isn't a valid (finished) grid output file, otherwise if
+// all is well "Success!" is returned
+errormsg GridOutputReader::open(std::string fileName) {
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return "Error: could not open the grid output file " + fileName;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < HEADER_SIZE + FOOTER_SIZE) {
+		::close(fd);
+		return "Error: " + fileName + " is too short to be a grid output file";
+	}
+
+	void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // (the mapping stays valid)
+	if (mapped == MAP_FAILED)
+		return "Error: could not map the grid output file " + fileName;
+
+	// read the header and footer
+	const char *bytes = (const char *) mapped;
+	size_t size = info.st_size;
+	int32_t header[2];
+	memcpy(header, bytes + 8, sizeof(header));
+	int64_t indexOffset;
+	memcpy(&indexOffset, bytes + size - FOOTER_SIZE, sizeof(indexOffset));
+	size_t numCells = (size_t) header[0] * header[1];
+
+	bool valid = memcmp(bytes, GridOutputWriter::MAGIC, 8) == 0 && memcmp(bytes + size - 8, GridOutputWriter::END_MAGIC, 8) == 0 &&
+				 header[0] >= 0 && header[1] >= 0 && indexOffset >= HEADER_SIZE && indexOffset % sizeof(int64_t) == 0 &&
+				 indexOffset + numCells * 3 * sizeof(int64_t) + FOOTER_SIZE == size;
+	const int64_t *entries = valid ? (const int64_t *) (bytes + indexOffset) : NULL;
+	for (size_t i = 0; valid && i < numCells; i ++) { // (every chunk must be inside the chunks section)
+		if (entries[3 * i] >= 0)
+			valid = entries[3 * i] >= HEADER_SIZE && entries[3 * i + 1] >= 0 && entries[3 * i + 2] >= 0 &&
+					entries[3 * i] + entries[3 * i + 1] + entries[3 * i + 2] <= indexOffset;
+	}
+	if (!valid) {
+		munmap(mapped, size);
+		return "Error: " + fileName + " is not a valid grid output file";
+	}
+
+	data = mapped;
+	dataSize = size;
+	rows = header[0];
+	cols = header[1];
+	index = entries;
+
+	return "Success!";
+}
+
+// method to get the text of the data file of the specified cell (numbered row by row), empty if it has none
+std::string GridOutputReader::getData(int cell) const {
+	if (!hasCell(cell))
+		return "";
+	return std::string((const char *) data + index[3 * cell], index[3 * cell + 1]);
+}
+
+// method to get the text of the summary file of the specified cell (numbered row by row), empty if it has none
+std::string GridOutputReader::getSummary(int cell) const {
+	if (!hasCell(cell))
+		return "";
+	return std::string((const char *) data + index[3 * cell] + index[3 * cell + 1], index[3 * cell + 2]);
+}
+
+// method to write the data file and summary file of the specified cell (numbered row by row), as they would have been
+// printed by the simulator without a grid output file
+// the data file is skipped if the cell has no data text (i.e. from a summary-only run), or dataFile is empty
+// error message is returned if the cell has no output or the files can't be written, otherwise if all is well "Success!" is returned
+errormsg GridOutputReader::extractCell(int cell, std::string dataFile, std::string summaryFile) const {
+	if (!hasCell(cell))
+		return "Error: there is no output for cell " + std::to_string(cell);
+
+	std::ofstream fileOut;
+	if (index[3 * cell + 1] > 0 && dataFile.compare("") != 0) {
+		fileOut.open(dataFile, std::ios::binary);
+		fileOut.write((const char *) data + index[3 * cell], index[3 * cell + 1]);
+		fileOut.close();
+		if (!fileOut)
+			return "Error: could not write " + dataFile;
+	}
+
+	fileOut.open(summaryFile, std::ios::binary);
+	fileOut.write((const char *) data + index[3 * cell] + index[3 * cell + 1], index[3 * cell + 2]);
+	fileOut.close();
+	if (!fileOut)
+		return "Error: could not write " + summaryFile;
+
+	return "Success!";
+}
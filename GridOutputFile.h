@@ -0,0 +1,117 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef GRID_OUTPUT_FILE_H
+#define GRID_OUTPUT_FILE_H
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Parameters.h"
+
+/*
+
+	Header file for GridOutputFile.cpp.  Contains the GridOutputWriter and GridOutputReader class definitions,
+	described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+
+/*
+	A grid output file holds the output of every cell of a multicell run in one file, instead of a data file
+	and a summary file per cell (which, for a large grid, is thousands of files).  Each cell's output is one
+	chunk: the text of its data file followed by the text of its summary file, exactly as they would have been
+	printed, so the per-cell files can be reproduced from it byte for byte (see the extractGridOutput tool).
+	The chunks are appended in the order the cells finish, and an index table at the end of the file gives
+	the position of each cell's chunk, so any cell can be read without reading the rest.
+
+	The file layout (in the byte order of the machine that wrote it) is:
+		header: "SWDGRID1", then int32 rows and cols
+		chunks: the data text and then the summary text of each cell (in no particular order; cells with the same
+		output, i.e. the masked cells, can share one chunk)
+		index (after padding to 8 bytes): per cell (row by row), int64 offset of its chunk, int64 length of its
+		data text and int64 length of its summary text (offset -1 for a cell with no output)
+		footer: int64 offset of the index, then "SWDGRIDX"
+*/
+
+/*
+	This class describes a GridOutputWriter object, which writes a grid output file as the cells of a run are
+	printed.  writeCell can be called from several writer threads at once (the chunks are appended one at a time).
+*/
+class GridOutputWriter {
+
+	int fd; // the file being written (-1 if none)
+	std::string fileName;
+	int rows, cols;
+	int64_t offset; // end of the file so far
+	std::vector<int64_t> index; // 3 values per cell (see the file layout)
+	bool failed; // whether any write failed
+	pthread_mutex_t lock; // lock for all the above (while appending)
+
+	bool writeAll(const char *bytes, size_t size);
+
+public:
+
+	static const char MAGIC[9];
+	static const char END_MAGIC[9];
+
+	GridOutputWriter();
+	~GridOutputWriter();
+
+	// (the writer owns the open file, so it can't be copied)
+	GridOutputWriter(const GridOutputWriter&) = delete;
+	GridOutputWriter& operator=(const GridOutputWriter&) = delete;
+
+	errormsg open(std::string fileName1, int rows1, int cols1);
+	void writeCell(int cell, const std::string &data, const std::string &summary);
+	void writeCells(const std::vector<int> &cells, const std::string &data, const std::string &summary);
+	errormsg close();
+
+};
+
+/*
+	This class describes a GridOutputReader object, which memory-maps a grid output file so the output of any
+	cell can be read (or extracted to the per-cell text files) on demand.
+*/
+class GridOutputReader {
+
+	void *data; // the mapped file
+	size_t dataSize;
+
+	int rows, cols;
+	const int64_t *index;
+
+	void close();
+
+public:
+
+	GridOutputReader();
+	~GridOutputReader();
+
+	// (the mapping is owned by the reader, so it can't be copied)
+	GridOutputReader(const GridOutputReader&) = delete;
+	GridOutputReader& operator=(const GridOutputReader&) = delete;
+
+	errormsg open(std::string fileName);
+
+	// accessors (the cells are numbered row by row)
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	bool hasCell(int cell) const { return cell >= 0 && cell < rows * cols && index[3 * cell] >= 0; } // (false for a cell outside the grid)
+	std::string getData(int cell) const;
+	std::string getSummary(int cell) const;
+
+	errormsg extractCell(int cell, std::string dataFile, std::string summaryFile) const;
+
+};
+
+#endif
@@ -0,0 +1,217 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "SWDSimulatorSingle.h"
+#include <chrono>
+#include <iomanip>
+
+/*
+
+	This file is a runner which reports how far the exponential integrator (one exact step per day) and
+	the adaptive Runge-Kutta integrator (see IntegratorMode in SWDCellSingle.h) diverge from the Euler's
+	method reference (dt = 0.05).
+	It runs the cells of the demo grid (see MultiCellRCP_demo.cpp: 3x2 cells, temperatures read from
+	TemperatureFiles/randomTemp_latR_lonC.txt, starting at latitude 24.5, default parameters, 365 days)
+	with all the integrators.
+
+	First, the Euler runs with the demo settings (fruit and diapause submodels on, flies added on the diapause
+	crossing date) are checked against the daily output in DATA/, to make sure they are the reference the demo
+	output was made with.  Then, for each combination of the fruit and diapause submodels, the report shows:
+		-- the max difference in the daily populations of each stage, relative to the peak Euler population
+		   (both populations are compared at the end of each day)
+		-- the relative difference in the peak and the cumulative population of each stage
+		-- the shift in the day of the peak population
+		-- the time taken by each integrator (and the number of steps taken by the Runge-Kutta integrator)
+
+	Compile with compileIntegratorReport.sh, and call it using:
+
+	./integratorReport [tempsDir] [dataDir]
+
+	tempsDir = directory with the demo temperature files (defaults to TemperatureFiles)
+	dataDir = directory with the demo output (defaults to DATA)
+
+*/
+
+// method to get the data series of a stage group of the simulation
+const XYSeries& getGroupSeries(const SWDSimulatorSingle &sim, int group) {
+	switch (group) {
+		case 0: return sim.getEggSeries();
+		case 1: return sim.getInst1Series();
+		case 2: return sim.getInst2Series();
+		case 3: return sim.getInst3Series();
+		case 4: return sim.getPupaeSeries();
+		case 5: return sim.getMalesSeries();
+		default: return sim.getFemalesSeries();
+	}
+}
+
+// method to get the cumulative population of a stage group of the simulation
+double getGroupTotal(const SWDSimulatorSingle &sim, int group) {
+	double totals[] = {sim.getTotEggs(), sim.getTotInst1(), sim.getTotInst2(), sim.getTotInst3(), sim.getTotPupae(), sim.getTotMales(), sim.getTotFemales()};
+	return totals[group];
+}
+
+// method to get the peak population (and its day) of a stage group of the simulation
+void getGroupPeak(const SWDSimulatorSingle &sim, int group, double &peak, double &peakDay) {
+	double peaks[] = {sim.getMaxEggs(), sim.getMaxInst1(), sim.getMaxInst2(), sim.getMaxInst3(), sim.getMaxPupae(), sim.getMaxMales(), sim.getMaxFemales()};
+	double days[] = {sim.getDayMaxEggs(), sim.getDayMaxInst1(), sim.getDayMaxInst2(), sim.getDayMaxInst3(), sim.getDayMaxPupae(), sim.getDayMaxMales(), sim.getDayMaxFemales()};
+	peak = peaks[group];
+	peakDay = days[group];
+}
+
+// method to run one simulation with the specified integrator; returns the time taken, in seconds
+double runSim(SWDSimulatorSingle &sim, IntegratorMode integrator, std::vector<double> &temps, double latitude, int runTime, bool ignoreFruit, bool ignoreDiapause, int startDay) {
+	std::string param = "latitude";
+	sim.setSingleParameter(param, latitude);
+	sim.setIntegrator(integrator);
+	sim.resetTime();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	sim.run(temps, runTime, ignoreFruit, ignoreDiapause, startDay);
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// method to check the daily output of an Euler run against the demo output file (printed by SWDSimulatorMulti::printCellInfo)
+// returns the number of values which don't match, or -1 if the file can't be read
+int compareToOutputFile(const SWDSimulatorSingle &sim, std::string fileName) {
+	std::ifstream fileIn(fileName);
+	if (!fileIn)
+		return -1;
+
+	std::string line;
+	std::getline(fileIn, line); // labels
+
+	int mismatches = 0;
+	int pointsPerDay = (int) (1 / sim.getDT() + 0.5);
+	for (int ik = 0; ik < sim.getEggSeries().size(); ik += pointsPerDay) {
+		std::string value;
+		fileIn >> value; // time
+		for (int group = 0; group < NUM_LIFESTAGES; group ++) {
+			std::stringstream sstm;
+			sstm << getGroupSeries(sim, group)[ik].getY();
+			if (!(fileIn >> value) || value != sstm.str())
+				mismatches ++;
+		}
+	}
+
+	return mismatches;
+}
+
+// method to print the divergence of the exponential run from the Euler run, for every stage group
+void printDivergence(const SWDSimulatorSingle &euler, const SWDSimulatorSingle &exact) {
+	int eulerPointsPerDay = (int) (1 / euler.getDT() + 0.5);
+	int numDays = exact.getEggSeries().size();
+
+	std::cout << "\t" << std::setw(8) << "stage" << std::setw(14) << "max daily" << std::setw(14) << "peak" << std::setw(14) << "cumulative" << std::setw(12) << "peak shift" << "\n";
+	for (int group = 0; group < NUM_LIFESTAGES; group ++) {
+		const XYSeries &eulerSeries = getGroupSeries(euler, group);
+		const XYSeries &exactSeries = getGroupSeries(exact, group);
+
+		// the exact series has one point per day (at the end of the day), so compare with the last point of each Euler day
+		double maxDiff = 0;
+		for (int day = 0; day < numDays && (day + 1) * eulerPointsPerDay - 1 < eulerSeries.size(); day ++)
+			maxDiff = std::max(maxDiff, std::fabs(exactSeries[day].getY() - eulerSeries[(day + 1) * eulerPointsPerDay - 1].getY()));
+
+		double eulerPeak, eulerPeakDay, exactPeak, exactPeakDay;
+		getGroupPeak(euler, group, eulerPeak, eulerPeakDay);
+		getGroupPeak(exact, group, exactPeak, exactPeakDay);
+		double eulerTotal = getGroupTotal(euler, group);
+
+		std::cout << "\t" << std::setw(8) << STAGE_NAMES[group];
+		if (eulerPeak > 0) {
+			std::cout << std::setw(13) << 100 * maxDiff / eulerPeak << "%";
+			std::cout << std::setw(13) << 100 * (exactPeak - eulerPeak) / eulerPeak << "%";
+		} else
+			std::cout << std::setw(14) << maxDiff << std::setw(14) << exactPeak;
+		if (eulerTotal > 0)
+			std::cout << std::setw(13) << 100 * (getGroupTotal(exact, group) - eulerTotal) / eulerTotal << "%";
+		else
+			std::cout << std::setw(14) << getGroupTotal(exact, group);
+		// (the peak day is the start of the step that ended at the peak, so compare the ends of the steps)
+		std::cout << std::setw(12) << round2Decimals((exactPeakDay + exact.getDT()) - (eulerPeakDay + euler.getDT())) << "\n";
+	}
+}
+
+// main method to run the report; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	std::string tempsDir = argc > 1 ? argv[1] : "TemperatureFiles";
+	std::string dataDir = argc > 2 ? argv[2] : "DATA";
+
+	// the demo grid (see MultiCellRCP_demo.cpp)
+	int rows = 3;
+	int cols = 2;
+	int runTime = 365;
+	double startLat = 24.5;
+
+	// submodel combinations: ignoreFruit, ignoreDiapause, startDay (the first is the one used for the demo output)
+	// (if diapause is ignored the flies are added on day 0, since they would never be added otherwise)
+	int combos[][3] = {{0, 0, -1}, {1, 0, -1}, {0, 1, 0}, {1, 1, 0}};
+	int numCombos = 4;
+
+	Parameters params; // default parameters, as in the demo
+	SWDSimulatorSingle euler(getDefaultDT(EULER_INTEGRATOR), params);
+	SWDSimulatorSingle exact(getDefaultDT(EXPONENTIAL_INTEGRATOR), params);
+	SWDSimulatorSingle adaptive(getDefaultDT(RUNGE_KUTTA_INTEGRATOR), params);
+
+	double eulerTime = 0, exactTime = 0, adaptiveTime = 0;
+	long adaptiveSteps = 0, adaptiveRejected = 0, adaptiveDays = 0;
+
+	for (int k = 0; k < numCombos; k ++) {
+		bool ignoreFruit = combos[k][0];
+		bool ignoreDiapause = combos[k][1];
+		int startDay = combos[k][2];
+
+		std::cout << "=== ignoreFruit " << ignoreFruit << ", ignoreDiapause " << ignoreDiapause << ", addFliesDate " << startDay << " ===\n\n";
+
+		for (int i = 0; i < rows; i ++) {
+			for (int j = 0; j < cols; j ++) {
+				std::stringstream sstm;
+				sstm << "randomTemp_lat" << (i + 1) << "_lon" << (j + 1) << ".txt";
+
+				std::ifstream fileIn(tempsDir + "/" + sstm.str());
+				std::vector<double> temps;
+				double v;
+				while (fileIn >> v)
+					temps.push_back(v);
+				if (temps.size() == 0) {
+					std::cout << "Could not read " << tempsDir << "/" << sstm.str() << "\n\n";
+					continue;
+				}
+
+				eulerTime += runSim(euler, EULER_INTEGRATOR, temps, startLat + i, runTime, ignoreFruit, ignoreDiapause, startDay);
+				exactTime += runSim(exact, EXPONENTIAL_INTEGRATOR, temps, startLat + i, runTime, ignoreFruit, ignoreDiapause, startDay);
+				adaptiveTime += runSim(adaptive, RUNGE_KUTTA_INTEGRATOR, temps, startLat + i, runTime, ignoreFruit, ignoreDiapause, startDay);
+				adaptiveSteps += adaptive.getCell().getStepControl().steps;
+				adaptiveRejected += adaptive.getCell().getStepControl().rejectedSteps;
+				adaptiveDays += runTime;
+
+				std::cout << sstm.str() << " (latitude " << startLat + i << ")\n";
+				if (k == 0) {
+					int mismatches = compareToOutputFile(euler, dataDir + "/output_" + sstm.str());
+					if (mismatches < 0)
+						std::cout << "\tEuler reference: could not read " << dataDir << "/output_" << sstm.str() << "\n";
+					else if (mismatches == 0)
+						std::cout << "\tEuler reference: matches " << dataDir << "/output_" << sstm.str() << "\n";
+					else
+						std::cout << "\tEuler reference: " << mismatches << " values differ from " << dataDir << "/output_" << sstm.str() << "\n";
+				}
+				std::cout << "\texponential:\n";
+				printDivergence(euler, exact);
+				std::cout << "\tRunge-Kutta:\n";
+				printDivergence(euler, adaptive);
+				std::cout << "\n";
+			}
+		}
+	}
+
+	std::cout << "Time: Euler (dt = 0.05) " << eulerTime << " s, exponential (dt = 1) " << exactTime << " s, Runge-Kutta " << adaptiveTime << " s\n";
+	if (adaptiveDays > 0)
+		std::cout << "Runge-Kutta steps: " << (double) adaptiveSteps / adaptiveDays << " per day (" << adaptiveRejected << " rejected)\n";
+
+	return 0;
+}
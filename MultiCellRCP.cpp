@@ -1,5 +1,6 @@
 #include "SWDSimulatorSingle.h"
 #include "SWDSimulatorMulti.h"
+#include "TemperatureFile.h"
 
 /*
 
@@ -58,8 +59,54 @@ int main(int argc, char *argv[]) {
 	}
 	
 	SWDSimulatorMulti sim("", rows, cols, latitudes); // set up the simulator with the running parameters
+	sim.setRecorder(RECORD_DAILY); // only keep the daily points (which are the ones printed)
+	std::string maskFile;
+	for (int k = 1; k < argc; k ++) {
+		std::string option = argv[k];
+		if (option.compare("summary") == 0) { // (run as "multiSim summary") only print the summary files
+			sim.setSummaryOnly(true);
+			sim.setStatistics(STATS_MEANS | STATS_DEGREE_DAYS);
+		} else if (option.compare("cache") == 0 && k + 1 < argc) { // (run as "multiSim cache cacheDirectory") cache the parsed temperature files
+			setTemperatureCache(argv[++ k]);
+		} else if (option.compare("cube") == 0 && k + 1 < argc) { // (run as "multiSim cube cubeFile") read the temperatures from a climate cube made with convertClimate
+			errormsg status = sim.useClimateCube(argv[++ k]);
+			if (status.compare("Success!") != 0) {
+				std::cout << status << "\n";
+				return 1;
+			}
+		} else if (option.compare("grid") == 0 && k + 1 < argc) { // (run as "multiSim grid gridFile") print all the cells to one grid output file (see extractGridOutput)
+			sim.useGridOutput(argv[++ k]);
+		} else if ((option.compare("results") == 0 || option.compare("results32") == 0) && k + 1 < argc) { // (run as "multiSim results resultsFile") write the data series to a binary results file (results32 for float32 values)
+			sim.useResultsFile(argv[++ k], option.compare("results32") == 0);
+		} else if (option.compare("batch") == 0 && k + 1 < argc) { // (run as "multiSim batch batchSize") step batchSize cells together with the vectorized Euler's method (see SWDCellBatch)
+			sim.setBatchSize(atoi(argv[++ k]));
+		} else if (option.compare("ratetable") == 0 && k + 1 < argc) { // (run as "multiSim ratetable resolution") look the temperature-dependent rates up in a table with the resolution in degrees (see RateTable)
+			double resolution = atof(argv[++ k]);
+			if (resolution <= 0) {
+				std::cout << "Error: the rate table resolution has to be > 0 degrees\n";
+				return 1;
+			}
+			RateTableError error = sim.useRateTable(resolution);
+			std::cout << "Rate table with a resolution of " << resolution << " degrees:\n";
+			error.print(std::cout);
+		} else if (option.compare("mask") == 0 && k + 1 < argc) { // (run as "multiSim mask maskFile") only simulate the cells set in a mask file (see GridMask)
+			maskFile = argv[++ k];
+		}
+	}
+
+	// skip the masked cells (with a climate cube and no mask file, the cells with no or NaN temperatures are masked)
+	errormsg maskStatus = "Success!";
+	if (maskFile.size() > 0)
+		maskStatus = sim.useMask(maskFile);
+	else if (sim.hasClimateCube())
+		maskStatus = sim.useClimateCubeMask();
+	if (maskStatus.compare("Success!") != 0) {
+		std::cout << maskStatus << "\n";
+		return 1;
+	}
 	
 	sim.run(runTime, ignoreFruit, ignoreDiapause, startDay, fileNames, summaryFiles, tempsFiles); // run the simulator (this also prints the output)
+	std::cout << "Workers waited " << sim.getInputWaitTime() << " s for temperatures (" << sim.getNumPrefetchMisses() << " cells not read ahead)\n";
 	
 	return 0;
 }
@@ -69,6 +69,7 @@ int main(int argc, char *argv[]) {
 	}
 	
 	SWDSimulatorMulti sim("", rows, cols, latitudes); // set up the simulator with the running parameters
+	sim.setRecorder(RECORD_DAILY); // only keep the daily points (which are the ones printed)
 	
 	sim.run(runTime, ignoreFruit, ignoreDiapause, startDay, fileNames, summaryFiles, tempsFiles); // run the simulator (this also prints the output)
 	
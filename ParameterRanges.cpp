@@ -0,0 +1,62 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "ParameterRanges.h"
+#include <fstream>
+#include <sstream>
+
+/*
+
+	Implementation of the ParameterRanges class.  The class definition and description (with the file format)
+	are included in the ParameterRanges header file.
+
+*/
+
+// method to read the ranges from a file (added to any ranges already added), checking the names against the
+// parameters in params (lines without a colon are skipped)
+// error message is returned if the file can't be read or a line is invalid, otherwise if all is well "Success!" is returned
+errormsg ParameterRanges::load(std::string rangesFile, const Parameters &params) {
+	std::ifstream fileIn(rangesFile.c_str());
+	if (!fileIn)
+		return "Error: could not open the ranges file " + rangesFile;
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(fileIn, line)) {
+		lineNumber ++;
+		size_t colon = line.find(':');
+		if (colon == std::string::npos)
+			continue;
+
+		double minValue, maxValue;
+		std::istringstream iss(line.substr(colon + 1));
+		if (!(iss >> minValue >> maxValue))
+			return "Error: invalid range on line " + std::to_string(lineNumber) + " of " + rangesFile;
+
+		errormsg status = add(line.substr(0, colon), minValue, maxValue, params);
+		if (status.compare("Success!") != 0)
+			return status;
+	}
+
+	if (names.size() == 0)
+		return "Error: " + rangesFile + " has no parameter ranges";
+	return "Success!";
+}
+
+// method to add a parameter which can take any value from minValue to maxValue
+// error message is returned if params has no such parameter or the range is empty, otherwise if all is well "Success!" is returned
+errormsg ParameterRanges::add(std::string name, double minValue, double maxValue, const Parameters &params) {
+	if (params.getMap().count(name) == 0)
+		return "Error: there is no parameter called " + name;
+	if (!(minValue < maxValue))
+		return "Error: the range of " + name + " is empty";
+
+	names.push_back(name);
+	minValues.push_back(minValue);
+	maxValues.push_back(maxValue);
+	return "Success!";
+}
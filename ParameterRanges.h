@@ -0,0 +1,52 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef PARAMETER_RANGES_H
+#define PARAMETER_RANGES_H
+
+#include <vector>
+#include <string>
+#include "Parameters.h"
+
+/*
+
+	Header file for ParameterRanges.cpp.  Contains the ParameterRanges class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	This class describes a ParameterRanges object, which is the list of parameters varied by a sensitivity
+	analysis or fitted by a calibration (see SWDSensitivity and SWDCalibration), each with the range of values
+	it can take.
+
+	A ranges file has one parameter per line, as the name of the parameter, a colon, and its min and max values
+	(i.e. "eggs mortality max: 0.2 0.4"), like the lines of a config file.
+*/
+class ParameterRanges {
+
+	std::vector<std::string> names;
+	std::vector<double> minValues;
+	std::vector<double> maxValues;
+
+public:
+
+	errormsg load(std::string rangesFile, const Parameters &params);
+	errormsg add(std::string name, double minValue, double maxValue, const Parameters &params);
+
+	int size() const { return names.size(); }
+	const std::vector<std::string>& getNames() const { return names; }
+	const std::string& getName(int i) const { return names[i]; }
+	double getMin(int i) const { return minValues[i]; }
+	double getMax(int i) const { return maxValues[i]; }
+	double getValue(int i, double fraction) const { return minValues[i] + fraction * (maxValues[i] - minValues[i]); } // value at the fraction of the range
+
+};
+
+#endif
@@ -0,0 +1,48 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "PhotoperiodTable.h"
+
+/*
+
+	Implementation of the PhotoperiodTable and PhotoperiodTables classes.  The class
+	definitions and descriptions are included in the PhotoperiodTable header file.
+
+*/
+
+// constructor taking the latitude to tabulate the daylight hours for
+// every date the simulation can ask for (a 365 day year, shifted by any of the solstice offsets) is computed here
+PhotoperiodTable::PhotoperiodTable(double latitudeNew) : latitude(latitudeNew) {
+	hours.resize(365 + MAX_OFFSET);
+	for (int date = 0; date < hours.size(); date ++)
+		hours[date] = ::getDayLightHours(0, date, latitude); // (the year doesn't affect the daylight hours, only the offset)
+}
+
+// method to get the daylight hours of the specified day of the simulation (0 = January first of the first year)
+// this gives the same value as getDayLightHours(year, date + getOffSet(year), latitude), as used by SWDPopulation
+double PhotoperiodTable::getDayLightHours(int day) const {
+	int year = day / 365;
+	int date = day % 365;
+	return hours[date + getOffSet(year)];
+}
+
+// method to get the table for the specified latitude, building it if there isn't one yet
+std::shared_ptr<const PhotoperiodTable> PhotoperiodTables::getTable(double latitude) {
+	std::shared_ptr<const PhotoperiodTable> &table = tables[latitude];
+	if (!table)
+		table = std::make_shared<const PhotoperiodTable>(latitude);
+	return table;
+}
+
+// method to get the table for the specified latitude, if it has been built (otherwise null)
+// unlike getTable, this doesn't change the store, so it can be called from several threads at once
+std::shared_ptr<const PhotoperiodTable> PhotoperiodTables::findTable(double latitude) const {
+	std::map<double, std::shared_ptr<const PhotoperiodTable>>::const_iterator table = tables.find(latitude);
+	if (table == tables.end())
+		return std::shared_ptr<const PhotoperiodTable>();
+	return table->second;
+}
@@ -0,0 +1,70 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef PHOTOPERIOD_TABLE_H
+#define PHOTOPERIOD_TABLE_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include "Daylight.h"
+
+/*
+
+	Header file for PhotoperiodTable.cpp.  Contains the PhotoperiodTable and PhotoperiodTables
+	class definitions, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	This class describes a PhotoperiodTable object, which holds the daylight hours of every date
+	of the year at one latitude.  The daylight hours only depend on the latitude and the date
+	(shifted by the solstice offset of the year, see getOffSet), so instead of evaluating
+	getDayLightHours for every day of every cell, they are computed once per latitude.
+
+	A table is read-only after construction, so one table can be shared by every cell (and
+	every thread) at the same latitude (i.e. all the cells in a row of a grid).
+*/
+class PhotoperiodTable {
+
+	static const int MAX_OFFSET = 10; // largest solstice offset returned by getOffSet (31 - the earliest solstice day)
+
+	double latitude;
+	std::vector<double> hours; // daylight hours of each shifted date (date + offset of the year), 0 .. 364 + MAX_OFFSET
+
+public:
+
+	PhotoperiodTable(double latitudeNew);
+
+	double getDayLightHours(int day) const;
+	double getLatitude() const { return latitude; }
+
+};
+
+/*
+	This class is the store of PhotoperiodTables for a simulation: it builds the table for a
+	latitude the first time it is asked for, and hands out the same (shared) table afterwards.
+	The tables are built before the threads are started, and the threads only look them up
+	(with findTable), so the store itself isn't locked.
+*/
+class PhotoperiodTables {
+
+	std::map<double, std::shared_ptr<const PhotoperiodTable>> tables; // table of each latitude so far
+
+public:
+
+	std::shared_ptr<const PhotoperiodTable> getTable(double latitude);
+	std::shared_ptr<const PhotoperiodTable> findTable(double latitude) const;
+	int getNumTables() const { return tables.size(); }
+	void clear() { tables.clear(); }
+
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "RateTable.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+
+	Implementation of the RateTable class and RateTableError struct methods.  The class
+	definition and description are included in the RateTable header file.
+
+*/
+
+// method to print the errors in a readable format
+void RateTableError::print(std::ostream &out) const {
+	out << "Max fecundity error: " << maxFertility << " (at " << maxFertilityTemp << " degrees)\n";
+	out << "Max development error: " << maxDevelopment << " (at " << maxDevelopmentTemp << " degrees)\n";
+	out << "Max mortality error: " << maxMortality << " (at " << maxMortalityTemp << " degrees)\n";
+}
+
+// constructor taking the parameters to tabulate the rates for, the resolution of the table (in degrees),
+// and the temperature range to tabulate
+// this is where the rates are actually computed, so it should only be done once per parameter set
+RateTable::RateTable(const CompiledParameters &paramsNew, double resolutionNew, double minTempNew, double maxTempNew) : params(paramsNew), minTemp(minTempNew), maxTemp(maxTempNew), resolution(resolutionNew) {
+	if (resolution <= 0)
+		resolution = 0.1;
+	if (maxTemp < minTemp + resolution) // at least one interval
+		maxTemp = minTemp + resolution;
+
+	numPoints = (int) ((maxTemp - minTemp) / resolution + 0.5) + 1;
+	maxTemp = minTemp + (numPoints - 1) * resolution; // make sure the range is a whole number of intervals
+
+	table.resize(numPoints * NUM_RATES);
+	for (int i = 0; i < numPoints; i ++)
+		computeRates(minTemp + i * resolution, &table[i * NUM_RATES]);
+
+	// intervals with a discontinuity in any of the rates use the analytic functions
+	analyticInterval.assign(numPoints, false);
+	markBreakpoint(params.fertilityTmax);
+	markBreakpoint(BRIERE_T0);
+	markBreakpoint(BRIERE_TL);
+	markBand(BRIERE_TL - BRIERE_EXACT_BAND, BRIERE_TL); // (the sqrt(TL - T) term of the Briere equation can't be interpolated near TL)
+	for (int i = 0; i < CompiledParameters::NUM_STAGES; i ++) {
+		markBreakpoint(params.mortalityMinTemp[i]);
+		markBreakpoint(params.mortalityMaxTemp[i]);
+	}
+}
+
+// method to mark the interval(s) containing the specified temperature so that they are not interpolated
+// if the temperature is exactly on a table point, both neighbouring intervals are marked
+void RateTable::markBreakpoint(double T) {
+	double pos = (T - minTemp) / resolution;
+	if (!(pos >= 0 && pos <= numPoints - 1))
+		return; // outside the table, nothing to mark
+
+	int index = (int) pos;
+	if (index < numPoints - 1)
+		analyticInterval[index] = true;
+	if (index > 0 && pos == index)
+		analyticInterval[index - 1] = true;
+}
+
+// method to mark all the intervals overlapping the temperatures from lowTemp to highTemp so that they are not interpolated
+void RateTable::markBand(double lowTemp, double highTemp) {
+	int first = std::max(0, (int) std::floor((lowTemp - minTemp) / resolution));
+	int last = std::min(numPoints - 2, (int) std::floor((highTemp - minTemp) / resolution));
+	for (int i = first; i <= last; i ++)
+		analyticInterval[i] = true;
+}
+
+// method to compute all the tabulated rates at the given temperature with the analytic functions
+// the rates are stored in the row passed in (which has room for NUM_RATES values)
+void RateTable::computeRates(double T, double row[]) const {
+	row[0] = solveSpecificFertility(T, params);
+
+	for (int i = 0; i < CompiledParameters::NUM_DEV_STAGES; i ++) {
+		if (i < 5) // juvenile stages use the Briere equation
+			row[DEV_OFFSET + i] = solveDev_Briere_Juvenile(T, params.developmentMax[i]);
+		else // female development is independent of temperature
+			row[DEV_OFFSET + i] = params.developmentMax[i];
+	}
+
+	for (int i = 0; i < CompiledParameters::NUM_STAGES; i ++)
+		row[MORT_OFFSET + i] = solveMortality(T, params, i);
+}
+
+// method to look up all the rates at the specified temperature
+// the fecundity is returned in fertility, and the development and mortality rates are stored
+// in devRate (11 values) and mortalityNat (13 values)
+void RateTable::lookup(double T, double &fertility, double devRate[], double mortalityNat[]) const {
+	double row[NUM_RATES];
+
+	double pos = (T - minTemp) / resolution;
+
+	int index = -1; // interval containing T (-1 if outside the table, or NaN)
+	if (pos >= 0 && pos <= numPoints - 1) {
+		index = (int) pos;
+		if (index >= numPoints - 1) // T is exactly the top of the range
+			index = numPoints - 2;
+	}
+
+	if (index < 0 || analyticInterval[index]) { // outside the table, or at a discontinuity
+		computeRates(T, row);
+	} else {
+		double frac = pos - index;
+
+		const double* lower = &table[index * NUM_RATES];
+		const double* upper = lower + NUM_RATES;
+		for (int i = 0; i < NUM_RATES; i ++)
+			row[i] = lower[i] + (upper[i] - lower[i]) * frac; // linear interpolation
+	}
+
+	fertility = row[0];
+	for (int i = 0; i < CompiledParameters::NUM_DEV_STAGES; i ++)
+		devRate[i] = row[DEV_OFFSET + i];
+	for (int i = 0; i < CompiledParameters::NUM_STAGES; i ++)
+		mortalityNat[i] = row[MORT_OFFSET + i];
+}
+
+// method to compute the maximum interpolation error of the table, compared to the analytic functions
+// every interval of the table is sampled at samplesPerInterval evenly spaced temperatures
+// (the intervals which use the analytic functions have no error)
+RateTableError RateTable::computeError(int samplesPerInterval) const {
+	RateTableError error;
+
+	if (samplesPerInterval < 1)
+		samplesPerInterval = 1;
+
+	double analytic[NUM_RATES];
+	double fertility;
+	double devRate[CompiledParameters::NUM_DEV_STAGES];
+	double mortalityNat[CompiledParameters::NUM_STAGES];
+
+	for (int i = 0; i < numPoints - 1; i ++) {
+		for (int j = 1; j <= samplesPerInterval; j ++) {
+			double T = minTemp + (i + j / (samplesPerInterval + 1.0)) * resolution;
+
+			computeRates(T, analytic);
+			lookup(T, fertility, devRate, mortalityNat);
+
+			double diff = std::fabs(fertility - analytic[0]);
+			if (diff > error.maxFertility) {
+				error.maxFertility = diff;
+				error.maxFertilityTemp = T;
+			}
+
+			for (int k = 0; k < CompiledParameters::NUM_DEV_STAGES; k ++) {
+				diff = std::fabs(devRate[k] - analytic[DEV_OFFSET + k]);
+				if (diff > error.maxDevelopment) {
+					error.maxDevelopment = diff;
+					error.maxDevelopmentTemp = T;
+				}
+			}
+
+			for (int k = 0; k < CompiledParameters::NUM_STAGES; k ++) {
+				diff = std::fabs(mortalityNat[k] - analytic[MORT_OFFSET + k]);
+				if (diff > error.maxMortality) {
+					error.maxMortality = diff;
+					error.maxMortalityTemp = T;
+				}
+			}
+		}
+	}
+
+	return error;
+}
@@ -0,0 +1,92 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef RATE_TABLE_H
+#define RATE_TABLE_H
+
+#include <iostream>
+#include "CompiledParameters.h"
+#include "SolveParameters.h"
+
+/*
+
+	Header file for RateTable.cpp.  Contains the RateTable class definition and the
+	RateTableError struct, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	This struct holds the maximum interpolation error of a RateTable (compared to the
+	analytic functions in SolveParameters.cpp), for each kind of rate, and the temperature
+	where the maximum occurred.  Use it to choose a table resolution for a grid.
+*/
+struct RateTableError {
+
+	double maxFertility, maxDevelopment, maxMortality; // max absolute error per kind of rate
+	double maxFertilityTemp, maxDevelopmentTemp, maxMortalityTemp; // temperature of the max error
+
+	RateTableError() : maxFertility(0), maxDevelopment(0), maxMortality(0), maxFertilityTemp(0), maxDevelopmentTemp(0), maxMortalityTemp(0) {}
+
+	void print(std::ostream &out) const;
+
+};
+
+/*
+	This class describes a RateTable object, which is an optional replacement for the analytic
+	fecundity, development and natural mortality functions.  Since these are pure functions of
+	the temperature (for a fixed set of parameters), they are tabulated once over a temperature
+	range at a given resolution, and afterwards looked up with linear interpolation.
+	Temperatures outside of the tabulated range fall back to the analytic functions, as do 
+	temperatures in the intervals containing a discontinuity of the rates (the mortality min 
+	and max temps, the fertility tmax and the limits of the Briere equation), since these 
+	can't be interpolated accurately at any resolution.  The same goes for the band of
+	BRIERE_EXACT_BAND degrees below the upper limit of the Briere equation, where its slope
+	grows without bound (so the interpolation error there wouldn't shrink with the resolution).
+
+	A table is read-only after construction, so one table can be shared by every cell (and
+	every thread) in a simulation, as long as the cells use the same non-fruit parameters
+	(see SWDSimulatorMulti::useRateTable).
+
+	Per temperature point, the table stores one row of NUM_RATES values:
+	0 - fecundity, 1..11 - development (same indices as CompiledParameters::developmentMax),
+	12..24 - natural mortality (per stage)
+*/
+class RateTable {
+
+	static const int NUM_RATES = 1 + CompiledParameters::NUM_DEV_STAGES + CompiledParameters::NUM_STAGES;
+	static const int DEV_OFFSET = 1;
+	static const int MORT_OFFSET = 1 + CompiledParameters::NUM_DEV_STAGES;
+	static constexpr double BRIERE_EXACT_BAND = 1; // degrees below BRIERE_TL computed with the analytic functions
+
+	CompiledParameters params; // parameters the table was built for (also used outside the range)
+	double minTemp, maxTemp, resolution;
+	int numPoints; // number of tabulated temperatures
+	std::vector<double> table; // numPoints rows of NUM_RATES values
+	std::vector<char> analyticInterval; // per interval, true if it contains a discontinuity (so it isn't interpolated)
+
+	void computeRates(double T, double row[]) const;
+	void markBreakpoint(double T);
+	void markBand(double lowTemp, double highTemp);
+
+public:
+
+	RateTable(const CompiledParameters &paramsNew, double resolutionNew = 0.1, double minTempNew = -40, double maxTempNew = 50);
+
+	void lookup(double T, double &fertility, double devRate[], double mortalityNat[]) const;
+	RateTableError computeError(int samplesPerInterval = 10) const;
+
+	double getMinTemp() const { return minTemp; }
+	double getMaxTemp() const { return maxTemp; }
+	double getResolution() const { return resolution; }
+	int getNumPoints() const { return numPoints; }
+
+};
+
+#endif
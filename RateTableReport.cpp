@@ -0,0 +1,58 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "RateTable.h"
+#include "Parameters.h"
+
+/*
+
+	This file is a runner which reports the interpolation error of the rate lookup table (see RateTable.h)
+	at a range of resolutions, to choose a resolution for a grid (see "ratetable" in MultiCellRCP.cpp).
+	It also checks that the error drops as the resolution gets finer: if a finer table has a larger max
+	error of any kind of rate than a coarser one, the report says so and exits with status 1.
+
+	Compile with compileRateTableReport.sh, and call it using:
+
+	./rateTableReport [paramFileName]
+
+	paramFileName = (optional) the extended parameters list to tabulate the rates for (the default
+	                parameters otherwise)
+
+*/
+
+const double RESOLUTIONS[] = {1, 0.5, 0.2, 0.1, 0.05, 0.02, 0.01}; // in degrees, coarsest first
+const int NUM_RESOLUTIONS = sizeof(RESOLUTIONS) / sizeof(RESOLUTIONS[0]);
+
+// main method to run the code; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	Parameters params;
+	if (argc > 1)
+		params.setConfigParams(argv[1]);
+	CompiledParameters compiledParams(params);
+
+	bool dropping = true;
+	RateTableError previous;
+	for (int i = 0; i < NUM_RESOLUTIONS; i ++) {
+		RateTable table(compiledParams, RESOLUTIONS[i]);
+		RateTableError error = table.computeError();
+
+		std::cout << "Resolution " << RESOLUTIONS[i] << " degrees (" << table.getNumPoints() << " points):\n";
+		error.print(std::cout);
+
+		if (i > 0 && (error.maxFertility > previous.maxFertility || error.maxDevelopment > previous.maxDevelopment || error.maxMortality > previous.maxMortality)) {
+			std::cout << "FAILED: the error is larger than at resolution " << RESOLUTIONS[i - 1] << " degrees\n";
+			dropping = false;
+		}
+		previous = error;
+	}
+
+	if (!dropping)
+		return 1;
+	std::cout << "The error drops as the resolution gets finer\n";
+	return 0;
+}
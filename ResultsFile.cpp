@@ -0,0 +1,264 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "ResultsFile.h"
+#include "UtilityMethods.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+
+	Implementation of the ResultsWriter and ResultsReader classes.  The class definitions and descriptions
+	(with the file layout) are included in the ResultsFile header file.
+
+*/
+
+const char ResultsWriter::MAGIC[9] = "SWDRES01";
+const char ResultsWriter::END_MAGIC[9] = "SWDRESIX";
+
+static const size_t HEADER_SIZE = 8 + 6 * sizeof(int32_t);
+static const size_t FOOTER_SIZE = sizeof(int64_t) + 8;
+
+// constructor for a ResultsWriter (with no file open)
+ResultsWriter::ResultsWriter() : fd(-1), rows(0), cols(0), numColumns(0), valueSize(8), chunkDays(1), offset(0), failed(false) {
+	pthread_mutex_init(&lock, NULL);
+}
+
+// destructor for the ResultsWriter: finishes the file, if it is still open
+ResultsWriter::~ResultsWriter() {
+	close();
+	pthread_mutex_destroy(&lock);
+}
+
+// method to write the specified bytes at the end of the file (the lock must be held)
+// returns false if the write failed
+bool ResultsWriter::writeAll(const char *bytes, size_t size) {
+	if (!writeFully(fd, bytes, size))
+		return false;
+	offset += size;
+	return true;
+}
+
+// method to start writing a results file for a rows1 x cols1 grid with the specified columns (replacing the file, if it exists)
+// the values are stored as float32 if singlePrecision is true (half the size), otherwise float64, in chunks of chunkDays1 days
+// error message is returned if the file can't be created, otherwise if all is well "Success!" is returned
+errormsg ResultsWriter::open(std::string fileName1, int rows1, int cols1, const std::vector<std::string> &columnNames, bool singlePrecision, int chunkDays1) {
+	close();
+
+	fd = ::open(fileName1.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return "Error: could not create the results file " + fileName1;
+
+	fileName = fileName1;
+	rows = rows1;
+	cols = cols1;
+	numColumns = columnNames.size();
+	valueSize = singlePrecision ? 4 : 8;
+	chunkDays = chunkDays1 > 0 ? chunkDays1 : 1;
+	offset = 0;
+	index.assign(2 * (size_t) rows * cols, 0);
+	for (size_t i = 0; i < index.size(); i += 2)
+		index[i] = -1; // (no series yet)
+
+	int32_t header[6] = {rows, cols, numColumns, valueSize, chunkDays, 0};
+	std::vector<char> names(numColumns * NAME_LENGTH, 0);
+	for (int k = 0; k < numColumns; k ++)
+		strncpy(&names[k * NAME_LENGTH], columnNames[k].c_str(), NAME_LENGTH - 1);
+
+	failed = !writeAll(MAGIC, 8) || !writeAll((const char *) header, sizeof(header)) || (numColumns > 0 && !writeAll(&names[0], names.size()));
+	const char padding[8] = {0};
+	if (!failed && !writeAll(padding, (8 - offset % 8) % 8)) // (so the values can be read in place)
+		failed = true;
+	return failed ? "Error: could not write the results file " + fileName : "Success!";
+}
+
+// method to append the series of the specified cell (numbered row by row): columns has the values of each column of the file,
+// by day (the columns all have the same number of days)
+// the chunks are put together before the lock is taken, so the writer threads only wait for each other to append them
+void ResultsWriter::writeCell(int cell, const std::vector<std::vector<double>> &columns) {
+	int64_t numDays = columns.size() > 0 ? columns[0].size() : 0;
+	std::vector<char> block((numDays * numColumns * valueSize + 7) / 8 * 8, 0); // (padded to 8 bytes)
+
+	char *values = block.size() > 0 ? &block[0] : NULL;
+	for (int64_t first = 0; first < numDays; first += chunkDays) {
+		int64_t length = std::min((int64_t) chunkDays, numDays - first);
+		for (int k = 0; k < numColumns; k ++) {
+			for (int64_t d = first; d < first + length; d ++) {
+				if (valueSize == 4) {
+					float single = columns[k][d];
+					memcpy(values, &single, sizeof(single));
+				} else
+					memcpy(values, &columns[k][d], sizeof(double));
+				values += valueSize;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&lock);
+	if (fd >= 0) {
+		index[2 * cell] = offset;
+		index[2 * cell + 1] = numDays;
+		if (block.size() > 0 && !writeAll(&block[0], block.size()))
+			failed = true;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+// method to finish the file: the index and footer are written after the cells, and the file is closed
+// error message is returned if any of the file couldn't be written, otherwise if all is well "Success!" is returned
+errormsg ResultsWriter::close() {
+	if (fd < 0)
+		return "Success!";
+
+	int64_t indexOffset = offset; // (the cells are padded to 8 bytes, so this is too)
+	if (index.size() > 0 && !writeAll((const char *) &index[0], index.size() * sizeof(int64_t)))
+		failed = true;
+	if (!writeAll((const char *) &indexOffset, sizeof(indexOffset)) || !writeAll(END_MAGIC, 8))
+		failed = true;
+	if (::close(fd) != 0)
+		failed = true;
+	fd = -1;
+
+	return failed ? "Error: could not write the results file " + fileName : "Success!";
+}
+
+// constructor for an (empty) ResultsReader
+ResultsReader::ResultsReader() : data(NULL), dataSize(0), rows(0), cols(0), numColumns(0), valueSize(8), chunkDays(1), index(NULL) {}
+
+// destructor for the ResultsReader: unmaps the file
+ResultsReader::~ResultsReader() {
+	close();
+}
+
+// method to unmap the file (if one is mapped)
+void ResultsReader::close() {
+	if (data != NULL)
+		munmap(data, dataSize);
+	data = NULL;
+	dataSize = 0;
+	rows = cols = numColumns = 0;
+	columnNames.clear();
+	index = NULL;
+}
+
+// method to map the specified results file (replacing any file mapped before)
+// error message is returned if the file can't be mapped or isn't a valid (finished) results file, otherwise if all
+// is well "Success!" is returned
+errormsg ResultsReader::open(std::string fileName) {
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return "Error: could not open the results file " + fileName;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < HEADER_SIZE + FOOTER_SIZE) {
+		::close(fd);
+		return "Error: " + fileName + " is too short to be a results file";
+	}
+
+	void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // (the mapping stays valid)
+	if (mapped == MAP_FAILED)
+		return "Error: could not map the results file " + fileName;
+
+	// read the header and footer
+	const char *bytes = (const char *) mapped;
+	size_t size = info.st_size;
+	int32_t header[6];
+	memcpy(header, bytes + 8, sizeof(header));
+	int64_t indexOffset;
+	memcpy(&indexOffset, bytes + size - FOOTER_SIZE, sizeof(indexOffset));
+	size_t numCells = (size_t) header[0] * header[1];
+	int64_t cellsStart = (HEADER_SIZE + (int64_t) header[2] * ResultsWriter::NAME_LENGTH + 7) / 8 * 8;
+
+	bool valid = memcmp(bytes, ResultsWriter::MAGIC, 8) == 0 && memcmp(bytes + size - 8, ResultsWriter::END_MAGIC, 8) == 0 &&
+				 header[0] >= 0 && header[1] >= 0 && header[2] >= 0 && (header[3] == 4 || header[3] == 8) && header[4] > 0 &&
+				 indexOffset >= cellsStart && indexOffset % sizeof(int64_t) == 0 && indexOffset + numCells * 2 * sizeof(int64_t) + FOOTER_SIZE == size;
+	const int64_t *entries = valid ? (const int64_t *) (bytes + indexOffset) : NULL;
+	for (size_t i = 0; valid && i < numCells; i ++) { // (every cell must be inside the cells section)
+		if (entries[2 * i] >= 0)
+			valid = entries[2 * i] >= cellsStart && entries[2 * i] % 8 == 0 && entries[2 * i + 1] >= 0 &&
+					entries[2 * i] + entries[2 * i + 1] * header[2] * header[3] <= indexOffset;
+	}
+	if (!valid) {
+		munmap(mapped, size);
+		return "Error: " + fileName + " is not a valid results file";
+	}
+
+	data = mapped;
+	dataSize = size;
+	rows = header[0];
+	cols = header[1];
+	numColumns = header[2];
+	valueSize = header[3];
+	chunkDays = header[4];
+	index = entries;
+	for (int k = 0; k < numColumns; k ++) {
+		const char *name = bytes + HEADER_SIZE + k * ResultsWriter::NAME_LENGTH;
+		columnNames.push_back(std::string(name, strnlen(name, ResultsWriter::NAME_LENGTH)));
+	}
+
+	return "Success!";
+}
+
+// method to find the column with the specified name (i.e. "females")
+// returns the number of the column, or -1 if there is no such column
+int ResultsReader::findColumn(std::string name) const {
+	for (int k = 0; k < numColumns; k ++) {
+		if (columnNames[k].compare(name) == 0)
+			return k;
+	}
+	return -1;
+}
+
+// method to get the address of the value of the specified column of a cell (numbered row by row) on the specified day
+// (counted from the start of its series) in the mapped file (the cell, column and day must be in range)
+const char* ResultsReader::getValueAddress(int cell, int column, int day) const {
+	int64_t numDays = index[2 * cell + 1];
+	int64_t first = (int64_t) day / chunkDays * chunkDays; // first day of the chunk
+	int64_t length = std::min((int64_t) chunkDays, numDays - first);
+	return (const char *) data + index[2 * cell] + (first * numColumns + column * length + (day - first)) * valueSize;
+}
+
+// method to get the value of the specified column of a cell (numbered row by row) on the specified day (counted from the
+// start of its series, 0 .. getNumDays(cell) - 1)
+// NaN is returned if the cell has no series, or the column or day is outside it
+double ResultsReader::getValue(int cell, int column, int day) const {
+	if (column < 0 || column >= numColumns || day < 0 || day >= getNumDays(cell))
+		return NAN;
+	const char *address = getValueAddress(cell, column, day);
+	if (valueSize == 4)
+		return *(const float *) address;
+	return *(const double *) address;
+}
+
+// method to get the values of the specified column of a cell (numbered row by row) from firstDay up to (not including)
+// lastDay, added to values (the range is clipped to the days the cell has, so a masked cell, or a column that
+// doesn't exist, adds nothing)
+// each chunk of the range is a contiguous run of values, read in place
+void ResultsReader::getSeries(int cell, int column, int firstDay, int lastDay, std::vector<double> &values) const {
+	if (!hasCell(cell) || column < 0 || column >= numColumns)
+		return;
+	firstDay = std::max(firstDay, 0);
+	lastDay = std::min(lastDay, getNumDays(cell));
+
+	for (int day = firstDay; day < lastDay; ) {
+		int end = std::min(lastDay, (day / chunkDays + 1) * chunkDays); // (end of the range within this chunk)
+		const char *address = getValueAddress(cell, column, day);
+		if (valueSize == 4)
+			values.insert(values.end(), (const float *) address, (const float *) address + (end - day));
+		else
+			values.insert(values.end(), (const double *) address, (const double *) address + (end - day));
+		day = end;
+	}
+}
@@ -0,0 +1,127 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef RESULTS_FILE_H
+#define RESULTS_FILE_H
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Parameters.h"
+
+/*
+
+	Header file for ResultsFile.cpp.  Contains the ResultsWriter and ResultsReader class definitions,
+	described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+
+/*
+	A results file holds the daily series of every cell of a multicell run (the values of the data files) in
+	binary columns, one column per series (time, each life stage, fruit quality), so they can be memory-mapped
+	and sliced by downstream tools instead of parsing text.  The file is self-describing: the header gives the
+	grid size, the names of the columns, the precision of the values (float32 or float64) and the chunk size.
+
+	Each cell's days are split into chunks of chunkDays days, and each chunk holds its days of every column in
+	turn (column by column), so a range of days of one column is a contiguous run of values within each chunk.
+	The cells are appended in the order they finish, and an index table at the end gives the position and
+	number of days of each cell.
+
+	The file layout (in the byte order of the machine that wrote it) is:
+		header: "SWDRES01", then int32 rows, cols, numColumns, valueSize (4 or 8), chunkDays, and 0 (padding)
+		column names: numColumns names of 16 chars (padded with zeros)
+		cells: the chunks of each cell (in no particular order), each cell padded to 8 bytes
+		index: per cell (row by row), int64 offset of its first chunk and int64 number of days (offset -1 for a
+		cell with no series, i.e. a masked cell)
+		footer: int64 offset of the index, then "SWDRESIX"
+*/
+
+/*
+	This class describes a ResultsWriter object, which writes a results file as the cells of a run are printed.
+	writeCell can be called from several writer threads at once (the cells are appended one at a time).
+*/
+class ResultsWriter {
+
+	int fd; // the file being written (-1 if none)
+	std::string fileName;
+	int rows, cols, numColumns, valueSize, chunkDays;
+	int64_t offset; // end of the file so far
+	std::vector<int64_t> index; // 2 values per cell (see the file layout)
+	bool failed; // whether any write failed
+	pthread_mutex_t lock; // lock for all the above (while appending)
+
+	bool writeAll(const char *bytes, size_t size);
+
+public:
+
+	static const char MAGIC[9];
+	static const char END_MAGIC[9];
+	static const int NAME_LENGTH = 16;
+
+	ResultsWriter();
+	~ResultsWriter();
+
+	// (the writer owns the open file, so it can't be copied)
+	ResultsWriter(const ResultsWriter&) = delete;
+	ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+	errormsg open(std::string fileName1, int rows1, int cols1, const std::vector<std::string> &columnNames, bool singlePrecision, int chunkDays1);
+	void writeCell(int cell, const std::vector<std::vector<double>> &columns);
+	errormsg close();
+
+};
+
+/*
+	This class describes a ResultsReader object, which memory-maps a results file so any range of days of any
+	column of any cell can be read in place.
+*/
+class ResultsReader {
+
+	void *data; // the mapped file
+	size_t dataSize;
+
+	int rows, cols, numColumns, valueSize, chunkDays;
+	std::vector<std::string> columnNames;
+	const int64_t *index;
+
+	void close();
+	const char* getValueAddress(int cell, int column, int day) const;
+
+public:
+
+	ResultsReader();
+	~ResultsReader();
+
+	// (the mapping is owned by the reader, so it can't be copied)
+	ResultsReader(const ResultsReader&) = delete;
+	ResultsReader& operator=(const ResultsReader&) = delete;
+
+	errormsg open(std::string fileName);
+
+	// accessors (the cells are numbered row by row; a cell or column outside the file has no name, series or days)
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	int getNumColumns() const { return numColumns; }
+	std::string getColumnName(int column) const { return (column >= 0 && column < numColumns) ? columnNames[column] : ""; }
+	int findColumn(std::string name) const;
+	int getValueSize() const { return valueSize; }
+	int getChunkDays() const { return chunkDays; }
+	bool hasCell(int cell) const { return cell >= 0 && cell < rows * cols && index[2 * cell] >= 0; }
+	int getNumDays(int cell) const { return hasCell(cell) ? index[2 * cell + 1] : 0; }
+
+	double getValue(int cell, int column, int day) const;
+	void getSeries(int cell, int column, int firstDay, int lastDay, std::vector<double> &values) const;
+
+};
+
+#endif
@@ -0,0 +1,168 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "RungeKuttaMethod.h"
+
+/**
+
+	This file contains an adaptive step size Runge-Kutta solver (the Dormand-Prince 5(4) method, the
+	same as ode45 in MATLAB), and the derivatives of the model's differential equations for it to solve.
+
+	Each step computes a 5th order solution and a 4th order solution from the same 7 derivative
+	evaluations; their difference estimates the error of the step.  If the error is within the
+	tolerances the step is accepted, and either way the next step size is chosen from the error.
+	So the solver takes large steps when the populations are quiet, and small ones when they change
+	quickly (i.e. around the diapause and fruit quality transitions).
+
+	The solver only integrates over the interval it is given, so the simulation calls it once per day
+	(the temperature, and so the rates, only change between days).
+
+*/
+
+// Dormand-Prince coefficients
+static const double C2 = 1.0 / 5, C3 = 3.0 / 10, C4 = 4.0 / 5, C5 = 8.0 / 9;
+static const double A21 = 1.0 / 5;
+static const double A31 = 3.0 / 40, A32 = 9.0 / 40;
+static const double A41 = 44.0 / 45, A42 = -56.0 / 15, A43 = 32.0 / 9;
+static const double A51 = 19372.0 / 6561, A52 = -25360.0 / 2187, A53 = 64448.0 / 6561, A54 = -212.0 / 729;
+static const double A61 = 9017.0 / 3168, A62 = -355.0 / 33, A63 = 46732.0 / 5247, A64 = 49.0 / 176, A65 = -5103.0 / 18656;
+static const double A71 = 35.0 / 384, A73 = 500.0 / 1113, A74 = 125.0 / 192, A75 = -2187.0 / 6784, A76 = 11.0 / 84; // also the 5th order weights
+static const double E1 = 71.0 / 57600, E3 = -71.0 / 16695, E4 = 71.0 / 1920, E5 = -17253.0 / 339200, E6 = 22.0 / 525, E7 = -1.0 / 40; // 5th - 4th order weights
+
+// step size control
+static const double SAFETY = 0.9; // fraction of the step size the error estimate allows, to avoid rejections
+static const double MIN_FACTOR = 0.2, MAX_FACTOR = 5; // limits on how much the step size changes at once
+static const double MIN_STEP = 1E-10; // steps smaller than this are accepted regardless of the error
+
+// method to solve the system of n differential equations given by derivatives from tStart to tEnd
+// y holds the state at tStart, and is updated in place to the state at tEnd
+// only the first numControlled values of the state are used for the error control (i.e. the rest are
+// just along for the ride, like the integrals of the populations)
+// project is called after every accepted step (it can be null), and context is passed to derivatives and project
+void solveDormandPrince(DerivativeFunction derivatives, ProjectFunction project, void* context, double y[], int n, int numControlled,
+							double tStart, double tEnd, AdaptiveStepControl &control) {
+	double k1[RK_MAX_VARIABLES], k2[RK_MAX_VARIABLES], k3[RK_MAX_VARIABLES], k4[RK_MAX_VARIABLES];
+	double k5[RK_MAX_VARIABLES], k6[RK_MAX_VARIABLES], k7[RK_MAX_VARIABLES];
+	double yTemp[RK_MAX_VARIABLES], yNew[RK_MAX_VARIABLES];
+
+	if (n > RK_MAX_VARIABLES || tEnd <= tStart)
+		return;
+
+	double t = tStart;
+	double h = control.stepSize;
+	if (!(h > 0) || h > tEnd - tStart)
+		h = tEnd - tStart;
+
+	derivatives(t, y, k1, context);
+
+	while (t < tEnd) {
+		double hWanted = h; // step size before it is cut to end exactly at tEnd
+		bool lastStep = false;
+		if (t + h >= tEnd || (tEnd - (t + h)) < MIN_STEP) {
+			h = tEnd - t;
+			lastStep = true;
+		}
+
+		for (int i = 0; i < n; i ++)
+			yTemp[i] = y[i] + h * A21 * k1[i];
+		derivatives(t + C2 * h, yTemp, k2, context);
+		for (int i = 0; i < n; i ++)
+			yTemp[i] = y[i] + h * (A31 * k1[i] + A32 * k2[i]);
+		derivatives(t + C3 * h, yTemp, k3, context);
+		for (int i = 0; i < n; i ++)
+			yTemp[i] = y[i] + h * (A41 * k1[i] + A42 * k2[i] + A43 * k3[i]);
+		derivatives(t + C4 * h, yTemp, k4, context);
+		for (int i = 0; i < n; i ++)
+			yTemp[i] = y[i] + h * (A51 * k1[i] + A52 * k2[i] + A53 * k3[i] + A54 * k4[i]);
+		derivatives(t + C5 * h, yTemp, k5, context);
+		for (int i = 0; i < n; i ++)
+			yTemp[i] = y[i] + h * (A61 * k1[i] + A62 * k2[i] + A63 * k3[i] + A64 * k4[i] + A65 * k5[i]);
+		derivatives(t + h, yTemp, k6, context);
+		for (int i = 0; i < n; i ++)
+			yNew[i] = y[i] + h * (A71 * k1[i] + A73 * k3[i] + A74 * k4[i] + A75 * k5[i] + A76 * k6[i]);
+		derivatives(t + h, yNew, k7, context);
+
+		// error estimate, scaled by the tolerances (the step is ok if this is at most 1)
+		double errSum = 0;
+		for (int i = 0; i < numControlled; i ++) {
+			double errI = h * (E1 * k1[i] + E3 * k3[i] + E4 * k4[i] + E5 * k5[i] + E6 * k6[i] + E7 * k7[i]);
+			double scale = control.absTolerance + control.relTolerance * std::max(std::fabs(y[i]), std::fabs(yNew[i]));
+			errSum += (errI / scale) * (errI / scale);
+		}
+		double err = std::sqrt(errSum / std::max(numControlled, 1));
+
+		// next step size (the error is O(h^5))
+		double factor = MAX_FACTOR;
+		if (err > 0)
+			factor = std::min(MAX_FACTOR, std::max(MIN_FACTOR, SAFETY * std::pow(err, -0.2)));
+
+		if (err <= 1 || h <= MIN_STEP || err != err) { // accept the step (if the error is NaN, retrying won't help)
+			t = lastStep ? tEnd : t + h;
+			for (int i = 0; i < n; i ++)
+				y[i] = yNew[i];
+			control.steps ++;
+
+			// the derivative at the end of the step is the first one of the next step, unless the state was changed
+			if (project != NULL && project(y, context))
+				derivatives(t, y, k1, context);
+			else
+				for (int i = 0; i < n; i ++)
+					k1[i] = k7[i];
+
+			// (if the step was cut to end at tEnd, its size says nothing about the next interval)
+			h = h * factor;
+			control.stepSize = lastStep ? std::max(h, hWanted) : h;
+		} else { // reject the step, and try again with a smaller one
+			control.rejectedSteps ++;
+			h = h * std::min(factor, SAFETY);
+		}
+	}
+}
+
+// method to compute the derivatives of the stage populations (in stage index order) for the specified rates
+// these are the same differential equations as the Euler's method solutions in EulersMethod.cpp
+void obtainStageDerivatives(double fertility, const double devRate[], const double mortalityNat[], const CompiledParameters& params,
+								const double stages[], double dStages[]) {
+	const double* mortalityPred = params.mortalityPred;
+	double maleProportion = params.maleProportion;
+
+	// eggs
+	dStages[0] = 0;
+	for (int i = 0; i < 7; i ++)
+		dStages[0] += fertility * params.eggViability[i] * stages[i + 6];
+	dStages[0] -= stages[0] * (mortalityNat[0] + mortalityPred[0] + devRate[0]);
+
+	// instars and pupae
+	for (int i = 1; i < 5; i ++)
+		dStages[i] = devRate[i - 1] * stages[i - 1] - stages[i] * (mortalityNat[i] + mortalityPred[i] + devRate[i]);
+
+	// males
+	dStages[5] = maleProportion * devRate[4] * stages[4] - stages[5] * (mortalityNat[5] + mortalityPred[5]);
+
+	// females
+	dStages[6] = (1 - maleProportion) * devRate[4] * stages[4] - stages[6] * (mortalityNat[6] + mortalityPred[6] + devRate[5]);
+	for (int i = 7; i < 13; i ++) {
+		double femalesXDevelopment = (i < 12) ? devRate[i - 1] : 0; // development rate N/A for females stage 7
+		dStages[i] = devRate[i - 2] * stages[i - 1] - stages[i] * (mortalityNat[i] + mortalityPred[i] + femalesXDevelopment);
+	}
+}
+
+// method to compute the derivative of the fruit quality (see obtainFruitQuality in EulersMethod.cpp)
+// the fruit quality is kept between 0.05 and 1, so the derivative is 0 if it would go past these
+double obtainFruitQualityDerivative(double gt, double fruitQuality, double fruitQLag, const CompiledParameters& params) {
+	double fruitHarvest = 0;
+	if (fruitQLag > params.fruitHarvestCutoff) // if the fruit quality lag steps ago if above the cutoff, harvest the drop
+		fruitHarvest = params.fruitHarvestDrop;
+
+	double dFr_dt = fruitQuality * (params.fruitGtMultiplier / gt - fruitHarvest);
+	if (gt != gt) // if the gt multiplier is NaN, then treat it as 0
+		dFr_dt = fruitQuality * (-fruitHarvest);
+
+	if ((fruitQuality <= 0.05 && dFr_dt < 0) || (fruitQuality >= 1 && dFr_dt > 0))
+		return 0;
+	return dFr_dt;
+}
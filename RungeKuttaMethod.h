@@ -0,0 +1,59 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef RUNGE_KUTTA_METHOD_H
+#define RUNGE_KUTTA_METHOD_H
+
+#include <cmath>
+#include <algorithm>
+#include "CompiledParameters.h"
+
+/**
+
+	Header file for the RungeKuttaMethod.cpp methods, and the AdaptiveStepControl struct
+	used by them.
+	Refer to the commenting and implementation in RungeKuttaMethod.cpp for explanations of
+	what these methods do.
+
+*/
+
+/*
+	This struct holds the settings and the state of the adaptive step size control of
+	solveDormandPrince: the error tolerances, the step size to try next (carried over between
+	calls, so a quiet day starts with the large step of the day before), and counters of the
+	steps taken.
+*/
+struct AdaptiveStepControl {
+
+	double absTolerance, relTolerance; // error allowed per step: absTolerance + relTolerance * |value|
+	double stepSize; // step size to try first in the next call (0 to start with the whole interval)
+	long steps, rejectedSteps; // number of accepted and rejected steps so far
+
+	AdaptiveStepControl() : absTolerance(1E-6), relTolerance(1E-6), stepSize(0), steps(0), rejectedSteps(0) {}
+
+};
+
+// function computing the derivatives dydt of the state y at time t (context is passed through from solveDormandPrince)
+typedef void (*DerivativeFunction)(double t, const double y[], double dydt[], void* context);
+
+// function making the state y valid again after a step (i.e. no negative populations)
+// returns true if y was changed
+typedef bool (*ProjectFunction)(double y[], void* context);
+
+const int RK_MAX_VARIABLES = 32; // max size of the state passed to solveDormandPrince
+
+void solveDormandPrince(DerivativeFunction derivatives, ProjectFunction project, void* context, double y[], int n, int numControlled,
+							double tStart, double tEnd, AdaptiveStepControl &control);
+
+void obtainStageDerivatives(double fertility, const double devRate[], const double mortalityNat[], const CompiledParameters& params,
+								const double stages[], double dStages[]);
+
+double obtainFruitQualityDerivative(double gt, double fruitQuality, double fruitQLag, const CompiledParameters& params);
+
+#endif
@@ -0,0 +1,496 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "SWDCalibration.h"
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+/*
+
+	Implementation of the SWDCalibration class.  The class definition and description (with how the candidates
+	are stopped early) are included in the SWDCalibration header file.
+
+*/
+
+static const int ADULTS_STAGE = NUM_LIFESTAGES; // the "adults" observed stage (males + females) follows the lifestages
+
+// constructor for a calibration of the specified parameters (the parameters not calibrated keep their values), run
+// with the specified daily temperatures
+// there are no parameters to calibrate or observations until they are loaded, and the method defaults to Nelder-Mead
+SWDCalibration::SWDCalibration(const Parameters &baseParamsNew, const std::vector<double> &temperaturesNew) : baseParams(baseParamsNew), temperatures(temperaturesNew),
+		observedStage(6), dt(getDefaultDT(EULER_INTEGRATOR)), integrator(EULER_INTEGRATOR), ignoreFruit(false), ignoreDiapause(false), startDay(-1),
+		method(NELDER_MEAD_METHOD), maxEvaluations(2000), tolerance(1e-4), populationSize(0), seed(1), numThreads(WorkerPool::getDefaultNumWorkers()),
+		bestError(HUGE_VAL), numEvaluations(0), numTerminated(0), numIterations(0) {}
+
+// method to read the parameters to calibrate, and their ranges, from a file (see ParameterRanges for the format)
+// error message is returned if the file can't be read or a line is invalid, otherwise if all is well "Success!" is returned
+errormsg SWDCalibration::loadRanges(std::string rangesFile) {
+	return ranges.load(rangesFile, baseParams);
+}
+
+// method to add a parameter to calibrate, within minValue and maxValue
+// error message is returned if there is no such parameter or the range is empty, otherwise if all is well "Success!" is returned
+errormsg SWDCalibration::addRange(std::string paramName, double minValue, double maxValue) {
+	return ranges.add(paramName, minValue, maxValue, baseParams);
+}
+
+// method to read the observed series from a file: each line is a day (counted from the first day of the temperatures)
+// and the observed population of the stage on that day (i.e. a trap count), separated by a space, tab or comma
+// (blank lines and lines starting with # are skipped)
+// stageName is the stage observed: eggs, instar1, instar2, instar3, pupae, males, females, or adults (males + females)
+// error message is returned if the file can't be read, a line is invalid or there is no such stage, otherwise if all
+// is well "Success!" is returned
+errormsg SWDCalibration::loadObserved(std::string observedFile, std::string stageName) {
+	int stage = std::find(STAGE_NAMES, STAGE_NAMES + NUM_LIFESTAGES, stageName) - STAGE_NAMES;
+	if (stage == NUM_LIFESTAGES && stageName != "adults") // (not a lifestage, so ADULTS_STAGE if it's adults)
+		return "Error: there is no stage called " + stageName;
+
+	std::ifstream fileIn(observedFile.c_str());
+	if (!fileIn)
+		return "Error: could not open the observed series " + observedFile;
+
+	std::vector<std::pair<int, double>> observations;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(fileIn, line)) {
+		lineNumber ++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::istringstream iss(line);
+		int day;
+		double value;
+		if (!(iss >> day >> value) || day < 0)
+			return "Error: invalid observation on line " + std::to_string(lineNumber) + " of " + observedFile;
+		observations.push_back(std::make_pair(day, value));
+	}
+	if (observations.size() == 0)
+		return "Error: " + observedFile + " has no observations";
+
+	std::stable_sort(observations.begin(), observations.end(),
+					 [](const std::pair<int, double> &a, const std::pair<int, double> &b) { return a.first < b.first; });
+	observedStage = stage;
+	observedDays.clear();
+	observedValues.clear();
+	for (int k = 0; k < observations.size(); k ++) {
+		observedDays.push_back(observations[k].first);
+		observedValues.push_back(observations[k].second);
+	}
+	return "Success!";
+}
+
+// method to choose the integration method of the runs (see IntegratorMode)
+// as for a single cell simulator, the integration step is also set to the usual step for the method (see getDefaultDT)
+// (setDT can still be used to change it after)
+void SWDCalibration::setIntegrator(IntegratorMode integratorNew) {
+	integrator = integratorNew;
+	dt = getDefaultDT(integrator);
+}
+
+// method to get the error limit of a candidate of the batch: the batch threshold, or the keepBest-th best error of
+// the candidates finished so far, if that is lower
+double SWDCalibration::getThreshold(Batch &batch) const {
+	pthread_mutex_lock(&batch.lock);
+	double threshold = batch.threshold;
+	if (batch.keepBest > 0 && batch.finished.size() >= batch.keepBest)
+		threshold = std::min(threshold, batch.finished[batch.keepBest - 1]);
+	pthread_mutex_unlock(&batch.lock);
+	return threshold;
+}
+
+// method to get the error of the parameters at the specified point of the unit cube (see the class description)
+// the run is stopped at the first observation at which the partial error is above the threshold of the batch, in which
+// case stopped is set, and the partial error is returned (a lower bound of the error)
+// parameters which aren't valid together (see Parameters::checkMap) have an infinite error
+double SWDCalibration::evaluate(const std::vector<double> &point, Batch &batch, bool &stopped) const {
+	std::map<std::string, double> values = baseParams.getMap();
+	double distance = 0; // squared distance to the cube
+	for (int i = 0; i < ranges.size(); i ++) {
+		double inside = std::min(std::max(point[i], 0.0), 1.0);
+		distance += (point[i] - inside) * (point[i] - inside);
+		values[ranges.getName(i)] = ranges.getValue(i, inside);
+	}
+
+	Parameters params(baseParams);
+	if (params.setMapParams(values, true).compare("Success!") != 0)
+		return HUGE_VAL;
+
+	SWDSimulatorSingle sim(dt, params);
+	sim.setIntegrator(integrator);
+	sim.setDT(dt);
+	sim.setRecorder(RECORD_NONE); // (only the populations on the observed days are needed)
+	SWDCellSingle &cell = sim.getCell();
+	cell.setPhotoperiodTable(photoperiods.findTable(cell.getCompiledParams().latitude)); // (null if the latitude is calibrated)
+
+	// run up to each observed day in turn, adding up the squared differences (the population of a day is the one
+	// printed in the data files, i.e. after the first step of the day)
+	double error = 0;
+	for (int k = 0; k < observedDays.size(); k ++) {
+		double time = observedDays[k] + sim.getDT();
+		if (time > sim.getTimeStep())
+			sim.run(temperatures, time - sim.getTimeStep(), ignoreFruit, ignoreDiapause, startDay);
+
+		double stages[] = {sim.getEggs(), sim.getInst1(), sim.getInst2(), sim.getInst3(), sim.getPupae(), sim.getMales(), sim.getFemales()};
+		double population = (observedStage == ADULTS_STAGE) ? stages[5] + stages[6] : stages[observedStage];
+		error += (population - observedValues[k]) * (population - observedValues[k]);
+
+		if (k < observedDays.size() - 1 && error * (1 + distance) > getThreshold(batch)) {
+			stopped = true;
+			break;
+		}
+	}
+	return error * (1 + distance);
+}
+
+// this method is the task run by the worker pool for each candidate of a batch (the arg is the batch)
+void SWDCalibration::evaluateTask(int task, void *arg) {
+	Batch *batch = (Batch *) arg;
+	bool stopped = false;
+	double error = batch->calibration->evaluate((*batch->points)[task], *batch, stopped);
+	batch->errors[task] = error;
+	batch->stopped[task] = stopped;
+
+	if (!stopped && batch->keepBest > 0) {
+		pthread_mutex_lock(&batch->lock);
+		batch->finished.insert(std::upper_bound(batch->finished.begin(), batch->finished.end(), error), error);
+		pthread_mutex_unlock(&batch->lock);
+	}
+}
+
+// method to evaluate the specified points together on the pool, with the errors put in errors (see Batch for threshold
+// and keepBest; HUGE_VAL and 0 to run every point to the end)
+// the best point found so far is updated with the points which were run to the end
+void SWDCalibration::evaluateBatch(WorkerPool &pool, const std::vector<std::vector<double>> &points, double threshold, int keepBest, std::vector<double> &errors) {
+	Batch batch;
+	batch.calibration = this;
+	batch.points = &points;
+	batch.errors.assign(points.size(), HUGE_VAL);
+	batch.stopped.assign(points.size(), 0);
+	batch.threshold = threshold;
+	batch.keepBest = keepBest;
+	pthread_mutex_init(&batch.lock, NULL);
+
+	pool.submit(points.size(), evaluateTask, (void *) &batch);
+	while (pool.waitForTask() >= 0); // wait for all the candidates
+
+	pthread_mutex_destroy(&batch.lock);
+
+	errors = batch.errors;
+	numEvaluations += points.size();
+	for (int j = 0; j < points.size(); j ++) {
+		if (batch.stopped[j])
+			numTerminated ++;
+		else if (errors[j] < bestError) {
+			bestError = errors[j];
+			bestPoint = points[j];
+		}
+	}
+}
+
+// method to minimize the error with the Nelder-Mead simplex method, starting from a simplex around start
+// each iteration evaluates the reflected, expanded, and outside and inside contracted points together: the simplex
+// only takes a point better than its worst point, so the candidates are stopped once they are worse than that
+// the method stops when the simplex is within tolerance of its best point (in every coordinate), or after maxEvaluations runs
+void SWDCalibration::nelderMead(WorkerPool &pool, const std::vector<double> &start) {
+	int n = ranges.size();
+	std::vector<std::vector<double>> simplex(n + 1, start);
+	for (int i = 0; i < n; i ++)
+		simplex[i + 1][i] += (start[i] + 0.25 <= 1) ? 0.25 : -0.25;
+	std::vector<double> errors;
+	evaluateBatch(pool, simplex, HUGE_VAL, 0, errors);
+
+	std::vector<int> order(n + 1);
+	std::vector<std::vector<double>> candidates(4, std::vector<double>(n));
+	std::vector<double> candidateErrors;
+	while (numEvaluations < maxEvaluations) {
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&errors](int a, int b) { return errors[a] < errors[b]; });
+		int best = order[0], secondWorst = order[n - 1], worst = order[n];
+
+		double size = 0;
+		for (int v = 0; v <= n; v ++) {
+			for (int i = 0; i < n; i ++)
+				size = std::max(size, std::fabs(simplex[v][i] - simplex[best][i]));
+		}
+		if (size <= tolerance)
+			break;
+		numIterations ++;
+
+		// reflected, expanded, outside contracted and inside contracted points
+		std::vector<double> centroid(n, 0);
+		for (int v = 0; v < n; v ++) {
+			for (int i = 0; i < n; i ++)
+				centroid[i] += simplex[order[v]][i] / n;
+		}
+		const double steps[] = {1, 2, 0.5, -0.5};
+		for (int c = 0; c < 4; c ++) {
+			for (int i = 0; i < n; i ++)
+				candidates[c][i] = centroid[i] + steps[c] * (centroid[i] - simplex[worst][i]);
+		}
+		evaluateBatch(pool, candidates, errors[worst], 0, candidateErrors);
+
+		int accepted = -1;
+		if (candidateErrors[0] < errors[best])
+			accepted = (candidateErrors[1] < candidateErrors[0]) ? 1 : 0;
+		else if (candidateErrors[0] < errors[secondWorst])
+			accepted = 0;
+		else if (candidateErrors[0] < errors[worst])
+			accepted = (candidateErrors[2] <= candidateErrors[0]) ? 2 : -1;
+		else
+			accepted = (candidateErrors[3] < errors[worst]) ? 3 : -1;
+
+		if (accepted >= 0) {
+			simplex[worst] = candidates[accepted];
+			errors[worst] = candidateErrors[accepted];
+		} else { // shrink the simplex towards its best point
+			std::vector<std::vector<double>> shrunk;
+			for (int v = 1; v <= n; v ++) {
+				for (int i = 0; i < n; i ++)
+					simplex[order[v]][i] = simplex[best][i] + 0.5 * (simplex[order[v]][i] - simplex[best][i]);
+				shrunk.push_back(simplex[order[v]]);
+			}
+			std::vector<double> shrunkErrors;
+			evaluateBatch(pool, shrunk, HUGE_VAL, 0, shrunkErrors);
+			for (int v = 1; v <= n; v ++)
+				errors[order[v]] = shrunkErrors[v - 1];
+		}
+	}
+}
+
+// method to find the eigenvalues and eigenvectors of the symmetric n x n matrix a (row by row) with the cyclic Jacobi
+// method: the eigenvectors are the columns of vectors, in the order of the eigenvalues in values
+static void symmetricEigen(int n, std::vector<double> a, std::vector<double> &values, std::vector<double> &vectors) {
+	vectors.assign(n * n, 0);
+	for (int i = 0; i < n; i ++)
+		vectors[i * n + i] = 1;
+
+	for (int sweep = 0; sweep < 100; sweep ++) {
+		double offDiagonal = 0, diagonal = 0;
+		for (int i = 0; i < n; i ++) {
+			diagonal += a[i * n + i] * a[i * n + i];
+			for (int j = i + 1; j < n; j ++)
+				offDiagonal += a[i * n + j] * a[i * n + j];
+		}
+		if (offDiagonal <= 1e-30 * diagonal)
+			break;
+
+		for (int p = 0; p < n; p ++) {
+			for (int q = p + 1; q < n; q ++) {
+				if (a[p * n + q] == 0)
+					continue;
+				// rotate rows and columns p and q so a[p][q] becomes 0
+				double theta = (a[q * n + q] - a[p * n + p]) / (2 * a[p * n + q]);
+				double t = (theta >= 0 ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+				double c = 1 / std::sqrt(t * t + 1), s = t * c;
+				for (int k = 0; k < n; k ++) {
+					double akp = a[k * n + p], akq = a[k * n + q];
+					a[k * n + p] = c * akp - s * akq;
+					a[k * n + q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < n; k ++) {
+					double apk = a[p * n + k], aqk = a[q * n + k];
+					a[p * n + k] = c * apk - s * aqk;
+					a[q * n + k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < n; k ++) {
+					double vkp = vectors[k * n + p], vkq = vectors[k * n + q];
+					vectors[k * n + p] = c * vkp - s * vkq;
+					vectors[k * n + q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	values.resize(n);
+	for (int i = 0; i < n; i ++)
+		values[i] = a[i * n + i];
+}
+
+// method to minimize the error with CMA-ES (as in Hansen's tutorial, "The CMA Evolution Strategy", 2016), starting from
+// a search distribution around start with step size 0.3 (of the unit cube)
+// each generation evaluates its candidates together: only the best mu are used, so the candidates are stopped once they
+// are worse than mu candidates already finished
+// the method stops when the step size along every axis of the distribution is within tolerance, or after maxEvaluations runs
+void SWDCalibration::cmaes(WorkerPool &pool, const std::vector<double> &start) {
+	int n = ranges.size();
+	int lambda = (populationSize > 0) ? populationSize : 4 + (int) (3 * std::log((double) n));
+	lambda = std::max(lambda, 2);
+	int mu = lambda / 2;
+
+	// recombination weights and learning rates
+	std::vector<double> weights(mu);
+	for (int i = 0; i < mu; i ++)
+		weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+	double sum = std::accumulate(weights.begin(), weights.end(), 0.0), sumSquares = 0;
+	for (int i = 0; i < mu; i ++) {
+		weights[i] /= sum;
+		sumSquares += weights[i] * weights[i];
+	}
+	double mueff = 1 / sumSquares;
+	double cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+	double cs = (mueff + 2) / (n + mueff + 5);
+	double c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff);
+	double cmu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff));
+	double damps = 1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (n + 1)) - 1) + cs;
+	double chiN = std::sqrt((double) n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+	// the search distribution: mean, step size, covariance C = B diag(D^2) B^T, and the evolution paths
+	std::vector<double> mean(start);
+	double sigma = 0.3;
+	std::vector<double> C(n * n, 0), B(n * n, 0), D(n, 1), eigenvalues;
+	for (int i = 0; i < n; i ++)
+		C[i * n + i] = B[i * n + i] = 1;
+	std::vector<double> pc(n, 0), ps(n, 0);
+
+	std::mt19937_64 generator(seed);
+	std::normal_distribution<double> normal(0.0, 1.0);
+	std::vector<std::vector<double>> candidates(lambda, std::vector<double>(n)), steps(lambda, std::vector<double>(n));
+	std::vector<double> errors, z(n);
+	std::vector<int> order(lambda);
+
+	while (numEvaluations < maxEvaluations) {
+		numIterations ++;
+
+		// sample the generation: candidate = mean + sigma B D z
+		for (int k = 0; k < lambda; k ++) {
+			for (int i = 0; i < n; i ++)
+				z[i] = D[i] * normal(generator);
+			for (int i = 0; i < n; i ++) {
+				steps[k][i] = 0;
+				for (int j = 0; j < n; j ++)
+					steps[k][i] += B[i * n + j] * z[j];
+				candidates[k][i] = mean[i] + sigma * steps[k][i];
+			}
+		}
+		evaluateBatch(pool, candidates, HUGE_VAL, mu, errors);
+
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&errors](int a, int b) { return errors[a] < errors[b]; });
+
+		// move the mean to the weighted mean of the best mu candidates
+		std::vector<double> meanStep(n, 0);
+		for (int k = 0; k < mu; k ++) {
+			for (int i = 0; i < n; i ++)
+				meanStep[i] += weights[k] * steps[order[k]][i];
+		}
+		for (int i = 0; i < n; i ++)
+			mean[i] += sigma * meanStep[i];
+
+		// update the evolution paths (ps with C^-1/2 meanStep = B D^-1 B^T meanStep)
+		std::vector<double> rotated(n, 0);
+		for (int j = 0; j < n; j ++) {
+			for (int i = 0; i < n; i ++)
+				rotated[j] += B[i * n + j] * meanStep[i];
+			rotated[j] /= D[j];
+		}
+		double psNorm = 0;
+		for (int i = 0; i < n; i ++) {
+			double whitened = 0;
+			for (int j = 0; j < n; j ++)
+				whitened += B[i * n + j] * rotated[j];
+			ps[i] = (1 - cs) * ps[i] + std::sqrt(cs * (2 - cs) * mueff) * whitened;
+			psNorm += ps[i] * ps[i];
+		}
+		psNorm = std::sqrt(psNorm);
+		bool hsig = psNorm / std::sqrt(1 - std::pow(1 - cs, 2.0 * numIterations)) / chiN < 1.4 + 2.0 / (n + 1);
+		for (int i = 0; i < n; i ++)
+			pc[i] = (1 - cc) * pc[i] + (hsig ? std::sqrt(cc * (2 - cc) * mueff) : 0) * meanStep[i];
+
+		// update the covariance (rank one and rank mu updates) and the step size
+		for (int i = 0; i < n; i ++) {
+			for (int j = 0; j <= i; j ++) {
+				double rankMu = 0;
+				for (int k = 0; k < mu; k ++)
+					rankMu += weights[k] * steps[order[k]][i] * steps[order[k]][j];
+				double value = (1 - c1 - cmu) * C[i * n + j] + c1 * (pc[i] * pc[j] + (hsig ? 0 : cc * (2 - cc)) * C[i * n + j]) + cmu * rankMu;
+				C[i * n + j] = C[j * n + i] = value;
+			}
+		}
+		sigma *= std::exp((cs / damps) * (psNorm / chiN - 1));
+
+		symmetricEigen(n, C, eigenvalues, B);
+		double maxD = 0;
+		for (int i = 0; i < n; i ++) {
+			D[i] = std::sqrt(std::max(eigenvalues[i], 1e-20));
+			maxD = std::max(maxD, D[i]);
+		}
+		if (sigma * maxD <= tolerance)
+			break;
+	}
+}
+
+// method to calibrate the parameters: the optimizer starts from the base values of the parameters (moved into their
+// ranges), and the best point found is kept (see getBestValues)
+// error message is returned if there is nothing to calibrate, otherwise if all is well "Success!" is returned
+errormsg SWDCalibration::calibrate() {
+	if (ranges.size() == 0 || observedDays.size() == 0 || temperatures.size() == 0)
+		return "Error: there are no parameters to calibrate, no observations, or no temperatures";
+
+	bestPoint.clear();
+	bestError = HUGE_VAL;
+	numEvaluations = numTerminated = numIterations = 0;
+
+	// the table is built before the workers start, since they share it
+	photoperiods.clear();
+	photoperiods.getTable(baseParams.getParameter("latitude"));
+
+	std::vector<double> start(ranges.size());
+	for (int i = 0; i < ranges.size(); i ++) {
+		double fraction = (baseParams.getParameter(ranges.getName(i)) - ranges.getMin(i)) / (ranges.getMax(i) - ranges.getMin(i));
+		start[i] = std::min(std::max(fraction, 0.0), 1.0);
+	}
+
+	WorkerPool pool(numThreads);
+	if (method == CMA_ES_METHOD)
+		cmaes(pool, start);
+	else
+		nelderMead(pool, start);
+
+	if (bestPoint.size() == 0)
+		return "Error: none of the parameters tried were valid";
+	return "Success!";
+}
+
+// method to get the calibrated values of the parameters (in the order of the ranges)
+std::vector<double> SWDCalibration::getBestValues() const {
+	std::vector<double> values;
+	for (int i = 0; i < bestPoint.size(); i ++)
+		values.push_back(ranges.getValue(i, std::min(std::max(bestPoint[i], 0.0), 1.0)));
+	return values;
+}
+
+// method to get the calibrated parameters: the base parameters with the calibrated values
+Parameters SWDCalibration::getBestParams() const {
+	std::map<std::string, double> values = baseParams.getMap();
+	std::vector<double> bestValues = getBestValues();
+	for (int i = 0; i < bestValues.size(); i ++)
+		values[ranges.getName(i)] = bestValues[i];
+
+	Parameters params(baseParams);
+	params.setMapParams(values, true);
+	return params;
+}
+
+// method to print the calibrated parameters to a config file (which can be read like configParams.txt)
+// error message is returned if the file can't be written, otherwise if all is well "Success!" is returned
+errormsg SWDCalibration::printBestParams(std::string outputFile) const {
+	std::ofstream fileOut(outputFile.c_str());
+	if (!fileOut)
+		return "Error: could not create " + outputFile;
+
+	fileOut.precision(10); // (more than the usual 6 digits, so the calibrated values aren't rounded)
+	getBestParams().printToFile(fileOut, true);
+	fileOut.close();
+	if (!fileOut)
+		return "Error: could not write " + outputFile;
+	return "Success!";
+}
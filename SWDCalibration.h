@@ -0,0 +1,141 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef SWD_CALIBRATION_H
+#define SWD_CALIBRATION_H
+
+#include "SWDSimulatorSingle.h"
+#include "WorkerPool.h"
+#include "ParameterRanges.h"
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include <random>
+
+/*
+
+	Header file for SWDCalibration.cpp.  Contains the SWDCalibration class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	Derivative-free optimizer used to calibrate the parameters.
+	NELDER_MEAD_METHOD is the Nelder-Mead simplex method: each iteration evaluates the reflected, expanded and
+	contracted points together (speculatively), so an iteration takes about one run of wall time.
+	CMA_ES_METHOD is the covariance matrix adaptation evolution strategy (Hansen): each generation samples a
+	population of candidates, which are all evaluated together.
+*/
+enum CalibrationMethod { NELDER_MEAD_METHOD, CMA_ES_METHOD };
+
+/*
+	This class describes an SWDCalibration object, which fits some of the parameters of a single cell simulation
+	(each within a range, see ParameterRanges) to an observed series, i.e. trap counts of a site.
+
+	The observed series is a list of (day, value) observations of one stage (or the adults, males + females), and
+	the error of a set of parameters is the sum of the squared differences between the observations and the
+	population of the stage on each observed day (SSE), as it would be printed in the data file of the run.
+
+	The optimizers work in the unit cube of the ranges (0 is the min of each range, 1 the max).  A point outside
+	the cube is run at the nearest point in the cube, and its error is multiplied by 1 + (squared distance to the
+	cube), so the optimizers are pulled back inside.
+
+	The candidates of each iteration (generation) are run in parallel on a pool of workers (see WorkerPool).  Since
+	the partial SSE only grows as the season goes on, a candidate is stopped as soon as its partial SSE shows it
+	can't be used: for Nelder-Mead, when it is worse than the worst point of the simplex, and for CMA-ES, when it
+	is worse than the candidates already selected (the best mu finished so far).  The decisions of the optimizers
+	are the same as if every candidate had been run to the end.
+*/
+class SWDCalibration {
+
+	Parameters baseParams; // parameters of every candidate, apart from those calibrated
+	std::vector<double> temperatures; // daily temperatures (if there are fewer than the days run, they are looped)
+	PhotoperiodTables photoperiods; // daylight hours table of the base latitude (unless the latitude is calibrated)
+
+	ParameterRanges ranges; // parameters calibrated
+	std::vector<int> observedDays; // days of the observations (in order)
+	std::vector<double> observedValues;
+	int observedStage; // stage observed (0 eggs .. 6 females, 7 adults)
+
+	double dt; // integration step (see StepClock)
+	IntegratorMode integrator;
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDay; // day to add the flies at (-1 to add them when diapause is crossed)
+
+	CalibrationMethod method;
+	int maxEvaluations; // runs (started) before the calibration stops
+	double tolerance; // the calibration stops when the points (in the unit cube) are this close together
+	int populationSize; // candidates per generation (CMA-ES), 0 for the usual 4 + 3 ln(numParams)
+	uint64_t seed; // (CMA-ES)
+	int numThreads; // workers running the candidates
+
+	// results of the last calibration
+	std::vector<double> bestPoint; // (in the unit cube)
+	double bestError;
+	int numEvaluations;
+	int numTerminated; // runs stopped early
+	int numIterations;
+
+	/*
+		The candidates evaluated together (an iteration or generation), shared by the tasks of the worker pool.
+		A candidate is stopped once its partial error is above threshold, or above the keepBest-th best error of
+		the candidates finished so far (if keepBest is set).
+	*/
+	struct Batch {
+		SWDCalibration *calibration;
+		const std::vector<std::vector<double>> *points;
+		std::vector<double> errors; // error of each candidate (a lower bound of it, if stopped)
+		std::vector<char> stopped; // whether each candidate was stopped early
+		double threshold;
+		int keepBest;
+		std::vector<double> finished; // errors of the candidates finished so far, sorted (if keepBest is set)
+		pthread_mutex_t lock; // lock for finished
+	};
+
+	static void evaluateTask(int task, void *arg);
+	double evaluate(const std::vector<double> &point, Batch &batch, bool &stopped) const;
+	double getThreshold(Batch &batch) const;
+	void evaluateBatch(WorkerPool &pool, const std::vector<std::vector<double>> &points, double threshold, int keepBest, std::vector<double> &errors);
+	void nelderMead(WorkerPool &pool, const std::vector<double> &start);
+	void cmaes(WorkerPool &pool, const std::vector<double> &start);
+
+public:
+
+	SWDCalibration(const Parameters &baseParamsNew, const std::vector<double> &temperaturesNew);
+
+	errormsg loadRanges(std::string rangesFile);
+	errormsg addRange(std::string paramName, double minValue, double maxValue);
+	errormsg loadObserved(std::string observedFile, std::string stageName);
+
+	errormsg calibrate();
+
+	std::vector<double> getBestValues() const;
+	Parameters getBestParams() const;
+	errormsg printBestParams(std::string outputFile) const;
+
+	// accessors and mutators
+	void setRun(bool ignoreFruitNew, bool ignoreDiapauseNew, int startDayNew) { ignoreFruit = ignoreFruitNew; ignoreDiapause = ignoreDiapauseNew; startDay = startDayNew; }
+	void setIntegrator(IntegratorMode integratorNew);
+	void setDT(double dtNew) { dt = dtNew; }
+	void setMethod(CalibrationMethod methodNew) { method = methodNew; }
+	void setMaxEvaluations(int maxEvaluationsNew) { maxEvaluations = maxEvaluationsNew; }
+	void setTolerance(double toleranceNew) { tolerance = toleranceNew; }
+	void setPopulationSize(int populationSizeNew, uint64_t seedNew = 1) { populationSize = populationSizeNew; seed = seedNew; }
+	void setNumThreads(int numThreadsNew) { numThreads = numThreadsNew > 0 ? numThreadsNew : WorkerPool::getDefaultNumWorkers(); }
+
+	const ParameterRanges& getRanges() const { return ranges; }
+	double getBestError() const { return bestError; }
+	int getNumEvaluations() const { return numEvaluations; }
+	int getNumTerminated() const { return numTerminated; }
+	int getNumIterations() const { return numIterations; }
+
+};
+
+#endif
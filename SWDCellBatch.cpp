@@ -0,0 +1,265 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "SWDCellBatch.h"
+#include <cstring>
+
+/*
+
+	Implementation of the SWDCellBatch class methods.  Class definition is included in the
+	SWDCellBatch header file.  The overall class description is also included in the header
+	file, right above the class definition.
+
+	The vectorized integration methods below are the same equations as in EulersMethod.cpp,
+	written for LANES cells at a time with the GCC vector extensions.  The operations are done
+	in the same order as the scalar methods, so the results are identical.  The if statements of
+	the scalar methods become masks: a comparison of two vectors gives a vector of 0 (false) or
+	-1 (true) per lane, and (mask ? a : b) picks a or b per lane.
+
+	The target_clones attribute compiles the vectorized methods twice, for AVX2 and for the
+	baseline (SSE2 on x86-64), and picks the right version when the program starts.  FMA is
+	deliberately not enabled, since fused multiply-adds would round differently from the scalar code.
+
+*/
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__clang__)
+#define SWD_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SWD_TARGET_CLONES
+#endif
+
+typedef double vdouble __attribute__((vector_size(4 * sizeof(double)))); // LANES doubles
+typedef long long vmask __attribute__((vector_size(4 * sizeof(long long)))); // result of comparing two vdoubles
+typedef double vdoubleUnaligned __attribute__((vector_size(4 * sizeof(double)), aligned(sizeof(double)), may_alias)); // (for loads)
+
+// the helper methods below never pass or return a vector by value: without AVX, GCC warns (-Wpsabi) that the ABI
+// of doing that changed, which can't be reliably silenced with a pragma, so vectors are passed by reference, and
+// the results are written to a reference argument
+
+// methods to load/store a vector from/to (not necessarily aligned) arrays
+static inline const vdoubleUnaligned& loadVec(const double* p) {
+	return *(const vdoubleUnaligned*) p;
+}
+
+static inline void storeVec(double* p, const vdouble &v) {
+	std::memcpy(p, &v, sizeof(v));
+}
+
+// vectorized obtainInstX
+static inline void obtainInstXVec(const vdouble &stageX_1Development, const vdouble &instXMortalityNat, const vdouble &instXMortalityPred, const vdouble &instXDevelopment,
+								const vdouble &stageX_1I, const vdouble &instXI, const vdouble &step, vdouble &result) {
+	vdouble dIX_dt = stageX_1Development * stageX_1I - instXI * (instXMortalityNat + instXMortalityPred + instXDevelopment);
+	vdouble newVal = instXI + dIX_dt * step;
+
+	vdouble epsilon = {1E-15, 1E-15, 1E-15, 1E-15};
+	vdouble zero = {0, 0, 0, 0};
+
+	// keep the previous value if it would go negative, or if the relative change is negligible
+	// (the ratios are only used when instXI != 0, so dividing by 0 in the other lanes doesn't matter)
+	vmask keep = (newVal < zero) | ((instXI != zero) & ((newVal / instXI < epsilon) | (instXI / newVal < epsilon)));
+	result = keep ? instXI : newVal;
+}
+
+// vectorized obtainFemalesX
+static inline void obtainFemalesXVec(const vdouble &maleProportion, const vdouble &stageX_1Development, const vdouble &stageX_1I, const vdouble &femalesXMortalityNat,
+									const vdouble &femalesXMortalityPred, const vdouble &femalesXDevelopment, const vdouble &femalesXI, const vdouble &step, vdouble &result) {
+	vdouble dFX_dt = (1 - maleProportion) * stageX_1Development * stageX_1I - femalesXI * (femalesXMortalityNat + femalesXMortalityPred + femalesXDevelopment);
+	result = femalesXI + dFX_dt * step;
+}
+
+// method to set the negative lanes of a vector to 0 (in place)
+static inline void clampToZero(vdouble &v) {
+	vdouble zero = {0, 0, 0, 0};
+	v = (v < zero) ? zero : v;
+}
+
+// vectorized obtainFruitQuality, over all the lanes of the arrays passed in
+// fruitQuality holds the fruit qualities of the previous timestep, and is updated in place
+SWD_TARGET_CLONES
+void batchFruitQuality(int numLanes, const double* gt, double* fruitQuality, const double* fruitQLag, double dt,
+					   const double* fruitHarvestCutoff, const double* fruitHarvestDrop, const double* gtMultiplier) {
+	vdouble step = {dt, dt, dt, dt};
+	vdouble zero = {0, 0, 0, 0};
+	vdouble minQuality = {0.05, 0.05, 0.05, 0.05};
+	vdouble maxQuality = {1, 1, 1, 1};
+
+	for (int c = 0; c < numLanes; c += 4) {
+		vdouble gtV = loadVec(gt + c);
+		vdouble fruitQualityI = loadVec(fruitQuality + c);
+
+		vdouble fruitHarvest = (loadVec(fruitQLag + c) > loadVec(fruitHarvestCutoff + c)) ? loadVec(fruitHarvestDrop + c) : zero;
+		vdouble dFr_dt = fruitQualityI * (loadVec(gtMultiplier + c) / gtV - fruitHarvest);
+		dFr_dt = (gtV != gtV) ? fruitQualityI * (-fruitHarvest) : dFr_dt; // if gt is NaN, treat it as 0
+
+		vdouble fruitDiam = fruitQualityI + dFr_dt * step;
+		fruitDiam = (fruitDiam < minQuality) ? minQuality : fruitDiam;
+		fruitDiam = (fruitDiam > maxQuality) ? maxQuality : fruitDiam;
+
+		storeVec(fruitQuality + c, fruitDiam);
+	}
+}
+
+// vectorized population update (see SWDPopulation::applyStepRates) over all the lanes of the arrays passed in
+// stages is updated in place; lanes where active is 0 are left unchanged
+SWD_TARGET_CLONES
+void batchPopulationStep(int numLanes, double* stages, const double* fertility, const double* devRate, const double* mortalityNat,
+						 const double* mortalityPred, const double* eggViability, const double* maleProportion, const double* active, double dt) {
+	vdouble step = {dt, dt, dt, dt};
+	vdouble zero = {0, 0, 0, 0};
+	vdouble maleProportion_advFemStage = zero; // no males develop from previous female lifestages
+
+	for (int c = 0; c < numLanes; c += 4) {
+		vdouble pop[13], dev[11], mortNat[13], mortPred[13];
+		for (int i = 0; i < 13; i ++) {
+			pop[i] = loadVec(stages + i * numLanes + c);
+			mortNat[i] = loadVec(mortalityNat + i * numLanes + c);
+			mortPred[i] = loadVec(mortalityPred + i * numLanes + c);
+			if (i < 11)
+				dev[i] = loadVec(devRate + i * numLanes + c);
+		}
+		vdouble maleProp = loadVec(maleProportion + c);
+
+		vdouble newPop[13];
+
+		// females (all computed from the populations of the previous dt)
+		obtainFemalesXVec(maleProp, dev[4], pop[4], mortNat[6], mortPred[6], dev[5], pop[6], step, newPop[6]);
+		for (int i = 1; i < 7; i ++) {
+			vdouble femalesXDevelopment = (i < 7 - 1) ? dev[i + 5] : zero; // development rate N/A for females stage 7
+			obtainFemalesXVec(maleProportion_advFemStage, dev[i + 4], pop[i + 5], mortNat[i + 6], mortPred[i + 6],
+							  femalesXDevelopment, pop[i + 6], step, newPop[i + 6]);
+		}
+
+		// males (obtainMales)
+		newPop[5] = pop[5] + (maleProp * dev[4] * pop[4] - pop[5] * (mortNat[5] + mortPred[5])) * step;
+
+		// pupae (obtainPupae)
+		newPop[4] = pop[4] + (dev[3] * pop[3] - pop[4] * (mortNat[4] + mortPred[4] + dev[4])) * step;
+
+		// instars
+		obtainInstXVec(dev[2], mortNat[3], mortPred[3], dev[3], pop[2], pop[3], step, newPop[3]);
+		obtainInstXVec(dev[1], mortNat[2], mortPred[2], dev[2], pop[1], pop[2], step, newPop[2]);
+		obtainInstXVec(dev[0], mortNat[1], mortPred[1], dev[1], pop[0], pop[1], step, newPop[1]);
+
+		// eggs (obtainEggs)
+		vdouble fert = loadVec(fertility + c);
+		vdouble dE_dt = zero;
+		for (int i = 0; i < 7; i ++)
+			dE_dt += fert * loadVec(eggViability + i * numLanes + c) * pop[i + 6];
+		dE_dt -= pop[0] * (mortNat[0] + mortPred[0] + dev[0]);
+		newPop[0] = pop[0] + dE_dt * step;
+
+		// no negative populations (the instars never go negative, see obtainInstX)
+		clampToZero(newPop[0]);
+		for (int i = 3; i < 13; i ++)
+			clampToZero(newPop[i]);
+
+		// cells still in diapause keep their populations
+		vmask isActive = loadVec(active + c) != zero;
+		for (int i = 0; i < 13; i ++)
+			storeVec(stages + i * numLanes + c, isActive ? newPop[i] : pop[i]);
+	}
+}
+
+// constructor taking the list of cells to step together
+// the per-cell parameters needed by the integration are read from the cells here, so the cells' parameters
+// should not be changed while they are in the batch
+SWDCellBatch::SWDCellBatch(const std::vector<SWDCellSingle*> &cellsNew) : cells(cellsNew) {
+	numCells = cells.size();
+	numLanes = ((numCells + LANES - 1) / LANES) * LANES;
+
+	// padding lanes have no flies and are never active, so their values don't matter (but should be finite)
+	mortalityPred.assign(13 * numLanes, 0);
+	eggViability.assign(7 * numLanes, 0);
+	maleProportion.assign(numLanes, 0);
+	fruitHarvestCutoff.assign(numLanes, 1);
+	fruitHarvestDrop.assign(numLanes, 0);
+	fruitGtMultiplier.assign(numLanes, 0);
+
+	stages.assign(13 * numLanes, 0);
+	fruitQuality.assign(numLanes, 0.05);
+	fruitQLag.assign(numLanes, 0.05);
+	gt.assign(numLanes, 1);
+	fertility.assign(numLanes, 0);
+	devRate.assign(11 * numLanes, 0);
+	mortalityNat.assign(13 * numLanes, 0);
+	active.assign(numLanes, 0);
+
+	for (int c = 0; c < numCells; c ++) {
+		const CompiledParameters& params = cells[c]->getCompiledParams();
+
+		for (int i = 0; i < 13; i ++)
+			mortalityPred[i * numLanes + c] = params.mortalityPred[i];
+		for (int i = 0; i < 7; i ++)
+			eggViability[i * numLanes + c] = params.eggViability[i];
+		maleProportion[c] = params.maleProportion;
+
+		fruitHarvestCutoff[c] = params.fruitHarvestCutoff;
+		fruitHarvestDrop[c] = params.fruitHarvestDrop;
+		fruitGtMultiplier[c] = params.fruitGtMultiplier;
+	}
+}
+
+// method to move all the cells forward one timestep
+// temperatures has the temperature of each cell for the timestep; the other arguments are the same as
+// for SWDCellSingle::stepForward (and as there, the kernel can be chosen once per run with getStepFunction)
+void SWDCellBatch::stepForward(const double temperatures[], bool ignoreFruit, bool ignoreDiapause, const StepClock &clock) {
+	(this->*getStepFunction(ignoreFruit, ignoreDiapause))(temperatures, clock);
+}
+
+// method to get the stepForward kernel for the specified submodel switches
+SWDCellBatch::StepFunction SWDCellBatch::getStepFunction(bool ignoreFruit, bool ignoreDiapause) const {
+	StepFunction kernels[] = {&SWDCellBatch::stepForwardKernel<false, false>, &SWDCellBatch::stepForwardKernel<false, true>,
+								&SWDCellBatch::stepForwardKernel<true, false>, &SWDCellBatch::stepForwardKernel<true, true>};
+	return kernels[(ignoreFruit ? 2 : 0) + (ignoreDiapause ? 1 : 0)];
+}
+
+// method to move all the cells forward one timestep, with the submodel switches given by the template arguments
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDCellBatch::stepForwardKernel(const double temperatures[], const StepClock &clock) {
+
+	// fruit quality lag and G(T) of each cell
+	for (int c = 0; c < numCells; c ++) {
+		fruitQLag[c] = cells[c]->beginStep(temperatures[c], IGNORE_FRUIT, IGNORE_DIAPAUSE, clock);
+		fruitQuality[c] = cells[c]->getFruitQuality(); // (beginStep restarts the fruit quality at the start of the year)
+		gt[c] = getGT(cells[c]->getCompiledParams().fruitBaseTemp, temperatures[c]);
+	}
+
+	batchFruitQuality(numLanes, &gt[0], &fruitQuality[0], &fruitQLag[0], clock.dt, &fruitHarvestCutoff[0], &fruitHarvestDrop[0], &fruitGtMultiplier[0]);
+
+	// diapause switches and rates of each cell
+	StepRates stepRates;
+	double cellStages[13];
+	for (int c = 0; c < numCells; c ++) {
+		cells[c]->setStepFruitQuality(fruitQuality[c], clock);
+
+		active[c] = cells[c]->computeStepRates<IGNORE_FRUIT, IGNORE_DIAPAUSE>(clock, stepRates) ? 1 : 0;
+		if (active[c] != 0) {
+			fertility[c] = stepRates.fertility;
+			for (int i = 0; i < 11; i ++)
+				devRate[i * numLanes + c] = stepRates.devRate[i];
+			for (int i = 0; i < 13; i ++)
+				mortalityNat[i * numLanes + c] = stepRates.mortalityNat[i];
+		}
+
+		// the populations can change outside of the integration (i.e. when the initial flies are added),
+		// so they are always read from the cell
+		cells[c]->getStages(cellStages);
+		for (int i = 0; i < 13; i ++)
+			stages[i * numLanes + c] = cellStages[i];
+	}
+
+	batchPopulationStep(numLanes, &stages[0], &fertility[0], &devRate[0], &mortalityNat[0], &mortalityPred[0],
+						&eggViability[0], &maleProportion[0], &active[0], clock.dt);
+
+	// hand the new populations back to the cells and record them
+	for (int c = 0; c < numCells; c ++) {
+		for (int i = 0; i < 13; i ++)
+			cellStages[i] = stages[i * numLanes + c];
+		cells[c]->setStages(cellStages);
+		cells[c]->recordStep(clock);
+	}
+}
@@ -0,0 +1,76 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef SWD_CELL_BATCH_H
+#define SWD_CELL_BATCH_H
+
+#include "SWDCellSingle.h"
+
+/*
+
+	This class describes an SWDCellBatch object, which steps many cells forward at once.
+	Stepping one cell at a time (SWDCellSingle::stepForward) spends most of its time on the
+	numerical integration of the fruit quality and the 13 lifestage populations, which is the
+	same arithmetic for every cell.  The batch stores the fruit qualities, populations and rates of
+	all of its cells in structure-of-arrays form (one array per lifestage, with one entry per cell)
+	and does the integration for all the cells together with vector instructions.  The vector code
+	is compiled for both AVX2 and the baseline SSE2, and the version to use is chosen at runtime
+	for the machine the simulation runs on.
+
+	The branchy parts of a timestep (the fruit quality lag, the diapause switch functions, the
+	daily and fruit rate caches and the recording of the results) are still done by each cell,
+	using the same methods as SWDCellSingle::stepForward, so a batch produces exactly the same
+	results as stepping the cells one at a time.  Cells whose flies are still in diapause are
+	masked out of the integration (i.e. their populations don't change that dt).
+
+	The cells are not owned by the batch: they must outlive it, and should not be stepped
+	by anything else while they are in a batch.
+
+	Methods described in-code, in the implementation file SWDCellBatch.cpp.
+
+*/
+
+class SWDCellBatch {
+
+	static const int LANES = 4; // cells per vector (the arrays are padded to a multiple of this)
+
+	std::vector<SWDCellSingle*> cells; // cells in the batch
+	int numCells, numLanes; // number of cells, and number of cells rounded up to a multiple of LANES
+
+	// the arrays are indexed [stage * numLanes + cell] (or just [cell] for the per-cell values)
+
+	// per-cell parameters (set once)
+	std::vector<double> mortalityPred, eggViability, maleProportion;
+	std::vector<double> fruitHarvestCutoff, fruitHarvestDrop, fruitGtMultiplier;
+
+	// per-timestep values
+	std::vector<double> stages; // populations of each lifestage
+	std::vector<double> fruitQuality, fruitQLag, gt;
+	std::vector<double> fertility, devRate, mortalityNat; // rates (see StepRates)
+	std::vector<double> active; // 1 if the flies of the cell are out of diapause, otherwise 0
+
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void stepForwardKernel(const double temperatures[], const StepClock &clock);
+
+public:
+
+	SWDCellBatch(const std::vector<SWDCellSingle*> &cellsNew);
+
+	// a stepForward kernel for one combination of the submodel switches (see SWDCellSingle::StepFunction)
+	typedef void (SWDCellBatch::*StepFunction)(const double temperatures[], const StepClock &clock);
+
+	StepFunction getStepFunction(bool ignoreFruit, bool ignoreDiapause) const;
+	void stepForward(const double temperatures[], bool ignoreFruit, bool ignoreDiapause, const StepClock &clock);
+
+	int getNumCells() const { return numCells; }
+	SWDCellSingle& getCell(int index) { return *cells[index]; }
+
+};
+
+#endif
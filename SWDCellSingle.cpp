@@ -8,12 +8,37 @@
 
 */
 
+const char* const STAGE_NAMES[NUM_LIFESTAGES] = {"eggs", "instar1", "instar2", "instar3", "pupae", "males", "females"};
+
+// method to get the integrator for a name given on the command line (see SWDCellSingle.h)
+bool parseIntegratorMode(const std::string &name, IntegratorMode &mode) {
+	if (name == "euler")
+		mode = EULER_INTEGRATOR;
+	else if (name == "exponential")
+		mode = EXPONENTIAL_INTEGRATOR;
+	else if (name == "rk45")
+		mode = RUNGE_KUTTA_INTEGRATOR;
+	else
+		return false;
+	return true;
+}
+
+// method to get the usual integration step for an integrator (see SWDCellSingle.h)
+double getDefaultDT(IntegratorMode mode) {
+	return (mode == EULER_INTEGRATOR) ? 0.05 : 1;
+}
+
 // Constructor taking a parameters object specifying the model parameters, and the
 // initial temperature for the simulation
 SWDCellSingle::SWDCellSingle(Parameters paramsNew, double newTemp) {
 	dayCrossedMaxFruit = -1;
 	ignoreFruit = true;
 	ignoreDiapause = true;
+	integrator = EULER_INTEGRATOR;
+	recorderMode = RECORD_EVERY_STEP;
+	recordEveryDays = 1;
+	statistics = STATS_NONE;
+	degreeDayBase = 10;
 
 	fruitQualities[0] = 0.05; // fruit quality starts at 0.05, at the beginning of the year
 	currentFruitQ = 0.05; // default starting fruit quality of 0.05
@@ -29,13 +54,16 @@ SWDCellSingle::SWDCellSingle(Parameters paramsNew, double newTemp) {
 		temp = 15;
 		population = SWDPopulation();
 	}
+	compiledParams.compile(params);
 	
 	resetTime();
 
 	killAllFruit = false; // fruit quality has not passed the cutoff yet
 	
-	for (int i = 0; i < 10; i ++) 
+	for (int i = 0; i < NUM_THRESHOLDS; i ++) {
+		thresholdPop[i] = HUGE_VAL; // no thresholds until they are set
 		thresholdPopDay[i] = -1;
+	}
 
 	if (newTemp != 888) // 888 is the error state temperature
 		temp = newTemp;
@@ -44,7 +72,10 @@ SWDCellSingle::SWDCellSingle(Parameters paramsNew, double newTemp) {
 // method to change the value of a single specified parameter (specified by name) 
 // a message is returned indicating success; or specifying the error if one occured
 errormsg SWDCellSingle::setSingleParameter(std::string &param, double newVal) {
-	return params.setParameter(param, newVal);
+	errormsg status = params.setParameter(param, newVal);
+	compiledParams.compile(params); // keep the compiled parameters in sync
+	population.invalidateRates(); // and recompute the rates with the new parameters
+	return status;
 }
 
 // method to get the value of a single specified parameter
@@ -54,21 +85,107 @@ double SWDCellSingle::getSpecificParameter(std::string &param) const {
 
 // method to move the cell forward one timestep
 // the temperature of the timestep is specified, and whether or not to ignore diapause and fruit submodels,
-// and the integration step (dt -- the length of one timestep), and the current timestep 
-void SWDCellSingle::stepForward(double temperature, bool ignoreFruitNew, bool ignoreDiapauseNew, double dt, double timeStep) {	
+// and the simulation clock (the current day and step, and the integration step dt -- the length of one timestep)
+// note: this chooses the kernel every step; to step many times with the same settings, get the kernel once
+// with getStepFunction instead
+void SWDCellSingle::stepForward(double temperature, bool ignoreFruitNew, bool ignoreDiapauseNew, const StepClock &clock) {	
+	(this->*getStepFunction(ignoreFruitNew, ignoreDiapauseNew))(temperature, clock);
+}
+
+// method to get the stepForward kernel for the current integrator and the specified submodel switches
+// (the integrator and the switches are fixed for a run, so the kernel doesn't need to check them every step)
+SWDCellSingle::StepFunction SWDCellSingle::getStepFunction(bool ignoreFruitNew, bool ignoreDiapauseNew) const {
+	int combo = (ignoreFruitNew ? 2 : 0) + (ignoreDiapauseNew ? 1 : 0);
+	if (integrator == EXPONENTIAL_INTEGRATOR) {
+		StepFunction kernels[] = {&SWDCellSingle::stepForwardExact<false, false>, &SWDCellSingle::stepForwardExact<false, true>,
+									&SWDCellSingle::stepForwardExact<true, false>, &SWDCellSingle::stepForwardExact<true, true>};
+		return kernels[combo];
+	}
+	if (integrator == RUNGE_KUTTA_INTEGRATOR) {
+		StepFunction kernels[] = {&SWDCellSingle::stepForwardAdaptive<false, false>, &SWDCellSingle::stepForwardAdaptive<false, true>,
+									&SWDCellSingle::stepForwardAdaptive<true, false>, &SWDCellSingle::stepForwardAdaptive<true, true>};
+		return kernels[combo];
+	}
+	StepFunction kernels[] = {&SWDCellSingle::stepForwardEuler<false, false>, &SWDCellSingle::stepForwardEuler<false, true>,
+								&SWDCellSingle::stepForwardEuler<true, false>, &SWDCellSingle::stepForwardEuler<true, true>};
+	return kernels[combo];
+}
+
+// method to move the cell forward one timestep with Euler's method (see stepForward for the arguments)
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDCellSingle::stepForwardEuler(double temperature, const StepClock &clock) {
+	double fruitQLag = beginStep(temperature, IGNORE_FRUIT, IGNORE_DIAPAUSE, clock);
+	
+	double gt = getGT(compiledParams.fruitBaseTemp, temperature);
+	
+	setStepFruitQuality(obtainFruitQuality(gt, currentFruitQ, fruitQLag, clock.dt, compiledParams), clock); // calculate current fruit quality
+	
+	population.computePopulation<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temperature, currentFruitQ, compiledParams, clock); // update the population
+	
+	recordStep(clock);
+}
+
+// method to move the cell forward one timestep with the exponential integrator (see stepForward for the arguments)
+// the fruit quality and the populations are solved exactly over the step, assuming the rates are constant;
+// the populations use the fruit quality in the middle of the step, since it changes (slowly) over the step
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDCellSingle::stepForwardExact(double temperature, const StepClock &clock) {
+	double fruitQLag = beginStep(temperature, IGNORE_FRUIT, IGNORE_DIAPAUSE, clock);
+	double step = clock.dt;
+
+	double gt = getGT(compiledParams.fruitBaseTemp, temperature);
+
+	double midFruitQ = obtainFruitQualityExact(gt, currentFruitQ, fruitQLag, step / 2, compiledParams);
+	setStepFruitQuality(obtainFruitQualityExact(gt, currentFruitQ, fruitQLag, step, compiledParams), clock);
+
+	double stageIntegrals[13];
+	population.computePopulationExact<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temperature, midFruitQ, compiledParams, clock, stageIntegrals);
+
+	recordIntegrals(clock, stageIntegrals);
+}
+
+// method to move the cell forward one timestep with the Runge-Kutta integrator (see stepForward for the arguments)
+// the fruit quality and the populations are solved together, with as many steps as needed for the tolerances
+// (the step is usually a whole day, and the output is still one datapoint per step)
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDCellSingle::stepForwardAdaptive(double temperature, const StepClock &clock) {
+	double fruitQLag = beginStep(temperature, IGNORE_FRUIT, IGNORE_DIAPAUSE, clock);
+
+	double gt = getGT(compiledParams.fruitBaseTemp, temperature);
+
+	double fruitQuality = currentFruitQ;
+	double stageIntegrals[13];
+	population.computePopulationAdaptive<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temperature, gt, fruitQLag, fruitQuality, compiledParams, clock, stageIntegrals, stepControl);
+	setStepFruitQuality(fruitQuality, clock);
+
+	recordIntegrals(clock, stageIntegrals);
+}
+
+// method to end a timestep of the exponential or Runge-Kutta integrators, given the integral of each stage
+// population over the step (which are added to the cumulative populations), and the clock of the step
+void SWDCellSingle::recordIntegrals(const StepClock &clock, const double stageIntegrals[]) {
+	double stageTotals[7];
+	for (int i = 0; i < 6; i ++)
+		stageTotals[i] = stageIntegrals[i];
+	stageTotals[6] = sumDoubleArray(stageIntegrals + 6, 7); // all the female stages
+
+	recordPopulations(clock, stageTotals);
+}
+
+// method to start a timestep: the datafields are reset to those passed in (see stepForward), and the fruit quality
+// lag is updated for the current timestep
+// returns the fruit quality timelag timesteps ago (which is needed to compute the current fruit quality)
+double SWDCellSingle::beginStep(double temperature, bool ignoreFruitNew, bool ignoreDiapauseNew, const StepClock &clock) {
 	// reset datafields to those passed in
 	ignoreFruit = ignoreFruitNew;
 	ignoreDiapause = ignoreDiapauseNew;
 	temp = temperature;
 	
 	// get fruit parameters for the calculations
-	double fruitBaseTemp = params.getParameter("fruit base temp");
-	double fruitTimeLag = params.getParameter("fruit time lag");
-	double fruitHarvestCutoff = params.getParameter("fruit harvest cutoff");
-	
-	double gt = getGT(fruitBaseTemp, temperature);
+	double fruitTimeLag = compiledParams.fruitTimeLag;
+	double fruitHarvestCutoff = compiledParams.fruitHarvestCutoff;
 	
-	int index = ((int) timeStep) % 365;
+	int index = clock.day % 365;
 	double fruitQLag = 0.05;
 	if (index - fruitTimeLag > 0) { // if timelag timesteps have passed in the year
 		fruitQLag = fruitQualities[(int) (index - fruitTimeLag)]; // get the fruit quality timelag timesteps ago
@@ -82,41 +199,98 @@ void SWDCellSingle::stepForward(double temperature, bool ignoreFruitNew, bool ig
 	
 	if (killAllFruit)
 		fruitQLag = 1; // this is so that the fruit quality does not start increasing again during the year, after quality has reached the cutoff
-	
-	currentFruitQ = obtainFruitQuality(gt, currentFruitQ, fruitQLag, dt, params); // calculate current fruit quality
+
+	return fruitQLag;
+}
+
+// method to set the fruit quality of the current timestep (computed from the fruit quality lag returned by beginStep)
+void SWDCellSingle::setStepFruitQuality(double fruitQuality, const StepClock &clock) {
+	currentFruitQ = fruitQuality;
 	
 	if (round2Decimals(currentFruitQ) == 1 && dayCrossedMaxFruit == -1)
-		dayCrossedMaxFruit = timeStep;
+		dayCrossedMaxFruit = clock.getTime();
 	
-	fruitQualities[((int) timeStep) % 365] = currentFruitQ; // store the fruit quality for the current timestep in the array
+	fruitQualities[clock.day % 365] = currentFruitQ; // store the fruit quality for the current timestep in the array
 	// Note: only one fruit quality is stored per timestep (i.e. not one value per dt)
+}
+
+// method to choose which steps are recorded in the data series (see RecorderMode)
+// everyDays is the number of days between the recorded points, for RECORD_EVERY_N_DAYS
+void SWDCellSingle::setRecorder(RecorderMode mode, int everyDays) {
+	recorderMode = mode;
+	recordEveryDays = everyDays > 0 ? everyDays : 1;
+}
+
+// method to check whether the step of the specified clock is recorded in the data series
+bool SWDCellSingle::isRecorded(const StepClock &clock) const {
+	switch (recorderMode) {
+		case RECORD_EVERY_STEP: return true;
+		case RECORD_DAILY: return clock.substep == 0;
+		case RECORD_EVERY_N_DAYS: return clock.substep == 0 && clock.day % recordEveryDays == 0;
+		default: return false;
+	}
+}
+
+// method to make room in the data series for the points recorded over the specified number of timesteps
+// after the current one (with stepsPerDay steps per day), so that recording the steps of a run doesn't
+// allocate memory (the series grow at least geometrically, so reserving before every run of a few steps is still cheap)
+void SWDCellSingle::reserveSteps(long numSteps, int stepsPerDay) {
+	long numPoints = numSteps; // RECORD_EVERY_STEP
+	if (recorderMode == RECORD_DAILY)
+		numPoints = numSteps / stepsPerDay + 1;
+	else if (recorderMode == RECORD_EVERY_N_DAYS)
+		numPoints = numSteps / ((long) stepsPerDay * recordEveryDays) + 1;
+	else if (recorderMode == RECORD_NONE)
+		return;
+
+	XYSeries* allSeries[] = {&eggSeries, &inst1Series, &inst2Series, &inst3Series, &pupaeSeries, &malesSeries, &femalesSeries, &fruitQualitySeries};
+	for (int i = 0; i < 8 + 7; i ++) {
+		XYSeries &series = (i < 8) ? *allSeries[i] : femaleStageSeries[i - 8];
+		size_t needed = series.size() + numPoints;
+		if (series.capacity() < needed)
+			series.reserve(std::max(needed, 2 * series.capacity()));
+	}
+}
+
+// method to add the current populations and fruit quality to the data series, and update the cumulative
+// totals and max populations (this is the end of a timestep)
+void SWDCellSingle::recordStep(const StepClock &clock) {
+	double dt = clock.dt;
+	double stageTotals[] = {getEggs() * dt, getInst1() * dt, getInst2() * dt, getInst3() * dt, getPupae() * dt, getMales() * dt, getFemales() * dt};
+	recordPopulations(clock, stageTotals);
+}
+
+// same as above, but the amounts to add to the cumulative totals of each stage (eggs, instar1..3, pupae, males, females) 
+// over the timestep are passed in
+void SWDCellSingle::recordPopulations(const StepClock &clock, const double stageTotals[]) {
+	double timeStep = clock.getTime();
 	
-	population.computePopulation(temperature, currentFruitQ, params, ignoreFruit, ignoreDiapause, dt, timeStep); // update the population
-	
-	// update the stage-specific population data series
-	eggSeries.push_back(XYPair(timeStep, getEggs()));
-	inst1Series.push_back(XYPair(timeStep, getInst1()));
-	inst2Series.push_back(XYPair(timeStep, getInst2()));
-	inst3Series.push_back(XYPair(timeStep, getInst3()));
-	pupaeSeries.push_back(XYPair(timeStep, getPupae()));
-	malesSeries.push_back(XYPair(timeStep, getMales()));
-	femalesSeries.push_back(XYPair(timeStep, getFemales()));
-	
-	const double* femStagePopulation = getFemStages();
-	for (int i = 0; i < 7; i ++)
-		femaleStageSeries[i].push_back(XYPair(timeStep, femStagePopulation[i]));
+	// update the stage-specific population data series (if this step is recorded, see RecorderMode)
+	if (isRecorded(clock)) {
+		eggSeries.push_back(XYPair(timeStep, getEggs()));
+		inst1Series.push_back(XYPair(timeStep, getInst1()));
+		inst2Series.push_back(XYPair(timeStep, getInst2()));
+		inst3Series.push_back(XYPair(timeStep, getInst3()));
+		pupaeSeries.push_back(XYPair(timeStep, getPupae()));
+		malesSeries.push_back(XYPair(timeStep, getMales()));
+		femalesSeries.push_back(XYPair(timeStep, getFemales()));
+		
+		const double* femStagePopulation = getFemStages();
+		for (int i = 0; i < 7; i ++)
+			femaleStageSeries[i].push_back(XYPair(timeStep, femStagePopulation[i]));
 
-	fruitQualitySeries.push_back(XYPair(timeStep, currentFruitQ)); // update fruit quality data series
+		fruitQualitySeries.push_back(XYPair(timeStep, currentFruitQ)); // update fruit quality data series
+	}
 	
 	// update cumulative totals and max populations/days
 
-	totEggs += getEggs() * dt;
-	totInst1 += getInst1() * dt;
-	totInst2 += getInst2() * dt;
-	totInst3 += getInst3() * dt;
-	totPupae += getPupae() * dt;
-	totMales += getMales() * dt;
-	totFemales += getFemales() * dt;
+	totEggs += stageTotals[0];
+	totInst1 += stageTotals[1];
+	totInst2 += stageTotals[2];
+	totInst3 += stageTotals[3];
+	totPupae += stageTotals[4];
+	totMales += stageTotals[5];
+	totFemales += stageTotals[6];
 	
 	if (maxEggs < getEggs()) {
 		maxEggs = getEggs();
@@ -153,25 +327,52 @@ void SWDCellSingle::stepForward(double temperature, bool ignoreFruitNew, bool ig
 		maxFemalesDay = timeStep;
 	}
 	
-	// this isn't used in the current model, but i'm leaving it in b/c it 
-	// could come in handy later both for debugging and for tracing population
-	for (int i = 0; i < 10; i ++) { // currently thresholdPop.length == 10
-		if (getFemales() >= thresholdPop[i] && thresholdPopDay[i] < 0) {
-			thresholdPopDay[i] = timeStep;
+	// extra statistics (see StatisticsFlags); the means are the cumulative totals over the elapsed time
+	elapsedDays += clock.dt;
+	
+	if (statistics & STATS_THRESHOLD_DAYS) {
+		for (int i = 0; i < NUM_THRESHOLDS; i ++) {
+			if (getFemales() >= thresholdPop[i] && thresholdPopDay[i] < 0) {
+				thresholdPopDay[i] = timeStep;
+			}
 		}
 	}
 	
+	if ((statistics & STATS_DEGREE_DAYS) && temp > degreeDayBase)
+		degreeDays += (temp - degreeDayBase) * clock.dt; // (the temperature is constant over the step)
+	
+}
+
+// method to choose the extra statistics computed every step (StatisticsFlags, combined with |)
+// degreeDayBaseNew is the base temperature of the degree-days (for STATS_DEGREE_DAYS)
+void SWDCellSingle::setStatistics(int flags, double degreeDayBaseNew) {
+	statistics = flags;
+	degreeDayBase = degreeDayBaseNew;
+}
+
+// method to set the female population of the threshold at the specified index (0 .. getNumThresholds() - 1)
+// the day the total female population first reaches it is recorded with STATS_THRESHOLD_DAYS (see getThresholdPopDay)
+void SWDCellSingle::setThresholdPop(int index, double population) {
+	if (index >= 0 && index < NUM_THRESHOLDS)
+		thresholdPop[index] = population;
 }
 
 
 // method to reset the simulation to timestep 0
 void SWDCellSingle::resetTime() {
 	population.resetPopulation(); // reset the population
+
+	// restart the Runge-Kutta step size control (keeping the tolerances)
+	stepControl.stepSize = 0;
+	stepControl.steps = 0;
+	stepControl.rejectedSteps = 0;
 	
 	dayCrossedMaxFruit = -1; // haven't reached max fruit date yet
 	
-	for (int i = 0; i < 10; i ++)
+	for (int i = 0; i < NUM_THRESHOLDS; i ++)
 		thresholdPopDay[i] = -1;
+	degreeDays = 0;
+	elapsedDays = 0;
 	
 	// reset the data series
 	eggSeries.clear();
@@ -219,9 +420,14 @@ void SWDCellSingle::resetTime() {
 // can specify with the boolean whether or not to reset the fruit parameters too
 void SWDCellSingle::resetCellParams(Parameters &paramsNew, bool resetFruitParams) {
 	params.setCopyParams(paramsNew, resetFruitParams);
+	compiledParams.compile(params);
+	population.invalidateRates();
 }
 
 // method to reset only the fruit parameters
 errormsg SWDCellSingle::resetFruitParams(std::map<std::string, double> fruitMap) {
-	return params.resetFruitParams(fruitMap);
+	errormsg status = params.resetFruitParams(fruitMap);
+	compiledParams.compile(params);
+	population.invalidateRates();
+	return status;
 }
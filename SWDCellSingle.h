@@ -34,6 +34,50 @@ public:
 typedef std::vector<XYPair> XYSeries;
 
 
+/*
+	Numerical integration method used to step a cell forward.
+	EULER_INTEGRATOR is Euler's method (EulersMethod.cpp), which needs a small dt (0.05, i.e. 20 steps per day).
+	EXPONENTIAL_INTEGRATOR solves each step exactly for the rates at the start of the step (ExponentialMethod.cpp), 
+	so a whole day (dt = 1) can be done in one step.
+	RUNGE_KUTTA_INTEGRATOR solves each step (usually a day) with the adaptive step size Dormand-Prince method 
+	(RungeKuttaMethod.cpp), to within the tolerances set with setTolerances.
+*/
+enum IntegratorMode { EULER_INTEGRATOR, EXPONENTIAL_INTEGRATOR, RUNGE_KUTTA_INTEGRATOR };
+
+// method to get the integrator for a name given on the command line: euler, exponential or rk45
+// returns false (leaving mode unchanged) if there is no integrator with that name
+bool parseIntegratorMode(const std::string &name, IntegratorMode &mode);
+
+// method to get the usual integration step for an integrator: 0.05 for Euler's method, or a whole day for the
+// exponential and Runge-Kutta integrators
+double getDefaultDT(IntegratorMode mode);
+
+// names of the lifestages, in the order they are kept in everywhere (eggs to females)
+const int NUM_LIFESTAGES = 7;
+extern const char* const STAGE_NAMES[NUM_LIFESTAGES];
+
+
+/*
+	How often the data series of a cell are recorded (the cumulative totals and the peaks are still
+	updated every step, whatever is recorded).
+	RECORD_EVERY_STEP records a point every dt (the default).
+	RECORD_DAILY records the first step of each day (i.e. the points printed by the runners).
+	RECORD_EVERY_N_DAYS records the first step of every Nth day (see SWDCellSingle::setRecorder).
+	RECORD_NONE doesn't record the series at all.
+*/
+enum RecorderMode { RECORD_EVERY_STEP, RECORD_DAILY, RECORD_EVERY_N_DAYS, RECORD_NONE };
+
+
+/*
+	Extra statistics of a cell, computed as it is stepped (so they don't need the data series).
+	These are flags, which can be combined with | (see SWDCellSingle::setStatistics).
+	STATS_MEANS - mean population of each stage over the run
+	STATS_THRESHOLD_DAYS - day the total female population first reaches each of the threshold populations
+	STATS_DEGREE_DAYS - degree-days accumulated above a base temperature
+*/
+enum StatisticsFlags { STATS_NONE = 0, STATS_MEANS = 1, STATS_THRESHOLD_DAYS = 2, STATS_DEGREE_DAYS = 4 };
+
+
 /*
 	This class describes an SWDCellSingle object, modeling the environment for
 	an SWDPopulation.  This class has a Parameters object representing the various 
@@ -58,6 +102,10 @@ class SWDCellSingle {
 	bool killAllFruit; // has fruit quality passed the cutoff (during the current year)? true or false 
 	bool ignoreFruit; // on startup, the default is to ignore the fruit
 	bool ignoreDiapause;
+	IntegratorMode integrator; // integration method used by stepForward
+	AdaptiveStepControl stepControl; // tolerances and step size of the Runge-Kutta integrator
+	RecorderMode recorderMode; // which steps are recorded in the data series
+	int recordEveryDays; // days between the recorded points (for RECORD_EVERY_N_DAYS)
 
 	// each series keeps all the data for its respective lifestage (or fruit quality) up to the current timestep
 	// there is one data point for every dt
@@ -65,15 +113,33 @@ class SWDCellSingle {
 	XYSeries femaleStageSeries[7];
 	
 	Parameters params; // parameters for all life processes stored 
+	CompiledParameters compiledParams; // index-addressed copy of params used by the model (rebuilt whenever params change)
 	
 	double maxEggs, maxInst1, maxInst2, maxInst3, maxPupae, maxMales, maxFemales; // max population of each respective lifestage
 	double maxEggsDay, maxInst1Day, maxInst2Day, maxInst3Day, maxPupaeDay, maxMalesDay, maxFemalesDay; // timestep where the max occured
 	
 	double totEggs, totInst1, totInst2, totInst3, totPupae, totMales, totFemales; // total cumulative population per stage
 	
-	// this was basically just here for debugging
-	double thresholdPop[10];
-	double thresholdPopDay[10];
+	// female populations to record the crossing day of (for STATS_THRESHOLD_DAYS; unset thresholds are infinite)
+	static const int NUM_THRESHOLDS = 10;
+	double thresholdPop[NUM_THRESHOLDS];
+	double thresholdPopDay[NUM_THRESHOLDS];
+
+	int statistics; // extra statistics computed every step (StatisticsFlags)
+	double degreeDayBase; // base temperature of the degree-days
+	double degreeDays; // degree-days so far
+	double elapsedDays; // time stepped so far, in days (for the means)
+
+	// the kernels of stepForward for each integrator, specialized on the submodel switches (see getStepFunction)
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void stepForwardEuler(double temperature, const StepClock &clock);
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void stepForwardExact(double temperature, const StepClock &clock);
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void stepForwardAdaptive(double temperature, const StepClock &clock);
+	void recordIntegrals(const StepClock &clock, const double stageIntegrals[]);
+	void recordPopulations(const StepClock &clock, const double stageTotals[]);
+	bool isRecorded(const StepClock &clock) const;
 
 public:
 
@@ -81,16 +147,50 @@ public:
 	errormsg setSingleParameter(std::string &param, double newVal);
 	double getSpecificParameter(std::string &param) const;
 
-	void stepForward(double temperature, bool ignoreFruitNew, bool ignoreDiapauseNew, double dt, double timeStep);
+	// a stepForward kernel, for one integrator and combination of the submodel switches
+	// (called as (cell.*stepFunction)(temperature, clock), with the function chosen once per run by getStepFunction)
+	typedef void (SWDCellSingle::*StepFunction)(double temperature, const StepClock &clock);
+
+	StepFunction getStepFunction(bool ignoreFruitNew, bool ignoreDiapauseNew) const;
+	void stepForward(double temperature, bool ignoreFruitNew, bool ignoreDiapauseNew, const StepClock &clock);
+
+	// the parts of stepForward, in order (these are used separately to step many cells at once, see SWDCellBatch)
+	double beginStep(double temperature, bool ignoreFruitNew, bool ignoreDiapauseNew, const StepClock &clock);
+	void setStepFruitQuality(double fruitQuality, const StepClock &clock);
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	bool computeStepRates(const StepClock &clock, StepRates &stepRates) { return population.computeStepRates<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temp, currentFruitQ, compiledParams, clock.day, stepRates); }
+	void getStages(double stages[]) const { population.getStages(stages); }
+	void setStages(const double stages[]) { population.setStages(stages); }
+	void recordStep(const StepClock &clock);
+	void reserveSteps(long numSteps, int stepsPerDay);
 	void resetTime();
 
+	void setIntegrator(IntegratorMode integratorNew) { integrator = integratorNew; }
+	IntegratorMode getIntegrator() const { return integrator; }
+	void setTolerances(double absTolerance, double relTolerance) { stepControl.absTolerance = absTolerance; stepControl.relTolerance = relTolerance; }
+	const AdaptiveStepControl& getStepControl() const { return stepControl; }
+	void setRecorder(RecorderMode mode, int everyDays = 1);
+	RecorderMode getRecorderMode() const { return recorderMode; }
+	int getPointsPerDay(int stepsPerDay) const { return recorderMode == RECORD_EVERY_STEP ? stepsPerDay : 1; } // points per printed day
+
+	void setStatistics(int flags, double degreeDayBaseNew = 10);
+	int getStatistics() const { return statistics; }
+	void setThresholdPop(int index, double population);
+	double getThresholdPop(int index) const { return thresholdPop[index]; }
+	int getNumThresholds() const { return NUM_THRESHOLDS; }
+	double getDegreeDays() const { return degreeDays; }
+	double getDegreeDayBase() const { return degreeDayBase; }
+	double getElapsedDays() const { return elapsedDays; }
+
 	bool getIgnoreFruit() const { return ignoreFruit; }
 	double getFruitQuality() const { return currentFruitQ; }
 	double getDayCrossedMaxFruit() const { return dayCrossedMaxFruit; }
 	double getTemperature() const { return temp; }
 	double getThresholdPopDay(int index) const { return thresholdPopDay[index]; }
-	void readInitFlies() { population.readPopulation(params); }
+	void readInitFlies() { population.readPopulation(compiledParams); }
 	void setAddInitPop(bool toSet) { population.setAddInitPop(toSet); }
+	void setRateTable(std::shared_ptr<const RateTable> table) { population.setRateTable(table); }
+	void setPhotoperiodTable(std::shared_ptr<const PhotoperiodTable> table) { population.setPhotoperiodTable(table); }
 	int getCrossedDiapDay() const { return population.getCrossedDiapDay(); }
 
 	double getEggs() const { return population.getEggs(); }
@@ -128,6 +228,7 @@ public:
 	double getTotEggs() const { return totEggs; }
 
 	Parameters getParams() const { return Parameters(params); }
+	const CompiledParameters& getCompiledParams() const { return compiledParams; }
 	void resetCellParams(Parameters &paramsNew, bool resetFruitParams);
 	errormsg resetFruitParams(std::map<std::string, double> fruitMap);
 
@@ -0,0 +1,261 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "SWDEnsemble.h"
+#include <fstream>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+/*
+
+	Implementation of the SWDEnsemble class.  The class definition and description are included
+	in the SWDEnsemble header file.
+
+*/
+
+// method to get the name of a stage as it is used in the summary column names, with a capital (i.e. "peakFemales")
+static std::string capitalizedStage(int stage) {
+	std::string name = STAGE_NAMES[stage];
+	name[0] = toupper(name[0]);
+	return name;
+}
+
+// method to split a line of a CSV file at the commas, with the spaces around each field removed (the parameter
+// names can have spaces in them, i.e. "initial females1")
+static std::vector<std::string> splitFields(const std::string &line) {
+	std::vector<std::string> fields;
+	size_t start = 0;
+	while (true) {
+		size_t end = line.find(',', start);
+		std::string field = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+		size_t first = field.find_first_not_of(" \t\r");
+		size_t last = field.find_last_not_of(" \t\r");
+		fields.push_back(first == std::string::npos ? "" : field.substr(first, last - first + 1));
+		if (end == std::string::npos)
+			return fields;
+		start = end + 1;
+	}
+}
+
+// constructor for an ensemble of variants of the specified parameters, all run with the specified daily temperatures
+// (there are no variants until they are loaded)
+SWDEnsemble::SWDEnsemble(const Parameters &baseParamsNew, const std::vector<double> &temperaturesNew) : baseParams(baseParamsNew), temperatures(temperaturesNew),
+		dt(getDefaultDT(EULER_INTEGRATOR)), integrator(EULER_INTEGRATOR), statistics(STATS_NONE), degreeDayBase(10), numThreads(WorkerPool::getDefaultNumWorkers()),
+		numTimeSteps(0), ignoreFruit(false), ignoreDiapause(false), startDay(-1) {}
+
+// method to load the variants from a CSV file: the first line has the names of the parameters the variants set
+// (i.e. "initial females1, latitude"), and each line after it is a variant, with the values of those parameters
+// (blank lines are skipped)
+// error message is returned if the file can't be read, a parameter doesn't exist, or a variant has invalid values,
+// in which case there are no variants; otherwise if all is well "Success!" is returned
+errormsg SWDEnsemble::loadVariants(std::string variantsFile) {
+	std::ifstream fileIn(variantsFile.c_str());
+	if (!fileIn)
+		return "Error: could not open the variants file " + variantsFile;
+
+	std::vector<std::string> names;
+	std::vector<std::vector<double>> values;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(fileIn, line)) {
+		lineNumber ++;
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		std::vector<std::string> fields = splitFields(line);
+		if (names.size() == 0) { // (the header)
+			names = fields;
+			continue;
+		}
+
+		if (fields.size() != names.size())
+			return "Error: line " + std::to_string(lineNumber) + " of " + variantsFile + " doesn't have a value for every parameter";
+		std::vector<double> row(fields.size());
+		for (int k = 0; k < fields.size(); k ++) {
+			char *end;
+			row[k] = strtod(fields[k].c_str(), &end);
+			if (fields[k].size() == 0 || *end != '\0')
+				return "Error: invalid value " + fields[k] + " on line " + std::to_string(lineNumber) + " of " + variantsFile;
+		}
+		values.push_back(row);
+	}
+
+	if (names.size() == 0)
+		return "Error: " + variantsFile + " has no parameter names";
+
+	return setVariants(names, values);
+}
+
+// method to set the variants: the names of the parameters they set, and the values of those parameters for each variant
+// (replacing any variants set before)
+// error message is returned if a parameter doesn't exist or a variant has invalid values, in which case there are no
+// variants; otherwise if all is well "Success!" is returned
+errormsg SWDEnsemble::setVariants(const std::vector<std::string> &paramNamesNew, const std::vector<std::vector<double>> &values) {
+	paramNames = paramNamesNew;
+	variantValues.clear();
+	variantParams.clear();
+	summaries.clear();
+
+	std::map<std::string, double> baseMap = baseParams.getMap();
+	for (int k = 0; k < paramNames.size(); k ++) {
+		if (baseMap.count(paramNames[k]) == 0) {
+			errormsg status = "Error: there is no parameter called " + paramNames[k];
+			paramNames.clear();
+			return status;
+		}
+	}
+
+	for (int v = 0; v < values.size(); v ++) {
+		errormsg status = addVariant(values[v]);
+		if (status.compare("Success!") != 0) {
+			paramNames.clear();
+			variantValues.clear();
+			variantParams.clear();
+			return "Error: variant " + std::to_string(v) + ": " + status;
+		}
+	}
+
+	return "Success!";
+}
+
+// method to add a variant with the specified values of the variant parameters (paramNames) to the ensemble
+// the values are checked all together (so a variant can change parameters which are only valid together)
+// error message is returned if the values are invalid, otherwise if all is well "Success!" is returned
+errormsg SWDEnsemble::addVariant(const std::vector<double> &values) {
+	if (values.size() != paramNames.size())
+		return "there isn't a value for every parameter";
+
+	std::map<std::string, double> variantMap = baseParams.getMap();
+	for (int k = 0; k < paramNames.size(); k ++)
+		variantMap[paramNames[k]] = values[k];
+
+	Parameters params(baseParams);
+	errormsg status = params.setMapParams(variantMap, true); // (including the fruit parameters)
+	if (status.compare("Success!") != 0)
+		return status;
+
+	variantValues.push_back(values);
+	variantParams.push_back(params);
+	return status;
+}
+
+// method to choose the integration method of the runs (see IntegratorMode)
+// as for a single cell simulator, the integration step is also set to the usual step for the method (see getDefaultDT)
+// (setDT can still be used to change it after)
+void SWDEnsemble::setIntegrator(IntegratorMode integratorNew) {
+	integrator = integratorNew;
+	dt = getDefaultDT(integrator);
+}
+
+// this method is the task run by the worker pool for each variant (the arg is the ensemble)
+// the variant is run from the start in its own simulator, with only the summary of the run kept, and the summary
+// is left in summaries (each task only writes its own summary, so nothing is locked)
+void SWDEnsemble::runVariantTask(int task, void *arg) {
+	SWDEnsemble *ensemble = (SWDEnsemble *) arg;
+
+	SWDSimulatorSingle sim(ensemble->dt, ensemble->variantParams[task]);
+	sim.setIntegrator(ensemble->integrator);
+	sim.setDT(ensemble->dt);
+	sim.setRecorder(RECORD_NONE); // (only the summary is kept)
+	sim.setStatistics(ensemble->statistics, ensemble->degreeDayBase);
+	SWDCellSingle &cell = sim.getCell();
+	cell.setPhotoperiodTable(ensemble->photoperiods.findTable(cell.getCompiledParams().latitude));
+
+	sim.run(ensemble->temperatures, ensemble->numTimeSteps, ensemble->ignoreFruit, ensemble->ignoreDiapause, ensemble->startDay);
+
+	std::vector<double> &summary = ensemble->summaries[task];
+	double totals[] = {sim.getTotEggs(), sim.getTotInst1(), sim.getTotInst2(), sim.getTotInst3(), sim.getTotPupae(), sim.getTotMales(), sim.getTotFemales()};
+	double peaks[] = {sim.getMaxEggs(), sim.getMaxInst1(), sim.getMaxInst2(), sim.getMaxInst3(), sim.getMaxPupae(), sim.getMaxMales(), sim.getMaxFemales()};
+	double peakDays[] = {sim.getDayMaxEggs(), sim.getDayMaxInst1(), sim.getDayMaxInst2(), sim.getDayMaxInst3(), sim.getDayMaxPupae(), sim.getDayMaxMales(), sim.getDayMaxFemales()};
+	summary.insert(summary.end(), totals, totals + 7);
+	summary.insert(summary.end(), peaks, peaks + 7);
+	summary.insert(summary.end(), peakDays, peakDays + 7);
+	summary.push_back(sim.getCrossedDiapDay());
+	summary.push_back(sim.getDayCrossedMaxFruit());
+
+	double elapsedDays = sim.getElapsedDays();
+	if (ensemble->statistics & STATS_MEANS) { // (the totals are integrals over time, so the means are these over the time run)
+		for (int s = 0; s < 7; s ++)
+			summary.push_back(elapsedDays > 0 ? totals[s] / elapsedDays : 0);
+	}
+	if (ensemble->statistics & STATS_DEGREE_DAYS)
+		summary.push_back(sim.getDegreeDays());
+}
+
+// method to run every variant for the specified number of timesteps (days), with the flies added on startDayNew
+// (-1 to add them when diapause is crossed), on a pool of numThreads workers
+// the variants are run from the start, with the same temperatures, so a run can be repeated (i.e. with other settings)
+void SWDEnsemble::run(double numTimeStepsNew, bool ignoreFruitNew, bool ignoreDiapauseNew, int startDayNew) {
+	numTimeSteps = numTimeStepsNew;
+	ignoreFruit = ignoreFruitNew;
+	ignoreDiapause = ignoreDiapauseNew;
+	startDay = startDayNew;
+
+	summaries.assign(variantParams.size(), std::vector<double>());
+	if (variantParams.size() == 0 || temperatures.size() == 0)
+		return;
+
+	// the tables are built before the workers start, since they share them (only the latitudes of these variants
+	// are kept, so a series of runs with many latitudes, i.e. a sensitivity analysis, doesn't keep adding tables)
+	photoperiods.clear();
+	for (int v = 0; v < variantParams.size(); v ++)
+		photoperiods.getTable(variantParams[v].getParameter("latitude"));
+
+	WorkerPool pool(std::min(numThreads, (int) variantParams.size()));
+	pool.submit(variantParams.size(), runVariantTask, (void *) this);
+	while (pool.waitForTask() >= 0); // wait for all the variants
+}
+
+// method to get the names of the columns of the summary of a variant (see getSummary): the total, peak and peak day of
+// each stage, the days diapause and max fruit quality were crossed, and then any extra statistics (see setStatistics)
+std::vector<std::string> SWDEnsemble::getSummaryNames() const {
+	std::vector<std::string> names;
+	const char *prefixes[] = {"total", "peak", "peakDay"};
+	for (int p = 0; p < 3; p ++) {
+		for (int s = 0; s < NUM_LIFESTAGES; s ++)
+			names.push_back(prefixes[p] + capitalizedStage(s));
+	}
+	names.push_back("diapauseCrossingDay");
+	names.push_back("maxFruitQualityDay");
+
+	if (statistics & STATS_MEANS) {
+		for (int s = 0; s < NUM_LIFESTAGES; s ++)
+			names.push_back("mean" + capitalizedStage(s));
+	}
+	if (statistics & STATS_DEGREE_DAYS)
+		names.push_back("degreeDays");
+	return names;
+}
+
+// method to print the summaries of the last run to a CSV file: a header line, and then one line per variant, with the
+// number of the variant, its values of the variant parameters, and its summary (see getSummaryNames)
+// error message is returned if the file can't be written, otherwise if all is well "Success!" is returned
+errormsg SWDEnsemble::printSummaries(std::string outputFile) const {
+	TextBuffer fileOut;
+
+	fileOut << "variant";
+	for (int k = 0; k < paramNames.size(); k ++)
+		fileOut << "," << paramNames[k];
+	std::vector<std::string> names = getSummaryNames();
+	for (int k = 0; k < names.size(); k ++)
+		fileOut << "," << names[k];
+	fileOut << "\n";
+
+	for (int v = 0; v < summaries.size(); v ++) {
+		fileOut << v;
+		for (int k = 0; k < variantValues[v].size(); k ++)
+			fileOut << "," << variantValues[v][k];
+		for (int k = 0; k < summaries[v].size(); k ++)
+			fileOut << "," << summaries[v][k];
+		fileOut << "\n";
+	}
+
+	if (!fileOut.writeFile(outputFile))
+		return "Error: could not write " + outputFile;
+	return "Success!";
+}
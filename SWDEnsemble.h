@@ -0,0 +1,94 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef SWD_ENSEMBLE_H
+#define SWD_ENSEMBLE_H
+
+#include "SWDSimulatorSingle.h"
+#include "WorkerPool.h"
+#include "TextBuffer.h"
+#include <vector>
+#include <string>
+
+/*
+
+	Header file for SWDEnsemble.cpp.  Contains the SWDEnsemble class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	This class describes an SWDEnsemble object, which runs many variants of the parameters of a single cell
+	simulation (i.e. for a sensitivity study) in one process, instead of one singleSim run per variant.
+
+	The base parameters (i.e. read from a config file) and the daily temperatures are read once, and shared by
+	every variant.  A variant is a set of values for some of the parameters (the other parameters keep their base
+	values); the variants are loaded from a table (see loadVariants), and checked before anything is run.
+
+	The variants are run in parallel on a pool of workers (see WorkerPool), each in its own SWDSimulatorSingle
+	which only keeps the summary of the run (no data series), with the daylight hours table of its latitude shared
+	with the other variants at that latitude (see PhotoperiodTables).  The summary of each variant (totals, peaks,
+	peak days, crossing days, and any extra statistics, see setStatistics) is printed as one row of a CSV file.
+*/
+class SWDEnsemble {
+
+	Parameters baseParams; // parameters of every variant, apart from those the variant sets
+	std::vector<std::string> paramNames; // parameters set by the variants (the columns of the variants table)
+	std::vector<std::vector<double>> variantValues; // values of paramNames of each variant
+	std::vector<Parameters> variantParams; // the complete (checked) parameters of each variant
+
+	std::vector<double> temperatures; // daily temperatures (if there are fewer than the days run, they are looped)
+	PhotoperiodTables photoperiods; // daylight hours table of each latitude of the variants
+
+	double dt; // integration step (see StepClock)
+	IntegratorMode integrator;
+	int statistics; // extra statistics of each run (see StatisticsFlags)
+	double degreeDayBase;
+	int numThreads; // workers running the variants
+
+	std::vector<std::vector<double>> summaries; // summary of each variant from the last run (see getSummaryNames)
+
+	// arguments of a run (shared by all the tasks of the worker pool)
+	double numTimeSteps;
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDay;
+
+	static void runVariantTask(int task, void *arg);
+	errormsg addVariant(const std::vector<double> &values);
+
+public:
+
+	SWDEnsemble(const Parameters &baseParamsNew, const std::vector<double> &temperaturesNew);
+
+	errormsg loadVariants(std::string variantsFile);
+	errormsg setVariants(const std::vector<std::string> &paramNamesNew, const std::vector<std::vector<double>> &values);
+
+	void run(double numTimeStepsNew, bool ignoreFruitNew, bool ignoreDiapauseNew, int startDayNew);
+
+	std::vector<std::string> getSummaryNames() const;
+	errormsg printSummaries(std::string outputFile) const;
+
+	// accessors and mutators
+	void setDT(double dtNew) { dt = dtNew; }
+	double getDT() const { return dt; }
+	void setIntegrator(IntegratorMode integratorNew);
+	void setStatistics(int flags, double degreeDayBaseNew = 10) { statistics = flags & (STATS_MEANS | STATS_DEGREE_DAYS); degreeDayBase = degreeDayBaseNew; } // (the threshold days aren't summarized)
+	void setNumThreads(int numThreadsNew) { numThreads = numThreadsNew > 0 ? numThreadsNew : WorkerPool::getDefaultNumWorkers(); }
+	int getNumThreads() const { return numThreads; }
+
+	const Parameters& getBaseParams() const { return baseParams; }
+	int getNumVariants() const { return variantParams.size(); }
+	const std::vector<std::string>& getParamNames() const { return paramNames; }
+	const std::vector<double>& getVariantValues(int variant) const { return variantValues[variant]; }
+	const std::vector<double>& getSummary(int variant) const { return summaries[variant]; } // (after run)
+
+};
+
+#endif
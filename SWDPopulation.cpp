@@ -37,28 +37,22 @@ double SWDPopulation::getFemales() const {
 	return sumDoubleArray(currentFemaleStages, 7); 
 } 
 
-// method to read in the population from the params object (i.e. to set the
+// method to read in the population from the compiled params (i.e. to set the
 // initial population to those specified in the parameters)
 // this is called when the population is first added (either on diapause crossing, 
 // or at the particular timestep specified)
-void SWDPopulation::readPopulation(const Parameters &params) {
+void SWDPopulation::readPopulation(const CompiledParameters &params) {
 	addInitPop = true;
 		 
-	currentEggs = params.getParameter("initial eggs");
-	currentInst1 = params.getParameter("initial instar1");
-	currentInst2 = params.getParameter("initial instar2");
-	currentInst3 = params.getParameter("initial instar3");
-	currentPupae = params.getParameter("initial pupae");
-	currentMales = params.getParameter("initial males");
+	currentEggs = params.initial[0];
+	currentInst1 = params.initial[1];
+	currentInst2 = params.initial[2];
+	currentInst3 = params.initial[3];
+	currentPupae = params.initial[4];
+	currentMales = params.initial[5];
 	 
-	for (int i = 0; i < 7; i ++) {
-		std::string stageStr = "initial females";
-		int val = i + 1;
-		std::stringstream sstm;
-		sstm << val;
-		stageStr += sstm.str();
-		currentFemaleStages[i] = params.getParameter(stageStr);
-	}
+	for (int i = 0; i < 7; i ++)
+		currentFemaleStages[i] = params.initial[i + 6];
 }
 
 // method to reset the population to simulation step 0 
@@ -80,13 +74,63 @@ void SWDPopulation::resetPopulation() {
 	addInitPop = false;
 
 	crossedDiapDay = -1;
+
+	invalidateRates();
+}
+
+// method to compute the rates which only depend on the temperature and the daylight hours of
+// the specified day, and store them in the daily rate cache
+// these are then reused for every dt in the day (see computePopulation below)
+void SWDPopulation::computeDailyRates(double temperature, const CompiledParameters &params, int day) {
+	rates.day = day;
+	rates.temperature = temperature;
+
+	if (rateTable) // if there is a rate table, the temperature-dependent rates are looked up instead
+		rateTable->lookup(temperature, rates.fertility, rates.devRate, rates.mortalityNat);
+	else {
+		rates.fertility = solveSpecificFertility(temperature, params);
+
+		for (int i = 0; i < 13; i ++) {
+			if (i <= 4) // no development rates for adults
+				rates.devRate[i] = solveDev_Briere_Juvenile(temperature, params.developmentMax[i]); 
+			else if (i > 5 && i < 12)
+				rates.devRate[i - 1] = params.developmentMax[i - 1]; // female development is independent of temperature
+			rates.mortalityNat[i] = solveMortality(temperature, params, i);
+		}
+	}
+
+	// the daylight hours are looked up in the photoperiod table, unless there isn't one for the latitude of the cell
+	if (photoperiodTable && photoperiodTable->getLatitude() == params.latitude)
+		rates.daylightHours = photoperiodTable->getDayLightHours(day);
+	else {
+		int year = day / 365;
+		int date = day % 365;
+		int offset = getOffSet(year);
+		rates.daylightHours = getDayLightHours(year, date + offset, params.latitude);
+	}
+	rates.fertilityDiapauseEffect = solveFertilityDiapauseEffect(rates.daylightHours);
+}
+
+// method to compute the effects of the specified fruit quality on development and mortality,
+// and store them so they can be reused until the fruit quality changes
+void SWDPopulation::computeFruitEffects(double fruitQuality, const CompiledParameters &params) {
+	double fruitQConstant = 0.5; // default value taken from the aphid paper
+
+	fruitEffects.valid = true;
+	fruitEffects.fruitQuality = fruitQuality;
+
+	fruitEffects.development = solveDevelopmentPlantEffect(fruitQConstant, fruitQuality, params);
+	for (int i = 0; i < 13; i ++)
+		fruitEffects.mortality[i] = solveMortalityPlantEffect(fruitQConstant, fruitQuality, params, i);
 }
 
 // method to move the compute the update of the population over one timestep with the specified parameters
-// the temperature of the timestep is specified, and whether or not to ignore diapause and fruit submodels,
-// and the integration step (dt -- the length of one timestep), and the current timestep 
-// also the parameters of the simulation (as the Parameters object), and the current fruit quality of the model
-void SWDPopulation::computePopulation(double temperature, double fruitQuality, const Parameters &params, bool ignoreFruit, bool ignoreDiapause, double dt, double timeStep) { 
+// the temperature of the timestep is specified, and the simulation clock (the current day and step, and the
+// integration step dt -- the length of one timestep)
+// also the parameters of the simulation (compiled, see CompiledParameters), and the current fruit quality of the model
+// whether or not to ignore the fruit and diapause submodels is given by the template arguments
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDPopulation::computePopulation(double temperature, double fruitQuality, const CompiledParameters &params, const StepClock &clock) { 
 		 
 	// note: in order of indices: 0-eggs, 1-instar1, 2-instar2, 3-instar3, 4-pupae, 5-males, 6-females
 	 
@@ -108,81 +152,122 @@ void SWDPopulation::computePopulation(double temperature, double fruitQuality, c
 
     }
  
+	StepRates stepRates;
+	if (!computeStepRates<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temperature, fruitQuality, params, clock.day, stepRates))
+		return; // still in diapause, so the populations don't change
+
+	applyStepRates(stepRates, params, clock.dt);
+}
+
+// method to compute the rates for the current dt (stored in stepRates), and update the diapause switches
+// the arguments are the same as for computePopulation (day is the current day of the clock), and settleDiapause
+// is true if the whole step is done at once (see computePopulationExact), in which case the switches are updated
+// until they stop changing
+// returns false if the flies are still in diapause, in which case the populations don't change this dt
+// (and stepRates is not set)
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+bool SWDPopulation::computeStepRates(double temperature, double fruitQuality, const CompiledParameters &params, int day, StepRates &stepRates, bool settleDiapause) { 
+
+	// the temperature (and so all the temperature-dependent rates) is constant over the day, so
+	// only recompute the rates if this is a new day (or the temperature changed)
+	if (rates.day != day || rates.temperature != temperature)
+		computeDailyRates(temperature, params, day);
 
 	// calculate fertility rate
-	double fertility = solveSpecificFertility(temperature, params);
+	double fertility = rates.fertility;
 	double fertilityDiapauseEffect = 1;
 	
-	if (!ignoreDiapause) { 
-		int year = ((int) timeStep) / 365;
-		int date = ((int) timeStep) % 365;
-		int offset = getOffSet(year);
-		double latitude = params.getParameter("latitude");
-		double hours = getDayLightHours(year, date + offset, latitude);
+	if (!IGNORE_DIAPAUSE) { 
+		double hours = rates.daylightHours;
 		 
-		double criticalT = params.getParameter("diapause critical temp");
-		double daylightHours = params.getParameter("diapause daylight hours");
+		double criticalT = params.diapauseCriticalTemp;
+		double daylightHours = params.diapauseDaylightHours;
 		 
-		// NOTE: don't set s1 here since the previous value of s1 is needed to calculate s2
-		int tempS1 = solveDiapauseMultS1(hours, temperature, s1, s2, criticalT, daylightHours); // diapause multiplier (s1)
-		s2 = solveDiapauseMultS2(hours, s1, s2, daylightHours); // s2 value for current dt
-		s1 = tempS1; // s1 value for current dt
+		// the switches are updated once per dt, or until they settle if the whole step is done at once
+		// (the hours and temperature are constant over the day, so they settle within a few updates)
+		int numUpdates = settleDiapause ? DIAPAUSE_MAX_UPDATES : 1;
+		for (int k = 0; k < numUpdates; k ++) {
+			// NOTE: don't set s1 here since the previous value of s1 is needed to calculate s2
+			int tempS1 = solveDiapauseMultS1(hours, temperature, s1, s2, criticalT, daylightHours); // diapause multiplier (s1)
+			int tempS2 = solveDiapauseMultS2(hours, s1, s2, daylightHours); // s2 value for current dt
+			if (tempS1 == s1 && tempS2 == s2)
+				break; // settled
+			s1 = tempS1; // s1 value for current dt
+			s2 = tempS2;
+		}
 		 
-		fertilityDiapauseEffect = s1 * solveFertilityDiapauseEffect(hours);
+		fertilityDiapauseEffect = s1 * rates.fertilityDiapauseEffect;
 
 		// compute switch functions for diapause 
 		if (s1 == 0 && !crossedDiapause && !addInitPop)
-			return;
+			return false;
 		if (s1 != 0 && !crossedDiapause) {
 			if (!addInitPop)
 				readPopulation(params);
 			crossedDiapause = true;
-			crossedDiapDay = (int) (timeStep);
+			crossedDiapDay = day;
 		}
 		 
 	}
 	 
-	fertility *= fertilityDiapauseEffect; // multiplicative effect of diapause on fecundity (if ignoring diapause, will still be 1)
+	stepRates.fertility = fertility * fertilityDiapauseEffect; // multiplicative effect of diapause on fecundity (if ignoring diapause, will still be 1)
 	 
-	std::vector<double> devMaxes = params.getArrayParameters("development max");
+	computeFruitRates<IGNORE_FRUIT>(fruitQuality, params, stepRates);
+
+	return true;
+}
+
+// method to set the development and mortality rates of stepRates for the specified fruit quality
+// (i.e. the daily rates with the fruit effects), for the day of the last computeStepRates
+template <bool IGNORE_FRUIT>
+void SWDPopulation::computeFruitRates(double fruitQuality, const CompiledParameters &params, StepRates &stepRates) {
+	double* devRate = stepRates.devRate; // development rates per stage
+	double* mortalityNat = stepRates.mortalityNat; // mortality rates per stage, due to natural causes (food, etc.)
 	
-	double devRate[11]; // development rates per stage
-	double mortalityNat[13]; // mortality rates per stage, due to natural causes (food, etc.)
+	if (IGNORE_FRUIT) { // if the user chose to ignore the effect of fruit quality on the flies, the daily rates are used as they are
+		for (int i = 0; i < 11; i ++)
+			devRate[i] = rates.devRate[i];
+		for (int i = 0; i < 13; i ++)
+			mortalityNat[i] = rates.mortalityNat[i];
+		return;
+	}
 	
-	double fruitQConstant = 0.5; // default value taken from the aphid paper
+	// the fruit effects only need to be recomputed if the fruit quality changed since the last dt
+	if (!fruitEffects.valid || fruitEffects.fruitQuality != fruitQuality)
+		computeFruitEffects(fruitQuality, params);
 	
-	double fruitEffectDevelopment = solveDevelopmentPlantEffect(fruitQConstant, fruitQuality, params);
+	double fruitEffectDevelopment = fruitEffects.development;
 	 
 	for (int i = 0; i < 13; i ++) { // calculate the stage-specific mortality and development rates
-		if (i <= 4) // no development rates for adults
-			devRate[i] = solveDev_Briere_Juvenile(temperature, devMaxes[i]); 
-			//devRate[i] = solveDev_newData(temperature, devMaxes[i]);
-		else if (i > 5 && i < 12)
-			devRate[i - 1] = devMaxes[i - 1]; // female development is independent of temperature
-		mortalityNat[i] = solveMortality(temperature, params, params.getStage(i));
-		 
-		double fruitEffectMortality = solveMortalityPlantEffect(fruitQConstant, fruitQuality, params, params.getStage(i));
+		if (i < 11)
+			devRate[i] = rates.devRate[i]; // temperature-dependent part, from the daily cache
+		mortalityNat[i] = rates.mortalityNat[i];
 		 
 		// plant effect is multiplicative on development, and summative on mortality
 		 
-		if (ignoreFruit) { // if the user chose to ignore the effect of fruit quality on the flies
-			fruitEffectDevelopment = 1; // since fruit is a multiplier for development, to ignore fruit the multiplier is 1
-			fruitEffectMortality = 0; // since fruit is a sum on mortality, to ignore fruit the added factor is 0
-		}
-		 
 		if (i < 5) // no development rate for adults
 			devRate[i] *= fruitEffectDevelopment; // fruit has a multiplicative effect on development rate
-		mortalityNat[i] += fruitEffectMortality; // fruit has a summative effect on mortality rate
+		mortalityNat[i] += fruitEffects.mortality[i]; // fruit has a summative effect on mortality rate
 	}
+}
+
+// method to update the populations over one dt (of length dt) with the rates specified
+// (i.e. this is the numerical integration step, see EulersMethod.cpp)
+void SWDPopulation::applyStepRates(const StepRates &stepRates, const CompiledParameters &params, double dt) {
+	const double* devRate = stepRates.devRate;
+	const double* mortalityNat = stepRates.mortalityNat;
+	double fertility = stepRates.fertility;
 	 
-	std::vector<double> tempFemalesPopulation = copyDoubleArray(currentFemaleStages, 7); // ensure to use populations from the timestep before
+	double tempFemalesPopulation[7]; // ensure to use populations from the timestep before
+	for (int i = 0; i < 7; i ++)
+		tempFemalesPopulation[i] = currentFemaleStages[i];
 	
 	// calculate the current populations of all the lifestages
 	
-	std::vector<double> eggViabilities = params.getArrayParameters("egg viability");
-	std::vector<double> mortalitiesPred = params.getArrayParameters("mortality due to predation");
+	const double* eggViabilities = params.eggViability;
+	const double* mortalitiesPred = params.mortalityPred;
 	
-	double maleProportion = params.getParameter("male proportion");
+	double maleProportion = params.maleProportion;
 	double maleProportion_advFemStage = 0; // no males develop from previous female lifestages
 	
 	currentFemaleStages[0] = obtainFemalesX(maleProportion, devRate[4], currentPupae, 
@@ -232,3 +317,159 @@ void SWDPopulation::computePopulation(double temperature, double fruitQuality, c
 	}
 	 
 }
+
+// method to update the population over one whole step (usually a day) with the exact solution of the stage equations
+// (see ExponentialMethod.cpp) instead of Euler's method; the arguments are the same as for computePopulation
+// the rates are assumed constant over the step, with the fruit quality passed in (usually the one in the middle of the step)
+// the integral of each stage population over the step is stored in stageIntegrals (for the cumulative populations)
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDPopulation::computePopulationExact(double temperature, double fruitQuality, const CompiledParameters &params, const StepClock &clock, double stageIntegrals[]) {
+	double step = clock.dt;
+	double stages[13];
+	getStages(stages);
+	for (int i = 0; i < 13; i ++) {
+		if (stages[i] < 0) // no negative populations
+			stages[i] = 0;
+		stageIntegrals[i] = stages[i] * step; // if the populations don't change
+	}
+	setStages(stages);
+
+	StepRates stepRates;
+	if (!computeStepRates<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temperature, fruitQuality, params, clock.day, stepRates, true))
+		return; // still in diapause, so the populations don't change
+
+	getStages(stages); // (the initial populations are read in if diapause was crossed)
+	obtainStagesExact(stepRates.fertility, stepRates.devRate, stepRates.mortalityNat, params, stages, stageIntegrals, step);
+	setStages(stages);
+}
+
+// state of the adaptive integration (see computePopulationAdaptive): 0..12 - stage populations, 13 - fruit quality,
+// 14..26 - integrals of the stage populations
+const int ADAPTIVE_FRUIT = 13;
+const int ADAPTIVE_INTEGRALS = 14;
+const int ADAPTIVE_VARIABLES = 27;
+
+// the values needed to compute the derivatives of the adaptive integration state
+struct AdaptiveContext {
+
+	SWDPopulation* population;
+	const CompiledParameters* params;
+	StepRates* stepRates; // the rates of the step (the fruit-dependent ones are updated for every derivative)
+	bool active; // false if the flies are in diapause (so the populations don't change)
+	double gt, fruitQLag; // for the fruit quality derivative
+
+};
+
+// method to compute the derivatives of the adaptive integration state (see solveDormandPrince)
+// the rates only depend on the temperature of the step, not on the time within it, so the time isn't used
+template <bool IGNORE_FRUIT>
+void SWDPopulation::adaptiveDerivatives(double, const double y[], double dydt[], void* context) {
+	AdaptiveContext* o = (AdaptiveContext*) context;
+
+	double fruitQuality = std::min(1.0, std::max(0.05, y[ADAPTIVE_FRUIT]));
+	dydt[ADAPTIVE_FRUIT] = obtainFruitQualityDerivative(o->gt, fruitQuality, o->fruitQLag, *o->params);
+
+	if (o->active) {
+		o->population->computeFruitRates<IGNORE_FRUIT>(fruitQuality, *o->params, *o->stepRates);
+		obtainStageDerivatives(o->stepRates->fertility, o->stepRates->devRate, o->stepRates->mortalityNat, *o->params, y, dydt);
+	} else {
+		for (int i = 0; i < 13; i ++)
+			dydt[i] = 0;
+	}
+
+	for (int i = 0; i < 13; i ++)
+		dydt[ADAPTIVE_INTEGRALS + i] = y[i];
+}
+
+// method to keep the adaptive integration state valid after each step: no negative populations, and the fruit
+// quality between 0.05 and 1 (this doesn't need the context)
+bool SWDPopulation::adaptiveProject(double y[], void*) {
+	bool changed = false;
+	for (int i = 0; i < 13; i ++) {
+		if (y[i] < 0) {
+			y[i] = 0;
+			changed = true;
+		}
+	}
+	if (y[ADAPTIVE_FRUIT] < 0.05 || y[ADAPTIVE_FRUIT] > 1) {
+		y[ADAPTIVE_FRUIT] = std::min(1.0, std::max(0.05, y[ADAPTIVE_FRUIT]));
+		changed = true;
+	}
+	return changed;
+}
+
+// method to update the population and the fruit quality over one whole step (usually a day) with the adaptive
+// Runge-Kutta solver (see RungeKuttaMethod.cpp) instead of Euler's method
+// the arguments are the same as for computePopulationExact, except that the fruit quality is solved together with
+// the populations: fruitQuality is the fruit quality at the start of the step, and is updated to the one at the end
+// (gt and fruitQLag are needed for this, see SWDCellSingle::beginStep)
+// control holds the tolerances and the step size (see AdaptiveStepControl)
+template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+void SWDPopulation::computePopulationAdaptive(double temperature, double gt, double fruitQLag, double &fruitQuality, const CompiledParameters &params, const StepClock &clock, double stageIntegrals[], AdaptiveStepControl &control) {
+	double y[ADAPTIVE_VARIABLES];
+	getStages(y);
+	for (int i = 0; i < 13; i ++) {
+		if (y[i] < 0) // no negative populations
+			y[i] = 0;
+	}
+	setStages(y);
+
+	StepRates stepRates;
+	AdaptiveContext context;
+	context.population = this;
+	context.params = &params;
+	context.stepRates = &stepRates;
+	context.gt = gt;
+	context.fruitQLag = fruitQLag;
+	context.active = computeStepRates<IGNORE_FRUIT, IGNORE_DIAPAUSE>(temperature, fruitQuality, params, clock.day, stepRates, true);
+
+	getStages(y); // (the initial populations are read in if diapause was crossed)
+	y[ADAPTIVE_FRUIT] = fruitQuality;
+	for (int i = 0; i < 13; i ++)
+		y[ADAPTIVE_INTEGRALS + i] = 0;
+
+	// only the populations and the fruit quality are error controlled (not the integrals)
+	solveDormandPrince(adaptiveDerivatives<IGNORE_FRUIT>, adaptiveProject, &context, y, ADAPTIVE_VARIABLES, ADAPTIVE_INTEGRALS, 0, clock.dt, control);
+
+	setStages(y);
+	fruitQuality = y[ADAPTIVE_FRUIT];
+	for (int i = 0; i < 13; i ++)
+		stageIntegrals[i] = std::max(0.0, y[ADAPTIVE_INTEGRALS + i]);
+}
+
+// method to copy the populations of all the stages into the array passed in (which has room for 13 values)
+// in order of indices: 0-eggs, 1-instar1, 2-instar2, 3-instar3, 4-pupae, 5-males, 6..12-females1..females7
+void SWDPopulation::getStages(double stages[]) const {
+	stages[0] = currentEggs;
+	stages[1] = currentInst1;
+	stages[2] = currentInst2;
+	stages[3] = currentInst3;
+	stages[4] = currentPupae;
+	stages[5] = currentMales;
+	for (int i = 0; i < 7; i ++)
+		stages[i + 6] = currentFemaleStages[i];
+}
+
+// method to set the populations of all the stages to those in the array passed in (same order as getStages)
+void SWDPopulation::setStages(const double stages[]) {
+	currentEggs = stages[0];
+	currentInst1 = stages[1];
+	currentInst2 = stages[2];
+	currentInst3 = stages[3];
+	currentPupae = stages[4];
+	currentMales = stages[5];
+	for (int i = 0; i < 7; i ++)
+		currentFemaleStages[i] = stages[i + 6];
+}
+
+// instantiate the specialized methods for every combination of the submodel switches (see SWDPopulation.h)
+#define INSTANTIATE_POPULATION_KERNELS(IGNORE_FRUIT, IGNORE_DIAPAUSE) \
+	template bool SWDPopulation::computeStepRates<IGNORE_FRUIT, IGNORE_DIAPAUSE>(double, double, const CompiledParameters&, int, StepRates&, bool); \
+	template void SWDPopulation::computePopulation<IGNORE_FRUIT, IGNORE_DIAPAUSE>(double, double, const CompiledParameters&, const StepClock&); \
+	template void SWDPopulation::computePopulationExact<IGNORE_FRUIT, IGNORE_DIAPAUSE>(double, double, const CompiledParameters&, const StepClock&, double[]); \
+	template void SWDPopulation::computePopulationAdaptive<IGNORE_FRUIT, IGNORE_DIAPAUSE>(double, double, double, double&, const CompiledParameters&, const StepClock&, double[], AdaptiveStepControl&);
+
+INSTANTIATE_POPULATION_KERNELS(false, false)
+INSTANTIATE_POPULATION_KERNELS(false, true)
+INSTANTIATE_POPULATION_KERNELS(true, false)
+INSTANTIATE_POPULATION_KERNELS(true, true)
@@ -11,10 +11,17 @@ All rights reserved.
 #define SWD_POPULATION_H
 
 #include "Parameters.h"
+#include "CompiledParameters.h"
 #include "UtilityMethods.h"
 #include "SolveParameters.h"
 #include "EulersMethod.h"
+#include "ExponentialMethod.h"
+#include "RungeKuttaMethod.h"
 #include "Daylight.h"
+#include "RateTable.h"
+#include "PhotoperiodTable.h"
+#include "StepClock.h"
+#include <memory>
 
 /*
 
@@ -31,8 +38,61 @@ All rights reserved.
 
 */
 
+/*
+	This struct caches the rates that only depend on the temperature of the day and the
+	photoperiod (i.e. not on the fruit quality or the current populations).  Since the 
+	temperature is given daily, these are the same for every dt in the day, so they are 
+	computed once (the first time the day is stepped) and reused for the rest of the day.
+*/
+struct DailyRates {
+
+	int day; // day the rates were computed for (-1 if the cache is empty)
+	double temperature; // temperature the rates were computed for
+
+	double fertility; // temperature-dependent fecundity (without the diapause effect)
+	double daylightHours; // daylight hours of the day
+	double fertilityDiapauseEffect; // effect of the daylight hours on fecundity (multiplied by s1 every dt)
+	double devRate[11]; // temperature-dependent development rates (without the fruit effect)
+	double mortalityNat[13]; // temperature-dependent natural mortality rates (without the fruit effect)
+
+	DailyRates() : day(-1), temperature(0) {}
+
+};
+
+/*
+	The fruit effects on development and mortality depend on the fruit quality, which can change
+	every dt, so they can't be cached per day.  However, the fruit quality is clamped between 
+	0.05 and 1 and sits at one of these for most of the year, so the effects of the last fruit
+	quality are kept and only recomputed when the fruit quality actually changes.
+*/
+struct FruitEffects {
+
+	bool valid; // false if the effects need to be recomputed
+	double fruitQuality; // fruit quality the effects were computed for
+
+	double development; // multiplicative effect on development
+	double mortality[13]; // additive effect on mortality (per stage)
+
+	FruitEffects() : valid(false), fruitQuality(0) {}
+
+};
+
+/*
+	This struct holds the rates used to update the populations over one dt (i.e. the daily rates
+	combined with the diapause and fruit effects of the current dt).
+*/
+struct StepRates {
+
+	double fertility; // fecundity, including the diapause effect
+	double devRate[11]; // development rates, including the fruit effect
+	double mortalityNat[13]; // natural mortality rates, including the fruit effect
+
+};
+
 class SWDPopulation {
 
+	static const int DIAPAUSE_MAX_UPDATES = 4; // the diapause switches settle within this many updates (for constant hours and temperature)
+
 	double currentEggs, currentInst1, currentInst2, currentInst3, currentPupae, currentMales; // the current stage-specific populations
 	double currentFemaleStages[7]; // female-stage specific populations
 	
@@ -43,6 +103,21 @@ class SWDPopulation {
 	 
 	int crossedDiapDay;
 
+	DailyRates rates; // per-day cache of the temperature and photoperiod dependent rates
+	FruitEffects fruitEffects; // effects of the last fruit quality on development and mortality
+	std::shared_ptr<const RateTable> rateTable; // optional lookup table for the temperature-dependent rates (shared between cells)
+	std::shared_ptr<const PhotoperiodTable> photoperiodTable; // optional table of the daylight hours at the latitude (shared between cells)
+
+	void computeDailyRates(double temperature, const CompiledParameters &params, int day);
+	void computeFruitEffects(double fruitQuality, const CompiledParameters &params);
+	template <bool IGNORE_FRUIT>
+	void computeFruitRates(double fruitQuality, const CompiledParameters &params, StepRates &stepRates);
+
+	// derivatives and projection of the adaptive integration state (see computePopulationAdaptive)
+	template <bool IGNORE_FRUIT>
+	static void adaptiveDerivatives(double t, const double y[], double dydt[], void* context);
+	static bool adaptiveProject(double y[], void* context);
+
 public:
 	
 	// constructors
@@ -70,11 +145,32 @@ public:
 	int getCrossedDiapDay() const { return crossedDiapDay; } // day diapause has been crossed
 	
 	// changing populations
-	void readPopulation(const Parameters &params);
+	void readPopulation(const CompiledParameters &params);
 	void resetPopulation();
+	void setRateTable(std::shared_ptr<const RateTable> table) { rateTable = table; invalidateRates(); } // null to use the analytic functions
+	void setPhotoperiodTable(std::shared_ptr<const PhotoperiodTable> table) { photoperiodTable = table; invalidateRates(); } // null to compute the daylight hours
+	void invalidateRates() { rates.day = -1; fruitEffects.valid = false; } // force the cached rates to be recomputed (i.e. if the parameters change)
+
+	// populations of all 13 stages, in stage index order (used to step many populations at once, see SWDCellBatch)
+	void getStages(double stages[]) const;
+	void setStages(const double stages[]);
+
+	// the methods below are specialized on the fruit and diapause submodel switches (whether or not to ignore them),
+	// so each combination has its own kernel without the branches (and the work) for the ignored submodels
+	// (they are instantiated for all four combinations in the cpp file, see SWDCellSingle::getStepFunction)
+
+	// the two halves of computePopulation
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	bool computeStepRates(double temperature, double fruitQuality, const CompiledParameters &params, int day, StepRates &stepRates, bool settleDiapause = false);
+	void applyStepRates(const StepRates &stepRates, const CompiledParameters &params, double dt);
 
 	// update population to next timestep
-	void computePopulation(double temperature, double fruitQuality, const Parameters &params, bool ignoreFruit, bool ignoreDiapause, double dt, double timeStep);
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void computePopulation(double temperature, double fruitQuality, const CompiledParameters &params, const StepClock &clock);
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void computePopulationAdaptive(double temperature, double gt, double fruitQLag, double &fruitQuality, const CompiledParameters &params, const StepClock &clock, double stageIntegrals[], AdaptiveStepControl &control);
+	template <bool IGNORE_FRUIT, bool IGNORE_DIAPAUSE>
+	void computePopulationExact(double temperature, double fruitQuality, const CompiledParameters &params, const StepClock &clock, double stageIntegrals[]);
 
 };
 
@@ -0,0 +1,219 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "SWDSensitivity.h"
+#include <cmath>
+#include <algorithm>
+
+/*
+
+	Implementation of the SWDSensitivity class.  The class definition and description (with the estimators)
+	are included in the SWDSensitivity header file.
+
+*/
+
+// constructor for a sensitivity analysis of a single cell simulation with the specified parameters (apart from the
+// parameters varied) and daily temperatures
+// there are no parameters varied or outputs until they are set, and the design defaults to a Latin hypercube
+SWDSensitivity::SWDSensitivity(const Parameters &baseParams, const std::vector<double> &temperatures) : ensemble(baseParams, temperatures),
+		design(LATIN_HYPERCUBE_DESIGN), seed(1), blockSize(256), numSamples(0) {
+	ensemble.setStatistics(STATS_MEANS | STATS_DEGREE_DAYS); // (so any of the summary columns can be an output)
+}
+
+// method to read the parameters to vary, and their ranges, from a file (see ParameterRanges for the format)
+// error message is returned if the file can't be read or a line is invalid, otherwise if all is well "Success!" is returned
+errormsg SWDSensitivity::loadRanges(std::string rangesFile) {
+	return ranges.load(rangesFile, ensemble.getBaseParams());
+}
+
+// method to add a parameter to vary, uniformly between minValue and maxValue
+// error message is returned if there is no such parameter or the range is empty, otherwise if all is well "Success!" is returned
+errormsg SWDSensitivity::addRange(std::string paramName, double minValue, double maxValue) {
+	return ranges.add(paramName, minValue, maxValue, ensemble.getBaseParams());
+}
+
+// method to choose the outputs to analyse, by the names of the columns of the ensemble summaries (i.e. "peakFemales",
+// "peakDayFemales", "totalFemales", see SWDEnsemble::getSummaryNames)
+// error message is returned if an output doesn't exist, otherwise if all is well "Success!" is returned
+errormsg SWDSensitivity::setOutputs(const std::vector<std::string> &outputNamesNew) {
+	std::vector<std::string> summaryNames = ensemble.getSummaryNames();
+	std::vector<int> columns;
+	for (int k = 0; k < outputNamesNew.size(); k ++) {
+		int column = std::find(summaryNames.begin(), summaryNames.end(), outputNamesNew[k]) - summaryNames.begin();
+		if (column == summaryNames.size())
+			return "Error: there is no output called " + outputNamesNew[k];
+		columns.push_back(column);
+	}
+
+	outputNames = outputNamesNew;
+	outputColumns = columns;
+	return "Success!";
+}
+
+// method to run the analysis with numSamplesNew base samples (so numSamplesNew (numParams + 2) runs), each run for the
+// specified number of timesteps (days), with the flies added on startDay (-1 to add them when diapause is crossed)
+// the estimators are reset first; if samplesFile isn't empty, every run is written to it (see addBlock)
+// error message is returned if the analysis isn't set up, a sample has invalid parameters or the samples file can't be
+// written, otherwise if all is well "Success!" is returned
+errormsg SWDSensitivity::run(long numSamplesNew, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, std::string samplesFile) {
+	int numParams = ranges.size();
+	if (numParams == 0 || outputNames.size() == 0)
+		return "Error: there are no parameters to vary, or no outputs to analyse";
+	if (design == SOBOL_DESIGN && 2 * numParams > SobolSequence::MAX_DIMS)
+		return "Error: the Sobol design can only vary up to " + std::to_string(SobolSequence::MAX_DIMS / 2) + " parameters (use the Latin hypercube design)";
+
+	std::ofstream samplesOut;
+	if (samplesFile.compare("") != 0) {
+		samplesOut.open(samplesFile.c_str(), std::ios::binary);
+		if (!samplesOut)
+			return "Error: could not create the samples file " + samplesFile;
+		TextBuffer header;
+		header << "sample,point";
+		for (int i = 0; i < numParams; i ++)
+			header << "," << ranges.getName(i);
+		for (int k = 0; k < outputNames.size(); k ++)
+			header << "," << outputNames[k];
+		header << "\n";
+		samplesOut.write(header.data(), header.size());
+	}
+
+	estimators.assign(outputNames.size(), Estimators());
+	for (int k = 0; k < estimators.size(); k ++) {
+		estimators[k].shift = estimators[k].sum = estimators[k].sumSquares = 0;
+		estimators[k].firstOrderSums.assign(numParams, 0);
+		estimators[k].totalOrderSums.assign(numParams, 0);
+	}
+	numSamples = 0;
+
+	// each base sample is a point in 2 numParams dimensions: a is the first half, and b the second half
+	SobolSequence sobol(design == SOBOL_DESIGN ? 2 * numParams : 1);
+	LatinHypercube hypercube(2 * numParams, seed);
+	std::vector<std::vector<double>> points;
+	std::vector<std::vector<double>> runs; // parameter values of the runs of a block: a, b, then ab_i for each i, per sample
+
+	while (numSamples < numSamplesNew) {
+		int numBlockSamples = std::min((long) blockSize, numSamplesNew - numSamples);
+		if (design == SOBOL_DESIGN)
+			sobol.nextPoints(numBlockSamples, points);
+		else
+			hypercube.nextPoints(numBlockSamples, points);
+
+		runs.resize((long) numBlockSamples * (numParams + 2));
+		for (int j = 0; j < numBlockSamples; j ++) {
+			std::vector<double> *sampleRuns = &runs[(long) j * (numParams + 2)];
+			for (int r = 0; r < numParams + 2; r ++)
+				sampleRuns[r].resize(numParams);
+			for (int i = 0; i < numParams; i ++) {
+				double a = ranges.getValue(i, points[j][i]);
+				double b = ranges.getValue(i, points[j][numParams + i]);
+				sampleRuns[0][i] = a;
+				sampleRuns[1][i] = b;
+				for (int r = 0; r < numParams; r ++)
+					sampleRuns[2 + r][i] = (r == i) ? b : a;
+			}
+		}
+
+		errormsg status = ensemble.setVariants(ranges.getNames(), runs);
+		if (status.compare("Success!") != 0)
+			return status;
+		ensemble.run(numTimeSteps, ignoreFruit, ignoreDiapause, startDay);
+
+		addBlock(numBlockSamples, samplesOut);
+		if (samplesOut.is_open() && !samplesOut)
+			return "Error: could not write the samples file " + samplesFile;
+	}
+
+	return "Success!";
+}
+
+// method to add the runs of the block just run by the ensemble (numBlockSamples base samples) to the estimators, and
+// write them to samplesOut if it is open: one line per run, with the number of the base sample, the point run (a, b,
+// or ab_i, the a point with parameter i from b), the values of the parameters, and the outputs
+void SWDSensitivity::addBlock(int numBlockSamples, std::ofstream &samplesOut) {
+	int numParams = ranges.size();
+	int runsPerSample = numParams + 2;
+
+	if (numSamples == 0) { // the outputs are shifted by their mean over the first block (so the sums don't lose precision)
+		for (int k = 0; k < estimators.size(); k ++) {
+			double sum = 0;
+			for (int j = 0; j < numBlockSamples; j ++)
+				sum += ensemble.getSummary(j * runsPerSample)[outputColumns[k]] + ensemble.getSummary(j * runsPerSample + 1)[outputColumns[k]];
+			estimators[k].shift = sum / (2 * numBlockSamples);
+		}
+	}
+
+	for (int k = 0; k < estimators.size(); k ++) {
+		Estimators &e = estimators[k];
+		for (int j = 0; j < numBlockSamples; j ++) {
+			double fa = ensemble.getSummary(j * runsPerSample)[outputColumns[k]] - e.shift;
+			double fb = ensemble.getSummary(j * runsPerSample + 1)[outputColumns[k]] - e.shift;
+			e.sum += fa + fb;
+			e.sumSquares += fa * fa + fb * fb;
+			for (int i = 0; i < numParams; i ++) {
+				double fab = ensemble.getSummary(j * runsPerSample + 2 + i)[outputColumns[k]] - e.shift;
+				e.firstOrderSums[i] += fb * (fab - fa);
+				e.totalOrderSums[i] += (fa - fab) * (fa - fab);
+			}
+		}
+	}
+
+	if (samplesOut.is_open()) {
+		TextBuffer fileOut;
+		for (int j = 0; j < numBlockSamples; j ++) {
+			for (int r = 0; r < runsPerSample; r ++) {
+				int run = j * runsPerSample + r;
+				fileOut << numSamples + j << "," << (r == 0 ? "a" : r == 1 ? "b" : "ab" + std::to_string(r - 1));
+				const std::vector<double> &values = ensemble.getVariantValues(run);
+				for (int i = 0; i < numParams; i ++)
+					fileOut << "," << values[i];
+				for (int k = 0; k < outputColumns.size(); k ++)
+					fileOut << "," << ensemble.getSummary(run)[outputColumns[k]];
+				fileOut << "\n";
+			}
+		}
+		samplesOut.write(fileOut.data(), fileOut.size());
+	}
+
+	numSamples += numBlockSamples;
+}
+
+// method to get the variance of the specified output (numbered in the order they were set) over the a and b points
+double SWDSensitivity::getVariance(int output) const {
+	const Estimators &e = estimators[output];
+	double mean = e.sum / (2 * numSamples);
+	return e.sumSquares / (2 * numSamples) - mean * mean;
+}
+
+// method to get the first order Sobol index of the specified output for the specified parameter (numbered in the order
+// they were added), i.e. the fraction of the variance of the output due to the parameter alone (NaN if the output doesn't vary)
+double SWDSensitivity::getFirstOrderIndex(int output, int param) const {
+	double variance = getVariance(output);
+	return variance > 0 ? estimators[output].firstOrderSums[param] / numSamples / variance : NAN;
+}
+
+// method to get the total order Sobol index of the specified output for the specified parameter, i.e. the fraction of
+// the variance of the output due to the parameter, including its interactions with the others (NaN if the output doesn't vary)
+double SWDSensitivity::getTotalOrderIndex(int output, int param) const {
+	double variance = getVariance(output);
+	return variance > 0 ? estimators[output].totalOrderSums[param] / (2 * numSamples) / variance : NAN;
+}
+
+// method to print the indices to a CSV file: one line per output and parameter, with the first and total order
+// indices, and the variance of the output (over the base samples)
+// error message is returned if the file can't be written, otherwise if all is well "Success!" is returned
+errormsg SWDSensitivity::printIndices(std::string outputFile) const {
+	TextBuffer fileOut;
+	fileOut << "output,parameter,firstOrder,totalOrder,variance\n";
+	for (int k = 0; k < outputNames.size() && numSamples > 0; k ++) {
+		for (int i = 0; i < ranges.size(); i ++)
+			fileOut << outputNames[k] << "," << ranges.getName(i) << "," << getFirstOrderIndex(k, i) << "," << getTotalOrderIndex(k, i) << "," << getVariance(k) << "\n";
+	}
+
+	if (!fileOut.writeFile(outputFile))
+		return "Error: could not write " + outputFile;
+	return "Success!";
+}
@@ -0,0 +1,95 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef SWD_SENSITIVITY_H
+#define SWD_SENSITIVITY_H
+
+#include "SWDEnsemble.h"
+#include "SampleDesign.h"
+#include "ParameterRanges.h"
+#include <vector>
+#include <string>
+#include <fstream>
+
+/*
+
+	Header file for SWDSensitivity.cpp.  Contains the SWDSensitivity class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	This class describes an SWDSensitivity object, which does a variance-based (Sobol) sensitivity analysis of
+	outputs of a single cell simulation (i.e. the peak females or the day of the peak) to a set of parameters,
+	each varied uniformly over a range.
+
+	The analysis uses the scheme of Saltelli (2010): for each of N base samples, two points a and b are drawn in
+	the parameter space (from a Latin hypercube or the Sobol sequence, see SampleDesign), and the model is run at
+	a, at b, and at a with parameter i taken from b (ab_i) for each parameter, so N (numParams + 2) runs in all.
+	For each output f, with V the variance of f over the a and b points:
+		first order index  S_i  = mean(f(b) (f(ab_i) - f(a))) / V   (Saltelli 2010)
+		total order index  ST_i = mean((f(a) - f(ab_i))^2) / 2V     (Jansen 1999)
+
+	The base samples are generated, run and added to the estimators a block at a time (the runs of a block are an
+	SWDEnsemble, run on all the cores), so only the sums of the estimators are kept, and the memory stays bounded
+	however many samples there are.  Optionally, every run (its parameters and outputs) can be written to a file
+	as the blocks finish.
+*/
+class SWDSensitivity {
+
+	SWDEnsemble ensemble; // runs the blocks (the base parameters and temperatures are shared by all of them)
+
+	ParameterRanges ranges; // parameters varied, and the range of each
+	std::vector<std::string> outputNames; // outputs analysed (see SWDEnsemble::getSummaryNames)
+	std::vector<int> outputColumns; // column of each output in the ensemble summaries
+
+	SampleDesign design;
+	uint64_t seed; // (for the Latin hypercube design)
+	int blockSize; // base samples run at a time
+
+	// sums of the estimators of each output (over the base samples so far), with the outputs shifted by the mean of
+	// the first block (shift) for accuracy
+	struct Estimators {
+		double shift;
+		double sum, sumSquares; // of f(a) and f(b)
+		std::vector<double> firstOrderSums; // of f(b) (f(ab_i) - f(a)), for each parameter
+		std::vector<double> totalOrderSums; // of (f(a) - f(ab_i))^2, for each parameter
+	};
+	std::vector<Estimators> estimators;
+	long numSamples; // base samples added to the estimators
+
+	void addBlock(int numBlockSamples, std::ofstream &samplesOut);
+
+public:
+
+	SWDSensitivity(const Parameters &baseParams, const std::vector<double> &temperatures);
+
+	errormsg loadRanges(std::string rangesFile);
+	errormsg addRange(std::string paramName, double minValue, double maxValue);
+	errormsg setOutputs(const std::vector<std::string> &outputNamesNew);
+
+	errormsg run(long numSamplesNew, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, std::string samplesFile = "");
+
+	double getVariance(int output) const;
+	double getFirstOrderIndex(int output, int param) const;
+	double getTotalOrderIndex(int output, int param) const;
+	errormsg printIndices(std::string outputFile) const;
+
+	// accessors and mutators
+	void setDesign(SampleDesign designNew, uint64_t seedNew = 1) { design = designNew; seed = seedNew; }
+	void setBlockSize(int blockSizeNew) { blockSize = blockSizeNew > 0 ? blockSizeNew : 1; }
+	void setNumThreads(int numThreads) { ensemble.setNumThreads(numThreads); }
+	void setIntegrator(IntegratorMode integrator) { ensemble.setIntegrator(integrator); }
+	int getNumParams() const { return ranges.size(); }
+	int getNumOutputs() const { return outputNames.size(); }
+	long getNumSamples() const { return numSamples; }
+
+};
+
+#endif
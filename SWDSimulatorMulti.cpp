@@ -8,44 +8,149 @@
 
 */
 
-// this method basically sets up and runs the thread wrapper for a cell
-// each of the cells running concurrently is set up with one of these - the threadarg is a 
-// reference to a RunStruct struct which contains all the arguments necessary to run the simulation
-// the arguments are: numTimeSteps to run for, threadCells[i] the particular cell to simulate over, 
-// 					  timeStep the timestep to start at, dt the integration step, ignoreFruit, ignoreDiapause submodel bools
+// this method runs the simulation of a cell (it is run by one of the workers of the pool, see runCellTask)
+// the argument is a reference to a RunStruct struct which contains all the arguments necessary to run the simulation
+// the arguments are: numTimeSteps to run for, cell the particular cell to simulate over, 
+// 					  clock the day to start at (and the integration step dt), ignoreFruit, ignoreDiapause submodel bools
 // 					  startDay day to add the flies, temps the temperature array, hasNan bool signifying whether the cell has NaN temperatures 
 // Note: if the temperatures are NaNs, the simulation is not run (since the results would be nonsensical, so there's 
 //       no point wasting the computational time)
-void* runThread(void *threadarg) {
-	struct RunStruct *o;
-
-    o = (struct RunStruct *) threadarg; // save the threadargs as a struct reference
-
+void runCell(RunStruct *o) {
 	bool ignoreDiap = o->ignoreDiapause;
 	int startDay = o->startDay;
 
 	if (startDay >= 0)
 		o->cell.setAddInitPop(true); // if valid startday, set variable to ensure that init pop isn't added before injection date, regardless of diapause
 
-	int tempSize = o->temps.size(); // the number of temperature values
+	int tempSize = o->series.size(); // the number of temperature values
+	int firstDay = o->clock.day; // the temperatures start at the first day of the run
+	long numSteps = o->clock.getNumSteps(o->numTimeSteps);
+	SWDCellSingle::StepFunction stepForward = o->cell.getStepFunction(o->ignoreFruit, ignoreDiap); // kernel for the submodel switches
+	if (!o->hasNan)
+		o->cell.reserveSteps(numSteps, o->clock.stepsPerDay); // so the steps don't allocate memory (and contend for the allocator with the other threads)
 
-	for (double i = 0; round2Decimals(i) < o->numTimeSteps; i = i + o->dt) {
+	for (long k = 0; k < numSteps; k ++) {
 
 		if (o->hasNan || tempSize == 0) // don't simulate if there are NaNs
 			break;
 
-		double temp = o->temps[((int)i) % tempSize]; // constant temp!!!!! (for now)
+		double temp = o->series[(o->clock.day - firstDay) % tempSize]; // constant temp!!!!! (for now)
 
-		if ((int) o->timeStep == startDay && !o->injectFlies) {
+		if (o->clock.day == startDay && !o->injectFlies) {
 			o->injectFlies = true;
 			o->cell.readInitFlies(); // read in initial populations on the chosen date
 		}
 
-		o->cell.SWDCellSingle::stepForward(temp, o->ignoreFruit, ignoreDiap, o->dt, o->timeStep);
-		o->timeStep += o->dt; // increase the current timestep accordingly
+		(o->cell.*stepForward)(temp, o->clock);
+		o->clock.advance(); // increase the current timestep accordingly
 	}
+}
 
-	pthread_exit(NULL);
+// this method is the equivalent of runCell for a batch of cells (in batch mode), and the argument is a reference
+// to a BatchRunStruct
+// all the cells of the batch (except those with NaN temperatures) are stepped together with an SWDCellBatch
+void runCellBatch(BatchRunStruct *o) {
+	std::vector<SWDCellSingle*> batchCells;
+	std::vector<const TemperatureSeries*> batchTemps;
+	for (int i = 0; i < o->cells.size(); i ++) {
+		if (o->hasNan[i] || o->series[i].size() == 0) // don't simulate if there are NaNs
+			continue;
+		if (o->startDay >= 0)
+			o->cells[i].setAddInitPop(true); // if valid startday, set variable to ensure that init pop isn't added before injection date, regardless of diapause
+		batchCells.push_back(&o->cells[i]);
+		batchTemps.push_back(&o->series[i]);
+	}
+
+	SWDCellBatch batch(batchCells);
+	std::vector<double> temps(batchCells.size()); // temperature of each cell for the current timestep
+	bool injectFlies = false;
+	int firstDay = o->clock.day; // the temperatures start at the first day of the run
+	long numSteps = o->clock.getNumSteps(o->numTimeSteps);
+	SWDCellBatch::StepFunction stepForward = batch.getStepFunction(o->ignoreFruit, o->ignoreDiapause); // kernel for the submodel switches
+	for (int c = 0; c < batchCells.size(); c ++)
+		batchCells[c]->reserveSteps(numSteps, o->clock.stepsPerDay); // so the steps don't allocate memory (and contend for the allocator with the other threads)
+
+	for (long k = 0; k < numSteps && batchCells.size() > 0; k ++) {
+
+		for (int c = 0; c < batchCells.size(); c ++)
+			temps[c] = (*batchTemps[c])[(o->clock.day - firstDay) % batchTemps[c]->size()];
+
+		if (o->clock.day == o->startDay && !injectFlies) {
+			injectFlies = true;
+			for (int c = 0; c < batchCells.size(); c ++)
+				batchCells[c]->readInitFlies(); // read in initial populations on the chosen date
+		}
+
+		(batch.*stepForward)(&temps[0], o->clock);
+		o->clock.advance(); // increase the current timestep accordingly
+	}
+}
+
+// this method is the task run by the worker pool for each active gridcell (the tasks are the active cells in order,
+// see GridMask, and the cells in the grid are numbered row by row)
+// the arg is a reference to the RunSettings of the run: the cell is set up from the simulator's cell (so it has the
+// same parameters as the rest of the grid), run with runCell, and left in settings.cellRuns for a writer thread to print
+void SWDSimulatorMulti::runCellTask(int task, void *arg) {
+	RunSettings *settings = (RunSettings *) arg;
+	const SWDSimulatorMulti *sim = settings->sim;
+	int i = sim->mask.getActiveCell(task);
+	int r = i / sim->numCols, c = i % sim->numCols;
+
+	SWDCellMulti cell(sim->threadCells[0]);
+	cell.resetTime();
+	sim->setCellLatitude(cell, r, c); // (needed for daylight hours calculations)
+
+	std::vector<double> temps;
+	TemperatureSeries series;
+	bool hasNan = sim->getCellTemperatures(*settings, i, temps, series);
+
+	// the cell and temperatures are moved into the RunStruct, which is handed to the writers as is (nothing is copied back)
+	RunStruct *o = new RunStruct(settings->numTimeSteps, std::move(cell), sim->clock, settings->ignoreFruit, settings->ignoreDiapause, settings->startDay, std::move(temps), hasNan);
+	if (sim->climateCube)
+		o->series = series; // (a view of the cube)
+	runCell(o);
+	settings->cellRuns[task].reset(o);
+	settings->finished.push(task); // (waits if the writers are behind)
+}
+
+// this method is the equivalent of runCellTask in batch mode, where each task is a batch of batchSize active cells
+// (numbered in the same order as the cells), which are run together with runCellBatch and left in settings.batchRuns
+void SWDSimulatorMulti::runBatchTask(int task, void *arg) {
+	RunSettings *settings = (RunSettings *) arg;
+	const SWDSimulatorMulti *sim = settings->sim;
+	int numCells = sim->mask.getNumActive();
+
+	BatchRunStruct *o = new BatchRunStruct();
+	o->numTimeSteps = settings->numTimeSteps;
+	o->clock = sim->clock;
+	o->ignoreFruit = settings->ignoreFruit;
+	o->ignoreDiapause = settings->ignoreDiapause;
+	o->startDay = settings->startDay;
+
+	int first = task * sim->batchSize;
+	int size = std::min(sim->batchSize, numCells - first);
+	o->cells.reserve(size); // (so the cells are only moved once, not again as the vectors grow)
+	o->temps.reserve(size);
+	o->series.reserve(size);
+	for (int k = first; k < first + size; k ++) {
+		int i = sim->mask.getActiveCell(k);
+		int r = i / sim->numCols, c = i % sim->numCols;
+
+		SWDCellMulti cell(sim->threadCells[0]); // same parameters as the rest of the grid
+		cell.resetTime();
+		sim->setCellLatitude(cell, r, c); // (needed for daylight hours calculations)
+
+		std::vector<double> temps;
+		TemperatureSeries series;
+		o->hasNan.push_back(sim->getCellTemperatures(*settings, i, temps, series));
+		o->temps.push_back(std::move(temps));
+		o->series.push_back(sim->climateCube ? series : TemperatureSeries(o->temps.back())); // (temps was reserved, so this stays valid)
+		o->cells.push_back(std::move(cell));
+	}
+
+	runCellBatch(o);
+	settings->batchRuns[task].reset(o);
+	settings->finished.push(task); // (waits if the writers are behind)
 }
 
 // method to do nothing when thread is executed (could be used for dud cells if necessary)
@@ -53,17 +158,26 @@ void* bogusRun(void* pls) {}
 
 // constructor for the SWDSimulatorMulti
 // takes in model parameters, number of rows/cols for the grid of cells, and the list of corresponding lat/lon pairs
-SWDSimulatorMulti::SWDSimulatorMulti(std::string paramFile, int rows, int cols, std::vector<std::vector<double>> latitudes1) : numRows(rows), numCols(cols), latitudes(latitudes1) {
-	dt = 0.05;
-	numThreads = 2;
-	timeStep = 0;
+SWDSimulatorMulti::SWDSimulatorMulti(std::string paramFile, int rows, int cols, std::vector<std::vector<double>> latitudes1) : numRows(rows), numCols(cols), latitudes(latitudes1), mask(rows, cols) {
+	clock.setDT(getDefaultDT(EULER_INTEGRATOR));
+	numThreads = WorkerPool::getDefaultNumWorkers(); // one worker per hardware thread
+	batchSize = 0; // step the cells one at a time by default
+	summaryOnly = false;
+	recorderMode = RECORD_EVERY_STEP;
+	recorderEveryDays = 1;
+	numWriters = 1;
+	resultsSinglePrecision = false;
+	resultsChunkDays = 365;
+	outputQueueSize = 0; // (2 per worker)
+	prefetchDepth = 0; // (2 per worker)
+	numReaders = 1;
+	inputWaitTime = 0;
+	numPrefetchMisses = 0;
 	
 	Parameters newParams(paramFile);
 
-	for (int r = 0; r < numThreads; r++){
-		threadCells.push_back(SWDCellMulti(0, 0, newParams)); // default temps
-	}
-		
+	threadCells.push_back(SWDCellMulti(0, 0, newParams)); // default temps
+	
 
 	resetTime();
 }
@@ -72,130 +186,443 @@ SWDSimulatorMulti::SWDSimulatorMulti(std::string paramFile, int rows, int cols,
 void SWDSimulatorMulti::setDefaultParams() {
 	Parameters paramsNew; // default parameters
 	
-	for(int r = 0; r < numThreads; r++){
+	for(int r = 0; r < threadCells.size(); r++){
 		threadCells[r].resetCellParams(paramsNew); // apply changes to each cell, reset parameters to those read in
 	}
+
+	if (rateTable) // the rates need to be retabulated for the new parameters (with the same range and resolution)
+		useRateTable(rateTable->getResolution(), rateTable->getMinTemp(), rateTable->getMaxTemp());
+}
+
+// method to choose the integration method of all the cells (see IntegratorMode)
+// the integration step is also set to the usual step for the method (see getDefaultDT)
+// note: batch mode (see setBatchSize) only vectorizes Euler's method, so the cells are stepped one at a time
+// with the other integrators (which are much faster per day anyway)
+void SWDSimulatorMulti::setIntegrator(IntegratorMode integrator) {
+	for (int r = 0; r < threadCells.size(); r++){
+		threadCells[r].setIntegrator(integrator);
+	}
+	clock.setDT(getDefaultDT(integrator));
+}
+
+// method to set the error tolerances of the Runge-Kutta integrator for all the cells
+// each step of the integrator keeps its error estimate within absTolerance + relTolerance * |population|
+void SWDSimulatorMulti::setTolerances(double absTolerance, double relTolerance) {
+	for (int r = 0; r < threadCells.size(); r++){
+		threadCells[r].setTolerances(absTolerance, relTolerance);
+	}
+}
+
+// method to choose which steps of all the cells are kept in their data series (see RecorderMode)
+// the output files only have one line per day, so RECORD_DAILY keeps exactly what is printed, with 1/20 of the
+// memory per cell (with dt = 0.05) of the default RECORD_EVERY_STEP
+// in summary-only mode nothing is recorded, and the mode is only used once summary-only mode is turned off
+void SWDSimulatorMulti::setRecorder(RecorderMode mode, int everyDays) {
+	recorderMode = mode;
+	recorderEveryDays = everyDays;
+	for (int r = 0; r < threadCells.size(); r++){
+		threadCells[r].setRecorder(summaryOnly ? RECORD_NONE : mode, everyDays);
+	}
+}
+
+// method to choose whether only the summary of each cell is printed (see printSummary)
+// in summary-only mode the data series aren't recorded at all (RECORD_NONE), so a cell only holds its running
+// totals/peaks/statistics, no matter how long the run is, and the data files aren't needed (or written)
+// turning it off goes back to the recorder mode set by setRecorder (every step by default)
+void SWDSimulatorMulti::setSummaryOnly(bool on) {
+	summaryOnly = on;
+	setRecorder(recorderMode, recorderEveryDays);
+}
+
+// method to choose the extra statistics computed by all the cells as they are stepped (see StatisticsFlags)
+// these are added to the summary files
+void SWDSimulatorMulti::setStatistics(int flags, double degreeDayBase) {
+	for (int r = 0; r < threadCells.size(); r++){
+		threadCells[r].setStatistics(flags, degreeDayBase);
+	}
+}
+
+// method to set a threshold female population of all the cells (for STATS_THRESHOLD_DAYS)
+void SWDSimulatorMulti::setThresholdPop(int index, double population) {
+	for (int r = 0; r < threadCells.size(); r++){
+		threadCells[r].setThresholdPop(index, population);
+	}
+}
+
+// method to switch the cells to tabulated temperature-dependent rates (see RateTable)
+// the table is built once, from the current (non-fruit) parameters of the grid, over the specified temperature 
+// range at the specified resolution (in degrees), and shared by every cell
+// the max interpolation error of the table (vs the analytic functions) is returned, to help choose a resolution
+RateTableError SWDSimulatorMulti::useRateTable(double resolution, double minTemp, double maxTemp) {
+	rateTable = std::make_shared<const RateTable>(threadCells[0].getCompiledParams(), resolution, minTemp, maxTemp);
+	applyRateTable();
+	return rateTable->computeError();
+}
+
+// method to switch the cells back to the analytic temperature-dependent rates
+void SWDSimulatorMulti::useAnalyticRates() {
+	rateTable.reset();
+	applyRateTable();
+}
+
+// method to get the latitude of the gridcell at row r, col c (if the latitudes were given, otherwise the latitude
+// in the climate cube, if there is one, otherwise the latitude from the parameters)
+double SWDSimulatorMulti::getCellLatitude(int r, int c) const {
+	if (latitudes.size() > 0)
+		return latitudes[r][c];
+	if (climateCube)
+		return climateCube->getLatitude(r * numCols + c);
+	return threadCells[0].getCompiledParams().latitude;
+}
+
+// method to build the daylight hours table of every distinct latitude of the active cells of the grid
+// the tables are only computed the first time the latitude comes up, so all the cells in a row share one table
+void SWDSimulatorMulti::buildPhotoperiodTables() {
+	for (int k = 0; k < mask.getNumActive(); k ++) {
+		int i = mask.getActiveCell(k);
+		photoperiods.getTable(getCellLatitude(i / numCols, i % numCols));
+	}
+}
+
+// method to set the latitude of a cell to that of the gridcell at row r, col c, and give it the daylight hours table 
+// for the latitude (from buildPhotoperiodTables, so this only reads the tables and can be called from the workers)
+void SWDSimulatorMulti::setCellLatitude(SWDCellMulti &cell, int r, int c) const {
+	if (latitudes.size() > 0 || climateCube) {
+		std::string param = "latitude";
+		cell.setSingleParameter(param, getCellLatitude(r, c));
+	}
+	cell.setPhotoperiodTable(photoperiods.findTable(getCellLatitude(r, c)));
+}
+
+// method to give every cell the current rate table (or none, if it is null)
+void SWDSimulatorMulti::applyRateTable() {
+	for (int r = 0; r < threadCells.size(); r++){
+		threadCells[r].setRateTable(rateTable);
+	}
 }
 
 // method to run the simulation over all gridcells for the specified number of timesteps with the specified parameters
 // fileNames : a 2D grid of filenames, each the name of the file to print per-day population values in for the corresponding grid cell, post sim
 // summaryFiles : a 2D grid of filenames, each the name of the file to print sim summary values in for the corresponding grid cell, post sim
 // tempsFiles : a 2D grid of filenames, each the name of the file to read temperature values in for the corresponding grid cell, for the sim
-void SWDSimulatorMulti::run(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, std::vector<std::vector<std::string>> fileNames, std::vector<std::vector<std::string>> summaryFiles, std::vector<std::vector<std::string>> tempsFiles) {
-	maxCellPopulation = 0;
+// the cells are run by a pool of numThreads workers, and each cell is printed by a writer thread as soon as it finishes (see runTasks)
+// only the active cells of the mask (see useMask) are run; the masked cells get placeholder output (see printPlaceholders)
+void SWDSimulatorMulti::run(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, const std::vector<std::vector<std::string>> &fileNames, const std::vector<std::vector<std::string>> &summaryFiles, const std::vector<std::vector<std::string>> &tempsFiles) {
+	if (batchSize > 0 && getIntegrator() == EULER_INTEGRATOR) { // step the cells together in batches instead
+		runBatched(numTimeSteps, ignoreFruit, ignoreDiapause, startDay, fileNames, summaryFiles, tempsFiles);
+		return;
+	}
 
-	int rc;
+	int numCells = mask.getNumActive();
+	RunSettings settings(this, numTimeSteps, ignoreFruit, ignoreDiapause, startDay, tempsFiles, fileNames, summaryFiles, outputQueueSize > 0 ? outputQueueSize : 2 * numThreads);
+	settings.cellRuns.resize(numCells);
 
-	int r = 0, c = 0;
+	runTasks(settings, numCells, runCellTask);
 
-	for (int k = 0; k < numRows*numCols; k += numThreads) { // go up by the number of threads available, since this is the number of cells run at a time
-		
-		// set up the list of threads and RunStructs (for the simulation parameters of each thread)
-		pthread_t tSims[4];
-		struct RunStruct rn[4];
-   		
-   		int cc = c;
-   		int cr = r;
-   		for (int i = 0; i < numThreads; i ++) { // for each thread
-			
-			// set up each thread that corresponds to a valid gridcell coordinate
-			if (cr < numRows && cc < numCols) {
-				threadCells[i].resetTime();
-				std::vector<double> temps;
-				bool hasNan = false;
-				if (tempsFiles.size() > 0) { // read in temperature values for the cell, if there are any
-					std::ifstream fileIn;
-					fileIn.open(tempsFiles[cr][cc]);
-
-					double v;
-					while (fileIn >> v) {
-						temps.push_back(v);
-						if (v != v)
-							hasNan = true;
-					}
-
-					fileIn.close();
-
-				} else
-					temps.push_back(15); // if no temps file, run at a constant 15 degrees (the sim can be run with no temp file if you really want)
-
-				if (latitudes.size() > 0) {
-					std::string param = "latitude";
-					threadCells[i].setSingleParameter(param, latitudes[cr][cc]); // set latitude of the cell (needed for daylight hours calculations)
-				}
-
-				// create the list of thread running parameters
-				rn[i] = RunStruct(numTimeSteps, threadCells[i], timeStep, dt, ignoreFruit, ignoreDiapause, startDay, temps, hasNan);
-				rc = pthread_create(&tSims[i], NULL, runThread, (void *)&rn[i]); // run the thread (with the runThread method above)
-			}
-			// else {
-			// 	rn[i] = RunStruct(0, threadCells[0], 0, 0, true);
-			// 	rc = pthread_create(&tSims[i], NULL, bogusRun, (void *)&rn[i]);
-			// }
-
-
-			if (rc) {
-		        std::cout << "Error:unable to create thread," << rc << std::endl;
-		        exit(-1);
-	    	}
-
-	    	// update values (wrap around to col 0 if passed max column)
-			cc ++;
-			if (cc >= numCols) {
-				cc = 0;
-				cr ++;
-			}
-			
+	clock.day += numTimeSteps; // update the current day of the simulation over all cells
+
+}
+
+// method to run the simulation in batch mode (see run above for the arguments)
+// the active cells are split into batches of batchSize cells, and each task of the worker pool steps a whole batch together
+// (see SWDCellBatch); the cells of each batch are printed as soon as the batch finishes, as in run
+void SWDSimulatorMulti::runBatched(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, const std::vector<std::vector<std::string>> &fileNames, const std::vector<std::vector<std::string>> &summaryFiles, const std::vector<std::vector<std::string>> &tempsFiles) {
+	int numCells = mask.getNumActive();
+	int numBatches = (numCells + batchSize - 1) / batchSize;
+	RunSettings settings(this, numTimeSteps, ignoreFruit, ignoreDiapause, startDay, tempsFiles, fileNames, summaryFiles, outputQueueSize > 0 ? outputQueueSize : 2 * numThreads);
+	settings.batchRuns.resize(numBatches);
+
+	runTasks(settings, numBatches, runBatchTask);
+
+	clock.day += numTimeSteps; // update the current day of the simulation over all cells
+}
+
+// method to run the tasks of a run (the cells, or the batches in batch mode) on a pool of numThreads workers (see WorkerPool)
+// the output is pipelined: as the workers finish the tasks, they push them to the settings.finished queue, and numWriters 
+// writer threads pop them and print them while the workers carry on with the rest
+// if the writers fall behind (e.g. on a slow file system), the queue fills up and holds the workers back, so the finished 
+// cells waiting to be printed (and their memory) are limited to the size of the queue
+// meanwhile, this thread writes the placeholder output of the masked cells
+void SWDSimulatorMulti::runTasks(RunSettings &settings, int numTasks, TaskFunction task) {
+	buildPhotoperiodTables(); // (before the workers start, since they share the tables)
+	settings.maxFemales.assign(numRows * numCols, 0); // (0 for the masked cells)
+	int numWorkers = std::max(1, std::min(numThreads, numTasks));
+
+	// read the cells' temperatures in the order the workers should get to them (in batch mode, the cells of each batch in turn)
+	std::vector<int> taskOrder = WorkerPool::getTaskOrder(numTasks, numWorkers);
+	std::vector<int> cellOrder;
+	if (settings.batchRuns.size() > 0) {
+		for (int t = 0; t < taskOrder.size(); t ++) {
+			for (int k = taskOrder[t] * batchSize; k < (taskOrder[t] + 1) * batchSize && k < mask.getNumActive(); k ++)
+				cellOrder.push_back(mask.getActiveCell(k));
+		}
+	} else {
+		for (int t = 0; t < taskOrder.size(); t ++)
+			cellOrder.push_back(mask.getActiveCell(taskOrder[t]));
+	}
+	if (climateCube)
+		cellOrder.clear(); // (there are no files to read)
+	TemperaturePrefetcher prefetcher(settings.tempsFiles, numRows * numCols, numCols, cellOrder, prefetchDepth > 0 ? prefetchDepth : 2 * numWorkers, climateCube ? 0 : numReaders);
+	settings.prefetcher = &prefetcher;
+
+	GridOutputWriter gridOutput;
+	if (gridOutputFile.size() > 0) {
+		errormsg status = gridOutput.open(gridOutputFile, numRows, numCols);
+		if (status.compare("Success!") == 0)
+			settings.gridOutput = &gridOutput;
+		else
+			std::cout << status << std::endl;
+	}
+
+	ResultsWriter results;
+	if (resultsFile.size() > 0) {
+		const char* columnNames[] = {"time", "eggs", "instar1", "instar2", "instar3", "pupae", "males", "females", "fruitQuality"};
+		errormsg status = results.open(resultsFile, numRows, numCols, std::vector<std::string>(columnNames, columnNames + 9), resultsSinglePrecision, resultsChunkDays);
+		if (status.compare("Success!") == 0)
+			settings.results = &results;
+		else
+			std::cout << status << std::endl;
+	}
+
+	std::vector<pthread_t> writers(numWriters);
+	for (int w = 0; w < numWriters; w ++) {
+		int rc = pthread_create(&writers[w], NULL, writerThread, (void *)&settings);
+		if (rc) {
+	        std::cout << "Error:unable to create thread," << rc << std::endl;
+	        exit(-1);
+    	}
+	}
+
+	{
+		WorkerPool pool(numWorkers);
+		pool.submit(numTasks, task, (void *)&settings);
+		printPlaceholders(settings); // (while the workers run the active cells)
+		while (pool.waitForTask() >= 0); // wait for all the tasks (the writers print them)
+	}
+
+	for (int w = 0; w < numWriters; w ++)
+		settings.finished.push(-1); // (once the writers get to these, everything has been printed)
+	for (int w = 0; w < numWriters; w ++)
+		pthread_join(writers[w], NULL);
+
+	if (settings.gridOutput) { // (the index is written once all the cells are in)
+		errormsg status = gridOutput.close();
+		if (status.compare("Success!") != 0)
+			std::cout << status << std::endl;
+	}
+	if (settings.results) {
+		errormsg status = results.close();
+		if (status.compare("Success!") != 0)
+			std::cout << status << std::endl;
+	}
+
+	inputWaitTime = prefetcher.getWaitTime();
+	numPrefetchMisses = prefetcher.getNumMissed();
+
+	// update the max population (in the grid order, so ties go to the first cell)
+	maxCellPopulation = 0;
+	for (int i = 0; i < settings.maxFemales.size(); i ++) {
+		if (settings.maxFemales[i] > maxCellPopulation) {
+			maxCellPopulation = settings.maxFemales[i];
+			maxCellCoords[0] = i / numCols;
+			maxCellCoords[1] = i % numCols;
 		}
+	}
+}
 
-		// join all sim threads to main thread, i.e. main thread doesn't continue until all sim threads are done
-		cc = c; cr = r;
-		for (int i = 0; i < numThreads; i ++) {
-			
-			if (cr < numRows && cc < numCols)	{
-				pthread_join(tSims[i], NULL);
-			}
-			
-			cc ++;
-			if (cc >= numCols) {
-				cc = 0;
-				cr ++;
-			}
+// this method is the entry point of each writer thread, and the threadarg is a reference to the RunSettings of the run
+// the writer prints each finished cell (or batch) it pops from the queue, and frees it, until it pops -1
+// (the text is formatted in the writer's own buffers, which are reused for every cell it prints)
+void* SWDSimulatorMulti::writerThread(void *threadarg) {
+	RunSettings *settings = (RunSettings *) threadarg;
+	const SWDSimulatorMulti *sim = settings->sim;
+	TextBuffer data, summary;
+
+	for (int task = settings->finished.pop(); task >= 0; task = settings->finished.pop()) {
+		if (settings->batchRuns.size() > 0) {
+			const std::vector<SWDCellMulti> &cells = settings->batchRuns[task]->cells;
+			for (int j = 0; j < cells.size(); j ++)
+				sim->printCell(cells[j], sim->mask.getActiveCell(task * sim->batchSize + j), *settings, data, summary);
+			settings->batchRuns[task].reset();
+		} else {
+			sim->printCell(settings->cellRuns[task]->cell, sim->mask.getActiveCell(task), *settings, data, summary);
+			settings->cellRuns[task].reset();
 		}
+	}
+
+	pthread_exit(NULL);
+}
+
+// method to print the info of the cell just simulated over, which is gridcell i (numbered row by row), to the grid
+// output file, if there is one, or otherwise its output files, if it has them, and record its peak female population
+// with a results file, the data series are written to it instead of as text, and only the summary is printed
+// the text of the files is formatted into the data and summary buffers, and each file is written in one go
+void SWDSimulatorMulti::printCell(const SWDCellMulti &cell, int i, RunSettings &settings, TextBuffer &data, TextBuffer &summary) const {
+	int r = i / numCols, c = i % numCols;
+	const std::vector<std::vector<std::string>> &fileNames = settings.fileNames;
+	const std::vector<std::vector<std::string>> &summaryFiles = settings.summaryFiles;
+	bool printData = !summaryOnly && !settings.results;
+
+	if (settings.results && !summaryOnly)
+		writeResults(cell, i, settings);
+
+	data.clear();
+	summary.clear();
+	if (settings.gridOutput) { // (the same text as the files, as one chunk)
+		if (printData)
+			writeCellData(cell, data);
+		writeSummary(cell, summary);
+		settings.gridOutput->writeCell(i, data.str(), summary.str());
+	} else if (!printData) {
+		if (summaryFiles.size() > 0 && summaryFiles[r][c].compare("") != 0) {
+			writeSummary(cell, summary);
+			summary.writeFile(summaryFiles[r][c]);
+		}
+	} else if (fileNames.size() > 0 && fileNames[r][c].compare("") != 0 && summaryFiles[r][c].compare("") != 0) {
+		writeCellData(cell, data);
+		data.writeFile(fileNames[r][c]);
+		writeSummary(cell, summary);
+		summary.writeFile(summaryFiles[r][c]);
+	}
 
-		// after all the threads have finished their simulations, the main thread regains control
-		// and this section fo the code is reached
-		for (int i = 0; i < numThreads; i ++) {
-			
-			// print info for the cells just simulated over
-			if (fileNames[r][c].compare("") != 0 && summaryFiles[r][c].compare("") != 0) {
-				if (r < numRows && c < numCols) {
-					
-					threadCells[i] = rn[i].cell;
-					printCellInfo(i, fileNames[r][c], summaryFiles[r][c]);	
-				}
-			}
-			if (r < numRows && c < numCols && threadCells[i].getMaxFemales() > maxCellPopulation) { // update the max population
-				maxCellPopulation = threadCells[i].getMaxFemales();
-				maxCellCoords[0] = r;
-				maxCellCoords[1] = c;
-			}
-
-			c ++;
-			if (c >= numCols) {
-				c = 0;
-				r ++;
-			}
-			if (r >= numRows) {
-				break;
-			}
+	settings.maxFemales[i] = cell.getMaxFemales();
+}
+
+// method to write the data series of the cell just simulated over, which is gridcell i (numbered row by row), to the
+// results file: the same daily points as the data file, as columns (the time, each stage, and the fruit quality)
+void SWDSimulatorMulti::writeResults(const SWDCellMulti &cell, int i, RunSettings &settings) const {
+	const XYSeries* toPrint[8] = {&cell.getEggSeries(), &cell.getInst1Series(), &cell.getInst2Series(), &cell.getInst3Series(),
+								  &cell.getPupaeSeries(), &cell.getMalesSeries(), &cell.getFemalesSeries(), &cell.getFruitQualitySeries()};
+
+	int pointsPerDay = cell.getPointsPerDay(clock.stepsPerDay);
+	int numDays = (toPrint[0]->size() + pointsPerDay - 1) / pointsPerDay;
+	std::vector<std::vector<double>> columns(9, std::vector<double>(numDays));
+	for (int d = 0; d < numDays; d ++) {
+		columns[0][d] = (*toPrint[0])[d * pointsPerDay].getX();
+		for (int jk = 0; jk < 8; jk ++)
+			columns[jk + 1][d] = (*toPrint[jk])[d * pointsPerDay].getY();
+	}
+
+	settings.results->writeCell(i, columns);
+}
+
+// method to print the output of the masked cells (see GridMask), which is what an unsimulated cell prints (i.e. a cell
+// with NaN temperatures): the headers of the data file and a summary of zeros
+// the placeholder is only formatted once, and then written to the files of every masked cell (or once to the grid output file)
+void SWDSimulatorMulti::printPlaceholders(RunSettings &settings) const {
+	if (mask.getNumActive() == numRows * numCols)
+		return;
+
+	SWDCellMulti placeholder(threadCells[0]); // same parameters as the rest of the grid, never run
+	placeholder.resetTime();
+	bool printData = !summaryOnly && !settings.results; // (with a results file, the masked cells just have no days in it)
+	TextBuffer data, summary;
+	if (printData)
+		writeCellData(placeholder, data);
+	writeSummary(placeholder, summary);
+
+	if (settings.gridOutput) { // (all the masked cells share one chunk)
+		std::vector<int> maskedCells;
+		for (int i = 0; i < numRows * numCols; i ++) {
+			if (!mask.isActive(i))
+				maskedCells.push_back(i);
 		}
-			
+		settings.gridOutput->writeCells(maskedCells, data.str(), summary.str());
+		return;
+	}
+
+	const std::vector<std::vector<std::string>> &fileNames = settings.fileNames;
+	const std::vector<std::vector<std::string>> &summaryFiles = settings.summaryFiles;
+	for (int i = 0; i < numRows * numCols; i ++) {
+		if (mask.isActive(i))
+			continue;
+		int r = i / numCols, c = i % numCols;
+		
+		// (the same files as printCell)
+		if (!printData) {
+			if (summaryFiles.size() == 0 || summaryFiles[r][c].compare("") == 0)
+				continue;
+		} else if (fileNames.size() == 0 || fileNames[r][c].compare("") == 0 || summaryFiles[r][c].compare("") == 0)
+			continue;
+
+		if (printData)
+			data.writeFile(fileNames[r][c]);
+		summary.writeFile(summaryFiles[r][c]);
+	}
+}
 
+// method to take the temperatures of the specified cell (numbered row by row) from the climate cube, if there is one,
+// or otherwise its temperature file (through the prefetcher)
+// with the cube, series is set to a view of the cell's temperatures in the cube (nothing is read or copied), and otherwise
+// the temperatures are read into temps (and series is left for the caller to point at them, once temps is in place)
+// returns true if any of the temperatures are NaN
+bool SWDSimulatorMulti::getCellTemperatures(RunSettings &settings, int cell, std::vector<double> &temps, TemperatureSeries &series) const {
+	if (climateCube) {
+		series = climateCube->getSeries(cell);
+		return climateCube->hasNan(cell);
 	}
+	return settings.prefetcher->take(cell, temps);
+}
 
-	timeStep += numTimeSteps; // update the current timestep of the simulation over all cells
+// method to print every cell of a run to a single grid output file (see GridOutputFile.h), instead of a data file and
+// a summary file per cell (the fileNames and summaryFiles given to run are then ignored, and can be left empty)
+// the per-cell files can be reproduced from the grid output file with the extractGridOutput tool
+// each run replaces the file; useCellOutputFiles goes back to the per-cell files
+void SWDSimulatorMulti::useGridOutput(std::string fileName) {
+	gridOutputFile = fileName;
+}
 
+// method to write the data series of every cell of a run to a binary results file (see ResultsFile.h), which downstream
+// tools can memory-map and slice with a ResultsReader, instead of printing them as text; the summaries are still printed
+// (to the summary files, or the grid output file), and the data files aren't needed (or written)
+// the values are stored as float32 if singlePrecision is true, otherwise float64, in chunks of chunkDays days
+// each run replaces the file; useTextResults goes back to printing the data files
+void SWDSimulatorMulti::useResultsFile(std::string fileName, bool singlePrecision, int chunkDays) {
+	resultsFile = fileName;
+	resultsSinglePrecision = singlePrecision;
+	resultsChunkDays = chunkDays > 0 ? chunkDays : 365;
+}
+
+// method to choose which cells of the grid are simulated from a mask file (see GridMask): the masked cells (i.e. ocean)
+// aren't read, set up, scheduled or run at all, and only get placeholder output files (see printPlaceholders)
+// clearMask goes back to simulating every cell
+// error message is returned if the mask file can't be read or isn't the size of the grid, otherwise if all is well "Success!" is returned
+errormsg SWDSimulatorMulti::useMask(std::string maskFile) {
+	return mask.load(maskFile, numRows, numCols);
+}
+
+// method to mask the cells of the climate cube with NaN temperatures (or none at all), from the cube's header, so they
+// are skipped without touching their temperatures (this gives the same output as running them, since they aren't simulated)
+// error message is returned if there is no climate cube, otherwise if all is well "Success!" is returned
+errormsg SWDSimulatorMulti::useClimateCubeMask() {
+	if (!climateCube)
+		return "Error: there is no climate cube to take the mask from";
+	mask.setFromClimateCube(*climateCube);
+	return "Success!";
+}
+
+// method to memory-map a climate cube with the temperatures of every cell in the grid (see ClimateCube), which is then
+// used instead of the temperature files (tempsFiles can be left empty in run); useTemperatureFiles switches back
+// the cube's latitudes are used for the cells, unless the latitudes were given to the constructor
+// error message is returned if the cube can't be opened or isn't the size of the grid, otherwise if all is well "Success!" is returned
+errormsg SWDSimulatorMulti::useClimateCube(std::string cubeFile) {
+	std::shared_ptr<ClimateCube> cube = std::make_shared<ClimateCube>();
+	errormsg status = cube->open(cubeFile);
+	if (status.compare("Success!") != 0)
+		return status;
+	if (cube->getRows() != numRows || cube->getCols() != numCols)
+		return "Error: the climate cube " + cubeFile + " isn't the same size as the grid";
+
+	climateCube = cube;
+	return status;
+}
+
+// method to choose how the temperature files are read: numReaders reader threads keep depth cells read ahead of the
+// workers (depth 0 for 2 per worker), or with no readers, each worker reads its own cells
+// the time the workers waited for temperatures in a run (see getInputWaitTime) shows whether this needs to be increased
+void SWDSimulatorMulti::setPrefetch(int depth, int readers) {
+	prefetchDepth = depth > 0 ? depth : 0;
+	numReaders = readers > 0 ? readers : 0;
 }
 
 // run the simulation but with no specified temp files (this isn't really used)
@@ -204,78 +631,114 @@ void SWDSimulatorMulti::run(int numTimeSteps, bool ignoreFruit, bool ignoreDiapa
 	run(numTimeSteps, ignoreFruit, ignoreDiapause, startDay, tempNoLen, tempNoLen);
 }
 
+// method to set the number of worker threads that run the cells (numThreadsNew <= 0 for one per hardware thread)
+void SWDSimulatorMulti::setNumThreads(int numThreadsNew) {
+	numThreads = numThreadsNew > 0 ? numThreadsNew : WorkerPool::getDefaultNumWorkers();
+}
+
 // method to print all info from a simulation
 // this includes daily per-stage population values (printed to dataFile), and the summary
 // of the simulation (overall total pop, day of max pop, etc) (printed to summaryFile)
-void SWDSimulatorMulti::printCellInfo(int i, std::string dataFile, std::string summaryFile) {
-	std::string names[] = {"eggs", "instar1", "instar2", "instar3", "pupae", "males", "females"};
-		
-	XYSeries toPrint[8]; // array of data series for all lifestages, and fruit quality, vs time
+void SWDSimulatorMulti::printCellInfo(int i, std::string dataFile, std::string summaryFile) const {
+	printCellInfo(threadCells[i], dataFile, summaryFile);
+}
+
+// same as above, but for any cell (not just the cells in threadCells)
+void SWDSimulatorMulti::printCellInfo(const SWDCellMulti &cell, std::string dataFile, std::string summaryFile) const {
+	TextBuffer fileOut;
+	writeCellData(cell, fileOut);
+	fileOut.writeFile(dataFile);
 	
-	SWDCellMulti& cell = threadCells[i];
+	printSummary(cell, summaryFile);
+}
+
+// method to format the daily per-stage population values of a cell into fileOut (the contents of its data file)
+void SWDSimulatorMulti::writeCellData(const SWDCellMulti &cell, TextBuffer &fileOut) const {
+	const XYSeries* toPrint[8]; // array of the cell's data series for all lifestages, and fruit quality, vs time (not copied)
 	
-	toPrint[0] = cell.getEggSeries();
-	toPrint[1] = cell.getInst1Series();
-	toPrint[2] = cell.getInst2Series();
-	toPrint[3] = cell.getInst3Series();
-	toPrint[4] = cell.getPupaeSeries();
-	toPrint[5] = cell.getMalesSeries();
-	toPrint[6] = cell.getFemalesSeries();
-	toPrint[7] = cell.getFruitQualitySeries();
+	toPrint[0] = &cell.getEggSeries();
+	toPrint[1] = &cell.getInst1Series();
+	toPrint[2] = &cell.getInst2Series();
+	toPrint[3] = &cell.getInst3Series();
+	toPrint[4] = &cell.getPupaeSeries();
+	toPrint[5] = &cell.getMalesSeries();
+	toPrint[6] = &cell.getFemalesSeries();
+	toPrint[7] = &cell.getFruitQualitySeries();
 	
-	std::ofstream fileOut;
-	fileOut.open(dataFile);
 	fileOut << "Time:" << "\t";
 	
 	// all the series have the same number of data points
 	
 	// print daily data
-	for (int jk = 0; jk < 7; jk ++) { // print data labels
-			fileOut << names[jk] << ":\t";
+	for (int jk = 0; jk < NUM_LIFESTAGES; jk ++) { // print data labels
+			fileOut << STAGE_NAMES[jk] << ":\t";
 	}
 	fileOut << "\n";
-	for (int ik = 0; ik < toPrint[0].size(); ik +=20) { // += 20 so it prints every 20th datapoint (i.e. once per day)
-		fileOut << toPrint[0][ik].getX() << "\t"; // print the timestep (same for all series)
+	int pointsPerDay = cell.getPointsPerDay(clock.stepsPerDay); // there is one datapoint per dt, unless only the days are recorded
+	for (int ik = 0; ik < toPrint[0]->size(); ik += pointsPerDay) { // so it prints every 20th datapoint with dt = 0.05 (i.e. once per day)
+		fileOut << (*toPrint[0])[ik].getX() << "\t"; // print the timestep (same for all series)
 		for (int jk = 0; jk < 7; jk ++) {
-				std::stringstream sstm;
-				sstm << toPrint[jk][ik].getY();
-				fileOut << sstm.str() << "\t"; // print the corresponding value for the selected series
+				fileOut << (*toPrint[jk])[ik].getY() << "\t"; // print the corresponding value for the selected series
 		}
 		fileOut << "\n";
 	}
-	
-	fileOut.close();
-	
-	fileOut.open(summaryFile);
-	
+}
+
+// method to print the summary of the simulation of a cell (overall total pop, day of max pop, etc) to summaryFile
+// in summary-only mode (see setSummaryOnly), the diapause and max fruit quality crossing days are added, and any
+// extra statistics the cells compute (see setStatistics) are added after the rest of the summary
+void SWDSimulatorMulti::printSummary(const SWDCellMulti &cell, std::string summaryFile) const {
+	TextBuffer fileOut;
+	writeSummary(cell, fileOut);
+	fileOut.writeFile(summaryFile);
+}
+
+// method to format the summary of the simulation of a cell into fileOut (the contents of its summary file, see printSummary)
+void SWDSimulatorMulti::writeSummary(const SWDCellMulti &cell, TextBuffer &fileOut) const {
 	// print overall data
 	fileOut << "\n\nTotal Cumulative Populations\n";
-	std::stringstream sstm;
-	sstm << "\n\t" << cell.getTotEggs() << "\t" << cell.getTotInst1() << "\t" << cell.getTotInst2() << 
-					"\t" << cell.getTotInst3() << "\t" << cell.getTotPupae() << "\t" << cell.getTotMales() << 
-					"\t" << cell.getTotFemales();;
-				
-	fileOut << sstm.str();
-	fileOut << "\n\nPeak Populations\n";
+	fileOut << "\n\t" << cell.getTotEggs() << "\t" << cell.getTotInst1() << "\t" << cell.getTotInst2() << 
+			"\t" << cell.getTotInst3() << "\t" << cell.getTotPupae() << "\t" << cell.getTotMales() << 
+			"\t" << cell.getTotFemales();
 
-	std::stringstream sstm1;
-	sstm1 << "\n\t" << cell.getMaxEggs() << "\t" << cell.getMaxInst1() << "\t" << cell.getMaxInst2() << 
+	fileOut << "\n\nPeak Populations\n";
+	fileOut << "\n\t" << cell.getMaxEggs() << "\t" << cell.getMaxInst1() << "\t" << cell.getMaxInst2() << 
 			"\t" << cell.getMaxInst3() << "\t" << cell.getMaxPupae() << "\t" << cell.getMaxMales() << 
 			"\t" << cell.getMaxFemales();
 
-	fileOut << sstm1.str();
-
 	fileOut << "\n\nPeak Populations Day\n";
-
-	std::stringstream sstm2;
-	sstm2 << "\n\t" << cell.getDayMaxEggs() << "\t" << cell.getDayMaxInst1() << "\t" << cell.getDayMaxInst2() << 
+	fileOut << "\n\t" << cell.getDayMaxEggs() << "\t" << cell.getDayMaxInst1() << "\t" << cell.getDayMaxInst2() << 
 			"\t" << cell.getDayMaxInst3() << "\t" << cell.getDayMaxPupae() << "\t" << cell.getDayMaxMales() << 
 			"\t" << cell.getDayMaxFemales();
-	
-	fileOut << sstm2.str();
 
-	fileOut.close();
-	
+	if (summaryOnly) { // (these can't be found from the data files, since there aren't any)
+		fileOut << "\n\nDiapause Crossing Day\n";
+		fileOut << "\n\t" << cell.getCrossedDiapDay();
+		fileOut << "\n\nMax Fruit Quality Day\n";
+		fileOut << "\n\t" << cell.getDayCrossedMaxFruit();
+	}
+
+	int statistics = cell.getStatistics();
+	double elapsedDays = cell.getElapsedDays();
+	if ((statistics & STATS_MEANS) && elapsedDays > 0) { // the totals are integrals over time, so the means are these over the time run
+		fileOut << "\n\nMean Populations\n";
+		fileOut << "\n\t" << cell.getTotEggs() / elapsedDays << "\t" << cell.getTotInst1() / elapsedDays << "\t" << cell.getTotInst2() / elapsedDays << 
+				"\t" << cell.getTotInst3() / elapsedDays << "\t" << cell.getTotPupae() / elapsedDays << "\t" << cell.getTotMales() / elapsedDays << 
+				"\t" << cell.getTotFemales() / elapsedDays;
+	}
+
+	if (statistics & STATS_THRESHOLD_DAYS) { // one line per threshold that was set: the threshold, and the day it was reached (-1 if never)
+		fileOut << "\n\nThreshold Female Population Days\n";
+		for (int i = 0; i < cell.getNumThresholds(); i ++) {
+			if (cell.getThresholdPop(i) < HUGE_VAL)
+				fileOut << "\n\t" << cell.getThresholdPop(i) << "\t" << cell.getThresholdPopDay(i);
+		}
+	}
+
+	if (statistics & STATS_DEGREE_DAYS) {
+		fileOut << "\n\nDegree Days (base " << cell.getDegreeDayBase() << ")\n";
+		fileOut << "\n\t" << cell.getDegreeDays();
+	}
 }
 
 // method to load simulation parameters from a specified file
@@ -287,9 +750,12 @@ errormsg SWDSimulatorMulti::loadParams(std::string configFile) {
 	if (! (status.compare("Success!") == 0) ) // it there was an error, let the user know
 		return status;
 
-	for (int r = 0; r < numThreads; r++){
+	for (int r = 0; r < threadCells.size(); r++){
 		threadCells[r].resetCellParams(params); // apply changes to each cell, reset parameters to those read in (not the fruit parameters)
 	}	
+
+	if (rateTable) // the rates need to be retabulated for the new parameters (with the same range and resolution)
+		useRateTable(rateTable->getResolution(), rateTable->getMinTemp(), rateTable->getMaxTemp());
 	
 	return status;
 }
@@ -299,8 +765,8 @@ void SWDSimulatorMulti::resetTime() {
 	maxCellPopulation = 0;
 	maxCellCoords[0] = 0;
 	maxCellCoords[1] = 0;
-	timeStep = 0;
-	for (int r = 0; r < numThreads; r++){
+	clock.reset();
+	for (int r = 0; r < threadCells.size(); r++){
 		threadCells[r].resetTime(); // reset time for the cell
 	}
 }
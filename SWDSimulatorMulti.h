@@ -2,7 +2,17 @@
 #define SWD_SIMULATOR_MULTI_H
 
 #include "SWDCellMulti.h"
-#include <pthread.h>
+#include "SWDCellBatch.h"
+#include "WorkerPool.h"
+#include "BoundedQueue.h"
+#include "TemperaturePrefetcher.h"
+#include "ClimateCube.h"
+#include "GridMask.h"
+#include "GridOutputFile.h"
+#include "ResultsFile.h"
+#include "TextBuffer.h"
+#include <memory>
+#include <algorithm>
 
 /*
 
@@ -16,24 +26,83 @@
 /*
 	This struct is basically a wrapper for a SWDCellMulti (i.e. one of the grid cells in the 2D grid
 	of cells running in the MultiCell simulation).  This struct exists only to allow the multicell simulation
-	to be threaded.  Since currently there is no intercell interference, any of the cells can be run in parallel.
+	to be threaded.  Since currently there is no intercell interference, any of the cells can be run in parallel
+	(each one as a task of a WorkerPool).
 	The threading code is included in the cpp file, along with explanations of how it works.
 */
 struct RunStruct {
 
 	double numTimeSteps; // timesteps to run the sim for
 	SWDCellMulti cell;
-	double timeStep, dt; // current timestep and integration step respectively
+	StepClock clock; // current day and step, and integration step
 	bool ignoreFruit;
 	bool ignoreDiapause;
 	int startDay; // day to add the flies at
-	std::vector<double> temps; // array of per-day temperature values
+	std::vector<double> temps; // array of per-day temperature values (if read from a text file)
+	TemperatureSeries series; // per-day temperature values used (temps, or the cell's values in the climate cube)
 
 	bool hasNan; 
 	bool injectFlies;
 
-	RunStruct(double numTimeSteps1, SWDCellMulti cell1, double timeStep1, double dt1, bool ignoreFruit1, bool ignoreDiapause1, int startDay1, std::vector<double> newTemps, bool newHasNan) : numTimeSteps(numTimeSteps1), cell(cell1), timeStep(timeStep1), dt(dt1), ignoreFruit(ignoreFruit1), ignoreDiapause(ignoreDiapause1), startDay(startDay1), temps(newTemps), hasNan(newHasNan), injectFlies(false) {}
-	RunStruct() : numTimeSteps(0), cell(SWDCellMulti()), timeStep(0), dt(0), ignoreFruit(true), ignoreDiapause(true), startDay(0), temps(std::vector<double>()), hasNan(false), injectFlies(false) {}
+	// (the cell and temperatures are moved in, so pass them with std::move to avoid copying them)
+	RunStruct(double numTimeSteps1, SWDCellMulti cell1, const StepClock &clock1, bool ignoreFruit1, bool ignoreDiapause1, int startDay1, std::vector<double> newTemps, bool newHasNan) : numTimeSteps(numTimeSteps1), cell(std::move(cell1)), clock(clock1), ignoreFruit(ignoreFruit1), ignoreDiapause(ignoreDiapause1), startDay(startDay1), temps(std::move(newTemps)), series(temps), hasNan(newHasNan), injectFlies(false) {}
+	RunStruct() : numTimeSteps(0), cell(SWDCellMulti()), clock(), ignoreFruit(true), ignoreDiapause(true), startDay(0), temps(std::vector<double>()), hasNan(false), injectFlies(false) {}
+
+	// (series may point into temps, so the struct isn't copied)
+	RunStruct(const RunStruct&) = delete;
+	RunStruct& operator=(const RunStruct&) = delete;
+
+};
+
+
+/*
+	This struct is the equivalent of RunStruct for a batch of cells which are stepped together (see SWDCellBatch),
+	when the simulator is running in batch mode.  There is one thread per batch.
+*/
+struct BatchRunStruct {
+
+	double numTimeSteps; // timesteps to run the sim for
+	std::vector<SWDCellMulti> cells;
+	std::vector<std::vector<double>> temps; // per-day temperature values of each cell (if read from text files)
+	std::vector<TemperatureSeries> series; // per-day temperature values used for each cell (see RunStruct)
+	std::vector<bool> hasNan; // whether each cell has NaN temperatures (these cells aren't simulated)
+	StepClock clock; // current day and step, and integration step
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDay; // day to add the flies at
+
+	BatchRunStruct() : numTimeSteps(0), clock(), ignoreFruit(true), ignoreDiapause(true), startDay(0) {}
+
+};
+
+
+class SWDSimulatorMulti;
+
+/*
+	This struct holds the arguments of a run of the simulator which are shared by all the tasks of the worker pool
+	and the writer threads, and the slots the tasks leave their finished cells (or batches, in batch mode) in, until 
+	they are printed.  The tasks push the numbers of the finished cells (or batches) to the queue for the writers.
+*/
+struct RunSettings {
+
+	const SWDSimulatorMulti *sim;
+	int numTimeSteps; // timesteps to run the sim for
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDay; // day to add the flies at
+	const std::vector<std::vector<std::string>> &tempsFiles; // temperature file of each cell
+	const std::vector<std::vector<std::string>> &fileNames; // data and summary files of each cell
+	const std::vector<std::vector<std::string>> &summaryFiles;
+
+	std::vector<std::unique_ptr<RunStruct>> cellRuns; // finished run of each active cell (null until it finishes, and after it is printed)
+	std::vector<std::unique_ptr<BatchRunStruct>> batchRuns; // same as above, for each batch in batch mode
+	BoundedQueue<int> finished; // cells (or batches) finished but not printed yet (-1 tells a writer to stop)
+	std::vector<double> maxFemales; // peak female population of each cell (to find the cell with the max population)
+	TemperaturePrefetcher *prefetcher; // reads the temperatures of the cells ahead of the tasks
+	GridOutputWriter *gridOutput; // grid output file the cells are printed to (null to print the per-cell files)
+	ResultsWriter *results; // binary results file the data series are written to (null to print them as text)
+
+	RunSettings(const SWDSimulatorMulti *sim1, int numTimeSteps1, bool ignoreFruit1, bool ignoreDiapause1, int startDay1, const std::vector<std::vector<std::string>> &tempsFiles1, const std::vector<std::vector<std::string>> &fileNames1, const std::vector<std::vector<std::string>> &summaryFiles1, int queueSize) : sim(sim1), numTimeSteps(numTimeSteps1), ignoreFruit(ignoreFruit1), ignoreDiapause(ignoreDiapause1), startDay(startDay1), tempsFiles(tempsFiles1), fileNames(fileNames1), summaryFiles(summaryFiles1), finished(queueSize), prefetcher(NULL), gridOutput(NULL), results(NULL) {}
 
 };
 
@@ -50,34 +119,123 @@ struct RunStruct {
 */
 class SWDSimulatorMulti {
 
-	std::vector<SWDCellMulti> threadCells; // list of all the cells in the simulation (it is a 2D grid, but represented as a 1D array)
+	std::vector<SWDCellMulti> threadCells; // cell with the parameters of the grid (which is copied to set up each cell of the grid when it is run)
 	int numRows, numCols; // total rows and cols in the grid of cells
 	std::vector<std::vector<double>> latitudes; // 2d array of lat/lon pairs for the cells
+	GridMask mask; // which cells are simulated (every cell by default); the tasks are numbered over the active cells only
 
 	// pop and location of cell with max population
 	double maxCellPopulation;
 	int maxCellCoords[2];
 
-	double timeStep, dt;
-
-	int numThreads; // number of threads available to run concurrently (i.e. how many cells can run simultaneously)
+	StepClock clock; // current day of the simulation (over all cells), and integration step
+
+	int numThreads; // number of worker threads to run the cells with (i.e. how many cells can run simultaneously)
+	int batchSize; // cells stepped together by each thread in batch mode (0 to step the cells one at a time); batch mode only
+	               // vectorizes Euler's method, so it is ignored with the exponential and Runge-Kutta integrators
+	bool summaryOnly; // whether only the summary files are printed (the data series aren't recorded)
+	RecorderMode recorderMode; // steps recorded by the cells, as set by setRecorder (restored when summary-only mode is turned off)
+	int recorderEveryDays;
+
+	void runBatched(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, const std::vector<std::vector<std::string>> &fileNames, const std::vector<std::vector<std::string>> &summaryFiles, const std::vector<std::vector<std::string>> &tempsFiles);
+	void printCell(const SWDCellMulti &cell, int i, RunSettings &settings, TextBuffer &data, TextBuffer &summary) const;
+	void printPlaceholders(RunSettings &settings) const;
+	void writeCellData(const SWDCellMulti &cell, TextBuffer &fileOut) const;
+	void writeSummary(const SWDCellMulti &cell, TextBuffer &fileOut) const;
+	void writeResults(const SWDCellMulti &cell, int i, RunSettings &settings) const;
+
+	// output stage: writer threads print the cells as the workers finish them (see runTasks)
+	int numWriters; // number of writer threads
+	int outputQueueSize; // finished cells (or batches) that can wait to be printed before the workers are held back (0 for 2 per worker)
+	std::string gridOutputFile; // grid output file to print all the cells to (empty to print the per-cell files, see useGridOutput)
+	std::string resultsFile; // binary results file to write the data series to (empty to print them as text, see useResultsFile)
+	bool resultsSinglePrecision;
+	int resultsChunkDays;
+	void runTasks(RunSettings &settings, int numTasks, TaskFunction task);
+
+	// input stage: reader threads read the temperature files ahead of the workers (see TemperaturePrefetcher)
+	int prefetchDepth; // cells read ahead (0 for 2 per worker)
+	int numReaders; // number of reader threads (0 to read the files in the workers)
+	double inputWaitTime; // time the workers waited for temperatures in the last run, in seconds
+	int numPrefetchMisses; // cells the workers had to read themselves in the last run
+	static void* writerThread(void *threadarg);
+
+	// tasks run by the worker pool (the arg is the RunSettings of the run)
+	static void runCellTask(int task, void *arg);
+	static void runBatchTask(int task, void *arg);
+
+	// optional lookup table for the temperature-dependent rates, shared read-only by all the cells
+	// (null if the analytic functions are used)
+	std::shared_ptr<const RateTable> rateTable;
+	void applyRateTable();
+
+	// daylight hours tables, one per distinct latitude of the grid (shared by all the cells at that latitude)
+	PhotoperiodTables photoperiods;
+	double getCellLatitude(int r, int c) const;
+
+	// optional memory-mapped temperatures of the whole grid, used instead of the temperature files (null if the files are used)
+	std::shared_ptr<const ClimateCube> climateCube;
+	bool getCellTemperatures(RunSettings &settings, int cell, std::vector<double> &temps, TemperatureSeries &series) const;
+	void buildPhotoperiodTables();
+	void setCellLatitude(SWDCellMulti &cell, int r, int c) const;
 
 public:
 
 	// methods explained in the implementation file
 	SWDSimulatorMulti(std::string paramFile, int rows, int cols, std::vector<std::vector<double>> latitudes1 = std::vector<std::vector<double>>());
 	void setDefaultParams();
-	void run(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, std::vector<std::vector<std::string>> fileNames, std::vector<std::vector<std::string>> summaryFiles, std::vector<std::vector<std::string>> tempsFiles = std::vector<std::vector<std::string>>());
+	void run(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay, const std::vector<std::vector<std::string>> &fileNames, const std::vector<std::vector<std::string>> &summaryFiles, const std::vector<std::vector<std::string>> &tempsFiles = std::vector<std::vector<std::string>>());
 	void run(int numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay);
 
-	void printCellInfo(int i, std::string dataFile, std::string summaryFile);
+	void printCellInfo(int i, std::string dataFile, std::string summaryFile) const;
+	void printCellInfo(const SWDCellMulti &cell, std::string dataFile, std::string summaryFile) const;
+	void printSummary(const SWDCellMulti &cell, std::string summaryFile) const;
 
 	errormsg loadParams(std::string configFile);
 
+	RateTableError useRateTable(double resolution, double minTemp = -40, double maxTemp = 50);
+	void useAnalyticRates();
+
 	// accessors 
 	int getNumRows() const { return numRows; }
 	int getNumCols() const { return numCols; }
-	double getTimeStep() const { return timeStep; }
+	int getNumPhotoperiodTables() const { return photoperiods.getNumTables(); }
+	double getTimeStep() const { return clock.getTime(); }
+	void setBatchSize(int size) { batchSize = size > 0 ? size : 0; } // (ignored unless the integrator is EULER_INTEGRATOR, see SWDCellBatch)
+	int getBatchSize() const { return batchSize; }
+	void setNumThreads(int numThreadsNew);
+	int getNumThreads() const { return numThreads; }
+	void setNumWriters(int numWritersNew) { numWriters = numWritersNew > 0 ? numWritersNew : 1; }
+	int getNumWriters() const { return numWriters; }
+	void setOutputQueueSize(int size) { outputQueueSize = size > 0 ? size : 0; }
+	void setPrefetch(int depth, int readers = 1);
+	errormsg useClimateCube(std::string cubeFile);
+	void useTemperatureFiles() { climateCube.reset(); }
+	bool hasClimateCube() const { return (bool) climateCube; }
+	errormsg useMask(std::string maskFile);
+	errormsg useClimateCubeMask();
+	void clearMask() { mask.setAll(numRows, numCols); }
+	const GridMask& getMask() const { return mask; }
+	void useGridOutput(std::string fileName);
+	void useCellOutputFiles() { gridOutputFile = ""; }
+	std::string getGridOutput() const { return gridOutputFile; }
+	void useResultsFile(std::string fileName, bool singlePrecision = false, int chunkDays = 365);
+	void useTextResults() { resultsFile = ""; }
+	std::string getResultsFile() const { return resultsFile; }
+	int getNumActiveCells() const { return mask.getNumActive(); }
+	double getInputWaitTime() const { return inputWaitTime; }
+	int getNumPrefetchMisses() const { return numPrefetchMisses; }
+	double getDT() const { return clock.dt; }
+	int getStepsPerDay() const { return clock.stepsPerDay; }
+	void setIntegrator(IntegratorMode integrator);
+	IntegratorMode getIntegrator() const { return threadCells[0].getIntegrator(); }
+	void setTolerances(double absTolerance, double relTolerance);
+	void setRecorder(RecorderMode mode, int everyDays = 1);
+	void setSummaryOnly(bool on);
+	bool getSummaryOnly() const { return summaryOnly; }
+	RecorderMode getRecorderMode() const { return recorderMode; } // (set by setRecorder, even in summary-only mode)
+	void setStatistics(int flags, double degreeDayBase = 10);
+	void setThresholdPop(int index, double population);
 
 	void resetTime();
 	
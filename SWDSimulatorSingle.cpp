@@ -12,12 +12,12 @@
 // first, set the params to default params (that's what cell(Parameters()) does), 
 // and then try reading from the file
 // for any params missing from the file the default value is used
-SWDSimulatorSingle::SWDSimulatorSingle(double dtNew, std::string fileName) : dt(dtNew), cell(Parameters()), injectFlies(false) {
+SWDSimulatorSingle::SWDSimulatorSingle(double dtNew, std::string fileName) : cell(Parameters()), clock(dtNew), injectFlies(false), summaryOnly(false), recorderMode(RECORD_EVERY_STEP), recorderEveryDays(1) {
 	setConfigParams(fileName); // try to read from config.txt if it exists
 }
 
 // constructor taking a parameters object containing the params for the simulation
-SWDSimulatorSingle::SWDSimulatorSingle(double dtNew, Parameters &params) : dt(dtNew), cell(params) , injectFlies(false) { }
+SWDSimulatorSingle::SWDSimulatorSingle(double dtNew, Parameters &params) : cell(params), clock(dtNew), injectFlies(false), summaryOnly(false), recorderMode(RECORD_EVERY_STEP), recorderEveryDays(1) { }
 
 // method to reset the simulation parameters to the default
 void SWDSimulatorSingle::setDefaultParams() {
@@ -25,6 +25,31 @@ void SWDSimulatorSingle::setDefaultParams() {
 	cell.resetCellParams(params, true); // reset the fruit parameters
 }
 
+// method to choose the integration method of the simulation (see IntegratorMode)
+// the integration step is also set to the usual step for the method (see getDefaultDT), and setDT can
+// still be used to change it after
+void SWDSimulatorSingle::setIntegrator(IntegratorMode integrator) {
+	cell.setIntegrator(integrator);
+	clock.setDT(getDefaultDT(integrator));
+}
+
+// method to choose which steps of the cell are kept in its data series (see RecorderMode)
+// in summary-only mode nothing is recorded, and the mode is only used once summary-only mode is turned off
+void SWDSimulatorSingle::setRecorder(RecorderMode mode, int everyDays) {
+	recorderMode = mode;
+	recorderEveryDays = everyDays;
+	cell.setRecorder(summaryOnly ? RECORD_NONE : mode, everyDays);
+}
+
+// method to choose whether only the summary of the run is kept (as in SWDSimulatorMulti::setSummaryOnly)
+// in summary-only mode the data series aren't recorded at all (RECORD_NONE), so the cell only holds its running
+// totals/peaks/statistics, no matter how long the run is
+// turning it off goes back to the recorder mode set by setRecorder (every step by default)
+void SWDSimulatorSingle::setSummaryOnly(bool on) {
+	summaryOnly = on;
+	setRecorder(recorderMode, recorderEveryDays);
+}
+
 // method to set the value of a single specified parameter to the specified value
 // returns "Success!" if all goes well, or a descriptive error message if not
 errormsg SWDSimulatorSingle::setSingleParameter(std::string &param, double newVal) {
@@ -74,43 +99,56 @@ void SWDSimulatorSingle::run(double temperature, double numTimeSteps, bool ignor
 	cell.setAddInitPop(true);
 	cell.readInitFlies();
 	
-	for (double i = 0; round2Decimals(i) < numTimeSteps; i += dt) { // run from time = 0 to the specified number of timesteps
-		cell.stepForward(temperature, ignoreFruit, ignoreDiapause, dt, timeStep); // run the cell with specified temperature!
-		timeStep += dt;
+	SWDCellSingle::StepFunction stepForward = cell.getStepFunction(ignoreFruit, ignoreDiapause); // kernel for the submodel switches
+	long numSteps = clock.getNumSteps(numTimeSteps);
+	cell.reserveSteps(numSteps, clock.stepsPerDay); // so the steps don't allocate memory
+	long allocations = getAllocationCount();
+	
+	for (long k = 0; k < numSteps; k ++) { // run from the current time for the specified number of timesteps
+		(cell.*stepForward)(temperature, clock); // run the cell with specified temperature!
+		clock.advance();
 	}
+	
+	assert(getAllocationCount() == allocations); // (only counted when compiled with -DSWD_ALLOC_CHECK, see AllocationCounter.h)
 }
 
 // method to run the simulation for a specified number of timesteps, with the daily temperatures specified
 // as an array (the temperatures vector).
 // whether or not to ignore diapause/fruit submodel bools are also passed in as arguments,
 // and the day to add the flies at (startDay)
-void SWDSimulatorSingle::run(std::vector<double> temperatures, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay) { 
+void SWDSimulatorSingle::run(const std::vector<double> &temperatures, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay) { 
 	
 	if (numTimeSteps < 0)
 		return; // no negative time!
 	
-	int index = ((int) timeStep) % temperatures.size(); // current timestep of the cell, to match with the corresponding temperature value in the list
+	if (temperatures.size() == 0)
+		return; // no temperatures to run with
 	
 	if (startDay >= 0)
 		cell.setAddInitPop(true); // if valid startday, set variable to ensure that init pop isn't added before injection date, regardless of diapause
 	
-	for (double i = 0; round2Decimals(i) < numTimeSteps; i += dt) {
-		if ((int) index >= temperatures.size()) // if there is not enough temperature data, it reloops to the beginning
-			index = 0;
-		if ((int) timeStep == startDay && !injectFlies) {
+	SWDCellSingle::StepFunction stepForward = cell.getStepFunction(ignoreFruit, ignoreDiapause); // kernel for the submodel switches
+	long numSteps = clock.getNumSteps(numTimeSteps);
+	cell.reserveSteps(numSteps, clock.stepsPerDay); // so the steps don't allocate memory
+	long allocations = getAllocationCount();
+	
+	for (long k = 0; k < numSteps; k ++) {
+		if (clock.day == startDay && !injectFlies) {
 			injectFlies = true;
 			cell.readInitFlies(); // read in initial populations on the chosen date
 		}
-		cell.stepForward(temperatures[(int) index], ignoreFruit, ignoreDiapause, dt, timeStep); // assume temperature given daily
+		// assume temperature given daily (if there is not enough temperature data, it reloops to the beginning)
+		(cell.*stepForward)(temperatures[clock.day % temperatures.size()], clock);
 
-		timeStep += dt;
-		index = ((int) timeStep) % temperatures.size();
+		clock.advance();
 	}
+	
+	assert(getAllocationCount() == allocations); // (only counted when compiled with -DSWD_ALLOC_CHECK, see AllocationCounter.h)
 }
 
 // method to reset the simulation to timestep 0
 void SWDSimulatorSingle::resetTime() {
-	timeStep = 0;
+	clock.reset();
 	cell.resetTime(); // reset the cell to timestep 0
 	injectFlies = false;
 }
@@ -2,6 +2,8 @@
 #define SWD_SIMULATOR_SINGLE_H
 
 #include "SWDCellSingle.h"
+#include "AllocationCounter.h"
+#include <cassert>
 
 /*
 
@@ -20,14 +22,17 @@
 class SWDSimulatorSingle {
 	SWDCellSingle cell; // cell to run the simulation on
 	
-	double timeStep; // current timestep
-	double dt; // integration step (defaults to 0.05)
+	StepClock clock; // current day and step of the simulation, and the integration step dt (defaults to 0.05)
 	
 	bool injectFlies;
 
+	bool summaryOnly; // whether the data series are recorded (only the running totals/peaks/statistics are kept otherwise)
+	RecorderMode recorderMode; // steps recorded by the cell, as set by setRecorder (restored when summary-only mode is turned off)
+	int recorderEveryDays;
+
 public:
 	// constructors
-	SWDSimulatorSingle(double dtNew = 0.05, std::string fileName = "config.txt");
+	SWDSimulatorSingle(double dtNew = getDefaultDT(EULER_INTEGRATOR), std::string fileName = "config.txt");
 	SWDSimulatorSingle(double dtNew, Parameters &params);
 
 	// these methods are described in the cpp file
@@ -39,10 +44,23 @@ public:
 
 	// methods to run a sim - also explained in the cpp file
 	void run(double temperature, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause);
-	void run(std::vector<double> temperatures, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay);
+	void run(const std::vector<double> &temperatures, double numTimeSteps, bool ignoreFruit, bool ignoreDiapause, int startDay);
 
 	// self-explanatory accessors and mutators, similar to those in the SWDCellSingle class
-	void setDT(double dtNew) { dt = dtNew; }
+	void setDT(double dtNew) { clock.setDT(dtNew); } // (rounded so the steps divide a day evenly, see StepClock)
+	double getDT() const { return clock.dt; }
+	int getStepsPerDay() const { return clock.stepsPerDay; }
+	void setIntegrator(IntegratorMode integrator);
+	IntegratorMode getIntegrator() const { return cell.getIntegrator(); }
+	void setTolerances(double absTolerance, double relTolerance) { cell.setTolerances(absTolerance, relTolerance); } // for the Runge-Kutta integrator
+	void setRecorder(RecorderMode mode, int everyDays = 1);
+	RecorderMode getRecorderMode() const { return recorderMode; } // (set by setRecorder, even in summary-only mode)
+	void setSummaryOnly(bool on);
+	bool getSummaryOnly() const { return summaryOnly; }
+	void setStatistics(int flags, double degreeDayBase = 10) { cell.setStatistics(flags, degreeDayBase); } // extra statistics (see StatisticsFlags)
+	void setThresholdPop(int index, double population) { cell.setThresholdPop(index, population); }
+	double getDegreeDays() const { return cell.getDegreeDays(); }
+	double getElapsedDays() const { return cell.getElapsedDays(); }
 	Parameters getParams() const { return cell.getParams(); }
 	double getFruitQuality() const { return cell.getFruitQuality(); }
 	double getDayCrossedMaxFruit() const { return cell.getDayCrossedMaxFruit(); }
@@ -83,7 +101,8 @@ public:
 	double getTotEggs() const { return cell.getTotEggs(); }
 
 	double getTemperature() const { return cell.getTemperature(); }
-	double getTimeStep() const { return timeStep; }
+	double getTimeStep() const { return clock.getTime(); }
+	const StepClock& getClock() const { return clock; }
 	void resetTime();
 	int getCrossedDiapDay() const { return cell.getCrossedDiapDay(); }
 
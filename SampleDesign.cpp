@@ -0,0 +1,105 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "SampleDesign.h"
+#include <algorithm>
+
+/*
+
+	Implementation of the SobolSequence and LatinHypercube classes.  The class definitions and descriptions
+	are included in the SampleDesign header file.
+
+*/
+
+// direction numbers of dimensions 2 .. MAX_DIMS of the Sobol sequence (from new-joe-kuo-6.21201, by Joe and Kuo):
+// the degree s of the primitive polynomial, its coefficients a, and the initial direction numbers m1 .. ms
+// (the first dimension has all its m equal to 1)
+static const int SOBOL_TABLE[][10] = {
+	{1, 0, 1},
+	{2, 1, 1, 3},
+	{3, 1, 1, 3, 1},
+	{3, 2, 1, 1, 1},
+	{4, 1, 1, 1, 3, 3},
+	{4, 4, 1, 3, 5, 13},
+	{5, 2, 1, 1, 5, 5, 17},
+	{5, 4, 1, 1, 5, 5, 5},
+	{5, 7, 1, 1, 7, 11, 19},
+	{5, 11, 1, 1, 5, 1, 1},
+	{5, 13, 1, 1, 1, 3, 11},
+	{5, 14, 1, 3, 5, 5, 31},
+	{6, 1, 1, 3, 3, 9, 7, 49},
+	{6, 13, 1, 1, 1, 15, 21, 21},
+	{6, 16, 1, 3, 1, 13, 27, 49},
+	{6, 19, 1, 1, 1, 15, 7, 5},
+	{6, 22, 1, 3, 1, 15, 13, 25},
+	{6, 25, 1, 1, 5, 5, 19, 61},
+	{7, 1, 1, 3, 7, 11, 23, 15, 103},
+	{7, 4, 1, 3, 7, 13, 13, 15, 69}
+};
+
+// constructor for the Sobol sequence in numDimsNew dimensions (at most MAX_DIMS)
+// the direction numbers of each dimension are found from the initial direction numbers with the recurrence of its polynomial
+SobolSequence::SobolSequence(int numDimsNew) : numDims(std::min(std::max(numDimsNew, 1), MAX_DIMS)), directions(32 * numDims), current(numDims, 0), index(0) {
+	for (int b = 0; b < 32; b ++)
+		directions[b] = 1u << (31 - b); // (the first dimension)
+
+	for (int d = 1; d < numDims; d ++) {
+		uint32_t *v = &directions[32 * d];
+		int s = SOBOL_TABLE[d - 1][0];
+		int a = SOBOL_TABLE[d - 1][1];
+		for (int b = 0; b < s; b ++)
+			v[b] = (uint32_t) SOBOL_TABLE[d - 1][2 + b] << (31 - b);
+		for (int b = s; b < 32; b ++) {
+			v[b] = v[b - s] ^ (v[b - s] >> s);
+			for (int k = 1; k < s; k ++) {
+				if ((a >> (s - 1 - k)) & 1)
+					v[b] ^= v[b - k];
+			}
+		}
+	}
+}
+
+// method to get the next numPoints points of the sequence (points is resized to numPoints points of numDims values)
+void SobolSequence::nextPoints(int numPoints, std::vector<std::vector<double>> &points) {
+	points.resize(numPoints);
+	for (int j = 0; j < numPoints; j ++) {
+		// point index + 1 differs from point index in the direction number of the lowest zero bit of index (Gray code)
+		int bit = 0;
+		while ((index >> bit) & 1)
+			bit ++;
+		index ++;
+
+		points[j].resize(numDims);
+		for (int d = 0; d < numDims; d ++) {
+			current[d] ^= directions[32 * d + bit];
+			points[j][d] = current[d] / 4294967296.0;
+		}
+	}
+}
+
+// constructor for Latin hypercube samples in numDimsNew dimensions, with the random numbers generated from seed
+// (so the same seed gives the same design)
+LatinHypercube::LatinHypercube(int numDimsNew, uint64_t seed) : numDims(numDimsNew), generator(seed) {}
+
+// method to get the next block of numPoints points (points is resized to numPoints points of numDims values)
+// the block is a Latin hypercube: in each dimension, the strata are shuffled across the points, and each point is
+// placed at random within its stratum
+void LatinHypercube::nextPoints(int numPoints, std::vector<std::vector<double>> &points) {
+	points.resize(numPoints);
+	for (int j = 0; j < numPoints; j ++)
+		points[j].resize(numDims);
+
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::vector<int> strata(numPoints);
+	for (int d = 0; d < numDims; d ++) {
+		for (int j = 0; j < numPoints; j ++)
+			strata[j] = j;
+		std::shuffle(strata.begin(), strata.end(), generator);
+		for (int j = 0; j < numPoints; j ++)
+			points[j][d] = (strata[j] + uniform(generator)) / numPoints;
+	}
+}
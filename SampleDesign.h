@@ -0,0 +1,80 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef SAMPLE_DESIGN_H
+#define SAMPLE_DESIGN_H
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/*
+
+	Header file for SampleDesign.cpp.  Contains the SobolSequence and LatinHypercube class definitions,
+	described below, which generate the sample points of a sensitivity analysis (see SWDSensitivity).
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+	Both generate points in the unit cube [0, 1)^numDims, a block of points at a time, so a design of any
+	size can be generated without holding all of it.
+
+*/
+
+/*
+	Sample design used to generate the points of a sensitivity analysis.
+	LATIN_HYPERCUBE_DESIGN is random Latin hypercube sampling (see LatinHypercube).
+	SOBOL_DESIGN is the Sobol low discrepancy sequence (see SobolSequence).
+*/
+enum SampleDesign { LATIN_HYPERCUBE_DESIGN, SOBOL_DESIGN };
+
+/*
+	This class describes a SobolSequence object, which generates the points of the Sobol sequence in up to
+	MAX_DIMS dimensions (with the direction numbers of Joe and Kuo, 2008), one after the other, with the
+	Gray code construction of Antonov and Saleev (so each point is one xor per dimension).
+	The first point (all zeros) is skipped, as usual.
+*/
+class SobolSequence {
+
+	int numDims;
+	std::vector<uint32_t> directions; // 32 direction numbers of each dimension
+	std::vector<uint32_t> current; // current point of each dimension (as a 32 bit fraction)
+	uint32_t index; // number of the current point
+
+public:
+
+	static const int MAX_DIMS = 21;
+
+	SobolSequence(int numDimsNew);
+
+	void nextPoints(int numPoints, std::vector<std::vector<double>> &points);
+
+	int getNumDims() const { return numDims; }
+
+};
+
+/*
+	This class describes a LatinHypercube object, which generates random Latin hypercube samples: in a block
+	of n points, each dimension is split into n equal strata, and each stratum has exactly one point.  To keep
+	the memory bounded, a large design is generated as a series of blocks, each of which is a Latin hypercube.
+*/
+class LatinHypercube {
+
+	int numDims;
+	std::mt19937_64 generator;
+
+public:
+
+	LatinHypercube(int numDimsNew, uint64_t seed);
+
+	void nextPoints(int numPoints, std::vector<std::vector<double>> &points);
+
+	int getNumDims() const { return numDims; }
+
+};
+
+#endif
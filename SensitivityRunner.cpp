@@ -0,0 +1,126 @@
+#include "SWDSensitivity.h"
+#include "TemperatureFile.h"
+
+/*
+
+	This file is a runner for a Sobol sensitivity analysis of the singlecell simulator (see SWDSensitivity.h).
+	It takes in command line arguments to run the analysis.
+	Run the analysis as follows:
+
+	First, compile the model.  Call it using:
+
+	./sensitivitySim useDefault paramFileName tempFileName rangesFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop numSamples design outputs [numThreads] [samplesFileName]
+
+	useDefault = [0|1] 1 to start from the default parameters, 0 to read them from paramFileName
+	paramFileName = the extended parameters list for the parameters not varied.  Usually configparams.txt
+	tempFileName = a file with 365 single line entries of temperatures (read once, for all the runs)
+	rangesFileName = the parameters to vary, one per line as "name: min max" (i.e. "eggs mortality max: 0.5 0.9")
+	ignoreFruit = [0|1] 0, use the fruit model, 1 ignore the fruit model
+	ignoreDiapause = [0|1] 0, use the diapause model, 1 ignore the diapause model
+	outputFileName = destination CSV file for the first and total order indices of each output and parameter
+	addFliesDate = 0-364 for fly introduction date, -1 to use diapause termination date
+	startingFemPop = number of initial fecund females (> 0), unless "initial females1" is varied
+	numSamples = number of base samples (there are numSamples (number of parameters + 2) runs)
+	design = lhs for Latin hypercube samples, or sobol for the Sobol sequence (up to 10 parameters)
+	outputs = comma separated outputs to analyse, i.e. peakFemales,peakDayFemales,totalFemales (see
+	          SWDEnsemble::getSummaryNames for all of them)
+	numThreads = (optional) number of runs at once, 0 for one per hardware thread (the default)
+	samplesFileName = (optional) CSV file to write every run to (its parameters and outputs)
+
+	To skip parsing the temperature file on repeated runs, set the environment variable SWD_TEMPERATURE_CACHE to
+	a directory to cache the parsed temperatures in (see TemperatureFile.h).
+
+*/
+
+// main method to run the code; this takes in the cmd line arguments
+int main(int argc, char *argv[]) {
+
+	if ( argc < 13 || argc > 15)
+	{
+		printf( "Error, exiting now\nUsage: ./sensitivitySim useDefault paramFileName tempFileName rangesFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop numSamples [lhs|sobol] outputs [numThreads] [samplesFileName]");
+		printf( "\n\nNote that: useDefault, ignoreFruit, ignoreDiapause are bools (0 = false)\nNote also that: addFliesDate as -1 specifies to add the flies on diapause cross date.\n");
+		exit( 0);
+	}
+
+	// read in all the arguments
+	std::stringstream sstm;
+	sstm << argv[1] << " " << argv[5] << " " << argv[ 6] << " " << argv[ 8] << " " << argv[ 9] << " " << argv[ 10]; // need all the numbers saved here
+
+	int runTime = 360; // run simulation for a year
+
+	std::string inputFileName = argv[ 2];
+	std::string tempFileName = argv[ 3];
+	std::string rangesFileName = argv[ 4];
+	std::string outputFileName = argv[ 7];
+	std::string design = argv[ 11];
+	std::string outputs = argv[ 12];
+
+	bool useDefault;
+	bool ignoreFruit;
+	bool ignoreDiapause;
+	int startDate;
+	double startFemPop;
+	long numSamples;
+
+	sstm >> useDefault;
+	sstm >> ignoreFruit;
+	sstm >> ignoreDiapause;
+	sstm >> startDate;
+	sstm >> startFemPop;
+	sstm >> numSamples;
+
+	int numThreads = ( argc >= 14) ? atoi( argv[ 13]) : 0;
+	std::string samplesFileName = ( argc == 15) ? argv[ 14] : "";
+
+	// read the parameters not varied (once)
+	Parameters params;
+	if ( useDefault == 0)
+		params.setConfigParams( inputFileName);
+	params.setParameter( "initial females1", startFemPop);
+
+	// read temperatures in from file (through the parsed temperatures cache, if SWD_TEMPERATURE_CACHE is set)
+	const char* cacheDirectory = getenv( "SWD_TEMPERATURE_CACHE");
+	if ( cacheDirectory != NULL)
+		setTemperatureCache( cacheDirectory);
+
+	std::vector< double> temperatures;
+	readTemperatureFile( tempFileName, temperatures);
+	if ( temperatures.size() == 0)
+	{
+		printf( "Error: could not read the temperature file %s\n", tempFileName.c_str());
+		exit( 1);
+	}
+
+	// set up the analysis
+	SWDSensitivity analysis( params, temperatures);
+
+	std::vector< std::string> outputNames;
+	std::stringstream outputsIn( outputs);
+	std::string output;
+	while ( std::getline( outputsIn, output, ','))
+		outputNames.push_back( output);
+
+	errormsg status = analysis.loadRanges( rangesFileName);
+	if ( status.compare( "Success!") == 0)
+		status = analysis.setOutputs( outputNames);
+	if ( status.compare( "Success!") != 0)
+	{
+		printf( "%s\n", status.c_str());
+		exit( 1);
+	}
+
+	analysis.setDesign( design == "sobol" ? SOBOL_DESIGN : LATIN_HYPERCUBE_DESIGN);
+	analysis.setNumThreads( numThreads);
+
+	// run it, and print the indices to the output file
+	status = analysis.run( numSamples, runTime, ignoreFruit, ignoreDiapause, startDate, samplesFileName);
+	if ( status.compare( "Success!") == 0)
+		status = analysis.printIndices( outputFileName);
+	if ( status.compare( "Success!") != 0)
+	{
+		printf( "%s\n", status.c_str());
+		exit( 1);
+	}
+
+	return 0;
+}
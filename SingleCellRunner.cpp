@@ -1,5 +1,6 @@
 #include "SWDSimulatorSingle.h"
 #include "SWDSimulatorMulti.h"
+#include "TemperatureFile.h"
 
 /*
 
@@ -9,7 +10,7 @@
 
 	First, compile the model.  Call it using:
 
-	./singleSim useDefault paramFileName tempFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop
+	./singleSim useDefault paramFileName tempFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop [integrator] [summary]
 
 	useDefault = 
 	paramFileName = the extended parameters list to run the simulation with.  Usually configparams.txt
@@ -19,6 +20,14 @@
 	outputFileName = destination file for results
 	addFliesDate = 0-364 for fly introduction date, -1 to use diapause termination date
 	startingFemPop = number of initial fecund females (> 0)
+	integrator = (optional) euler (default) for Euler's method with dt = 0.05, exponential to solve
+	             each day exactly in one step, or rk45 for the adaptive Runge-Kutta method
+	             (see IntegratorMode in SWDCellSingle.h)
+	summary = (optional) "summary" to only print the summary of the run (see below): the data series aren't
+	          recorded at all, and the mean populations and the degree days are added to the summary
+
+	To skip parsing the temperature file on repeated runs, set the environment variable SWD_TEMPERATURE_CACHE to
+	a directory to cache the parsed temperatures in (see TemperatureFile.h).
 
 	Note that: useDefault, ignoreFruit, ignoreDiapause are bools (0 = false)
 	Note also that: addFliesDate as -1 specifies to add the flies on diapause cross date.
@@ -34,38 +43,37 @@
 		-- day of max fruit
 		-- day of diapause crossed
 		-- peak population date for each stage
+	In summary mode, the daily populations and fruit quality are left out, and the day diapause was crossed and
+	the day of max fruit quality are taken from the cell instead (as in the summary files of multiSim summary).
 
 */
 
-void printCellInfo( std::string outputFile, SWDCellSingle cell) {
-	std::string names[] = {"eggs", "instar1", "instar2", "instar3", "pupae", "males", "females", "fruit"};
-		
-	XYSeries toPrint[8]; // array of data series for all lifestages, and fruit quality, vs time
+void printCellInfo( std::string outputFile, const SWDCellSingle &cell, int pointsPerDay) {
+	const XYSeries* toPrint[8]; // array of the cell's data series for all lifestages, and fruit quality, vs time (not copied)
 	
-	toPrint[0] = cell.getEggSeries();
-	toPrint[1] = cell.getInst1Series();
-	toPrint[2] = cell.getInst2Series();
-	toPrint[3] = cell.getInst3Series();
-	toPrint[4] = cell.getPupaeSeries();
-	toPrint[5] = cell.getMalesSeries();
-	toPrint[6] = cell.getFemalesSeries();
-	toPrint[7] = cell.getFruitQualitySeries();
+	toPrint[0] = &cell.getEggSeries();
+	toPrint[1] = &cell.getInst1Series();
+	toPrint[2] = &cell.getInst2Series();
+	toPrint[3] = &cell.getInst3Series();
+	toPrint[4] = &cell.getPupaeSeries();
+	toPrint[5] = &cell.getMalesSeries();
+	toPrint[6] = &cell.getFemalesSeries();
+	toPrint[7] = &cell.getFruitQualitySeries();
 	
-	std::ofstream fileOut;
-	fileOut.open(outputFile);
+	TextBuffer fileOut; // (the whole file is formatted in memory, and written in one go at the end)
 	fileOut << "Time:" << "\t";
 	
 	// all the series have the same number of data points
 	
 	// print daily data
-	for (int jk = 0; jk < 8; jk ++) { // print data labels
-			fileOut << names[jk] << ":\t";
+	for (int jk = 0; jk < 8; jk ++) { // print data labels (the lifestages, then fruit quality)
+			fileOut << ((jk < NUM_LIFESTAGES) ? STAGE_NAMES[jk] : "fruit") << ":\t";
 	}
 	fileOut << "\n";
-	for (int ik = 0; ik < toPrint[0].size(); ik +=20) { // += 20 so it prints every 20th datapoint (i.e. once per day)
-	 	fileOut << toPrint[0][ik].getX() << "\t"; // print the timestep (same for all series)
+	for (int ik = 0; ik < toPrint[0]->size(); ik += pointsPerDay) { // so it prints every 20th datapoint with dt = 0.05 (i.e. once per day)
+	 	fileOut << (*toPrint[0])[ik].getX() << "\t"; // print the timestep (same for all series)
 	 	for (int jk = 0; jk < 8; jk ++) {
-	 			fileOut << toPrint[jk][ik].getY() << "\t";
+	 			fileOut << (*toPrint[jk])[ik].getY() << "\t";
 	
 	 	}
 	 	fileOut << "\n";
@@ -78,9 +86,9 @@ void printCellInfo( std::string outputFile, SWDCellSingle cell) {
 
 	// first, get diap term date
 	double diapi = 0;
-	for ( int i = 0; i < 365*20; i += 20) {
-		if ( toPrint[6][i].getY() > 0) {
-			diapi = i/20.0;
+	for ( int i = 0; i < 365*pointsPerDay && i < toPrint[6]->size(); i += pointsPerDay) {
+		if ( (*toPrint[6])[i].getY() > 0) {
+			diapi = i/(double)pointsPerDay;
 			break;
 		}
 	}
@@ -88,9 +96,9 @@ void printCellInfo( std::string outputFile, SWDCellSingle cell) {
 
 	// then, get fruit max date
 	double diapf = 0;
-	for ( int i = 0; i < 365*20; i += 20) {
-		if ( toPrint[7][i].getY() >= 0.95 ) {
-			diapf = i/20.0;
+	for ( int i = 0; i < 365*pointsPerDay && i < toPrint[7]->size(); i += pointsPerDay) {
+		if ( (*toPrint[7])[i].getY() >= 0.95 ) {
+			diapf = i/(double)pointsPerDay;
 			break;
 		}
 	}
@@ -99,44 +107,70 @@ void printCellInfo( std::string outputFile, SWDCellSingle cell) {
 	
 	// print overall data
 	fileOut << "\n\nTotal Cumulative Populations\n";
-	std::stringstream sstm;
-	sstm << "\n\t" << cell.getTotEggs() << "\t" << cell.getTotInst1() << "\t" << cell.getTotInst2() << 
-					"\t" << cell.getTotInst3() << "\t" << cell.getTotPupae() << "\t" << cell.getTotMales() << 
-					"\t" << cell.getTotFemales();;
-				
-	fileOut << sstm.str();
-	fileOut << "\n\nPeak Populations\n";
+	fileOut << "\n\t" << cell.getTotEggs() << "\t" << cell.getTotInst1() << "\t" << cell.getTotInst2() << 
+			"\t" << cell.getTotInst3() << "\t" << cell.getTotPupae() << "\t" << cell.getTotMales() << 
+			"\t" << cell.getTotFemales();
 
-	std::stringstream sstm1;
-	sstm1 << "\n\t" << cell.getMaxEggs() << "\t" << cell.getMaxInst1() << "\t" << cell.getMaxInst2() << 
+	fileOut << "\n\nPeak Populations\n";
+	fileOut << "\n\t" << cell.getMaxEggs() << "\t" << cell.getMaxInst1() << "\t" << cell.getMaxInst2() << 
 			"\t" << cell.getMaxInst3() << "\t" << cell.getMaxPupae() << "\t" << cell.getMaxMales() << 
 			"\t" << cell.getMaxFemales();
 
-	fileOut << sstm1.str();
-
 	fileOut << "\n\nPeak Populations Day\n";
-
-	std::stringstream sstm2;
-	sstm2 << "\n\t" << cell.getDayMaxEggs() << "\t" << cell.getDayMaxInst1() << "\t" << cell.getDayMaxInst2() << 
+	fileOut << "\n\t" << cell.getDayMaxEggs() << "\t" << cell.getDayMaxInst1() << "\t" << cell.getDayMaxInst2() << 
 			"\t" << cell.getDayMaxInst3() << "\t" << cell.getDayMaxPupae() << "\t" << cell.getDayMaxMales() << 
 			"\t" << cell.getDayMaxFemales();
-	
-	fileOut << sstm2.str();
 
-	std::stringstream sstm3;
-	sstm3 << "\n\nDiapause injection date: " << diapi << "\n\nFruit max date: " << diapf << "\n";
-	fileOut << sstm3.str();
+	fileOut << "\n\nDiapause injection date: " << diapi << "\n\nFruit max date: " << diapf << "\n";
 
-	fileOut.close();
+	fileOut.writeFile(outputFile);
 	
 }
 
+// method to print the summary of a run made in summary-only mode (see SWDSimulatorSingle::setSummaryOnly)
+void printCellSummary( std::string outputFile, const SWDCellSingle &cell) {
+	TextBuffer fileOut;
+
+	fileOut << "Total Cumulative Populations\n";
+	fileOut << "\n\t" << cell.getTotEggs() << "\t" << cell.getTotInst1() << "\t" << cell.getTotInst2() << 
+			"\t" << cell.getTotInst3() << "\t" << cell.getTotPupae() << "\t" << cell.getTotMales() << 
+			"\t" << cell.getTotFemales();
+
+	fileOut << "\n\nPeak Populations\n";
+	fileOut << "\n\t" << cell.getMaxEggs() << "\t" << cell.getMaxInst1() << "\t" << cell.getMaxInst2() << 
+			"\t" << cell.getMaxInst3() << "\t" << cell.getMaxPupae() << "\t" << cell.getMaxMales() << 
+			"\t" << cell.getMaxFemales();
+
+	fileOut << "\n\nPeak Populations Day\n";
+	fileOut << "\n\t" << cell.getDayMaxEggs() << "\t" << cell.getDayMaxInst1() << "\t" << cell.getDayMaxInst2() << 
+			"\t" << cell.getDayMaxInst3() << "\t" << cell.getDayMaxPupae() << "\t" << cell.getDayMaxMales() << 
+			"\t" << cell.getDayMaxFemales();
+
+	fileOut << "\n\nDiapause Crossing Day\n";
+	fileOut << "\n\t" << cell.getCrossedDiapDay();
+	fileOut << "\n\nMax Fruit Quality Day\n";
+	fileOut << "\n\t" << cell.getDayCrossedMaxFruit();
+
+	double elapsedDays = cell.getElapsedDays();
+	if (elapsedDays > 0) { // the totals are integrals over time, so the means are these over the time run
+		fileOut << "\n\nMean Populations\n";
+		fileOut << "\n\t" << cell.getTotEggs() / elapsedDays << "\t" << cell.getTotInst1() / elapsedDays << "\t" << cell.getTotInst2() / elapsedDays << 
+				"\t" << cell.getTotInst3() / elapsedDays << "\t" << cell.getTotPupae() / elapsedDays << "\t" << cell.getTotMales() / elapsedDays << 
+				"\t" << cell.getTotFemales() / elapsedDays;
+	}
+
+	fileOut << "\n\nDegree Days (base " << cell.getDegreeDayBase() << ")\n";
+	fileOut << "\n\t" << cell.getDegreeDays() << "\n";
+
+	fileOut.writeFile(outputFile);
+}
+
 // main method to run the code; this takes in the cmd line arguments
 int main(int argc, char *argv[]) {
 
-	if ( argc != 9)
+	if ( argc < 9 || argc > 11)
 	{
-		printf( "Error, exiting now\nUsage: ./singleSim useDefault paramFileName tempFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop");
+		printf( "Error, exiting now\nUsage: ./singleSim useDefault paramFileName tempFileName ignoreFruit ignoreDiapause outputFileName addFliesDate startingFemPop [euler|exponential|rk45] [summary]");
 		printf( "\n\nNote that: useDefault, ignoreFruit, ignoreDiapause are bools (0 = false)\nNote also that: addFliesDate as -1 specifies to add the flies on diapause cross date.");
 		exit( 0);
 	}
@@ -164,28 +198,55 @@ int main(int argc, char *argv[]) {
 	{
 		inputFileName = ""; // set to null filename if not reading from a file
 	}
-                                                         
-	// read temperatures in from file
-	std::ifstream infile( tempFileName);
-	std::vector< double> temperatures;
 
-	double temp;
-	while ( infile >> temp)
+	// optional arguments: the integrator, and/or "summary"
+	IntegratorMode integrator = EULER_INTEGRATOR;
+	bool summaryOnly = false;
+	for ( int k = 9; k < argc; k ++)
 	{
-		temperatures.push_back( temp);
+		if ( std::string( argv[ k]) == "summary")
+			summaryOnly = true;
+		else if ( !parseIntegratorMode( argv[ k], integrator))
+		{
+			printf( "Error: unknown integrator %s (use euler, exponential or rk45)\n", argv[ k]);
+			exit( 1);
+		}
 	}
+                                                         
+	// read temperatures in from file (through the parsed temperatures cache, if SWD_TEMPERATURE_CACHE is set)
+	const char* cacheDirectory = getenv( "SWD_TEMPERATURE_CACHE");
+	if ( cacheDirectory != NULL)
+		setTemperatureCache( cacheDirectory);
 
-	infile.close();
+	std::vector< double> temperatures;
+	readTemperatureFile( tempFileName, temperatures);
 
 	// set up and run the simulator
 	SWDSimulatorSingle sim( dt, inputFileName);
 
+	if ( integrator != EULER_INTEGRATOR)
+		sim.setIntegrator( integrator); // one step per day, exact or adaptive (this also sets dt to 1)
+
 	std::string param = "initial females1";
 	sim.setSingleParameter( param, startFemPop);
 
+	sim.setRecorder( RECORD_DAILY); // only keep the daily points (which are the ones printed)
+	if ( summaryOnly)
+	{
+		sim.setSummaryOnly( true); // (nothing is recorded)
+		sim.setStatistics( STATS_MEANS | STATS_DEGREE_DAYS);
+	}
+
 	sim.run( temperatures, runTime, ignoreFruit, ignoreDiapause, startDate);
 
-	printCellInfo( outputFileName, sim.getCell()); // print output to a file
+	if ( summaryOnly)
+	{
+		printCellSummary( outputFileName, sim.getCell());
+		return 0;
+	}
+
+	int pointsPerDay = sim.getCell().getPointsPerDay( sim.getStepsPerDay()); // datapoints per day
+	printCellInfo( outputFileName, sim.getCell(), pointsPerDay); // print output to a file
 
 	return 0;
 }
@@ -16,12 +16,12 @@
 
 // method to calculate the fecundity at a given temperature, given the parameters
 // of the current simulation (specified in the parameters object passed in)
-double solveSpecificFertility(double T, const Parameters &params) {
+double solveSpecificFertility(double T, const CompiledParameters &params) {
 	
 	long double d = 5.88L;
 	long double l = 52.68L;
 	
-	if (T > params.getParameter("fertility tmax"))
+	if (T > params.fertilityTmax)
 		return 0;
 	
 	if((pow(T,2) + pow(d,2)) < pow(l,2)){
@@ -102,8 +102,8 @@ double solveDev_Briere_Juvenile(double T, double devMult) {
 	// the equation is in the form: 1/d = aT(T-T0)sqrt(TL-T)
 	
 	double a = 0.0001113;
-	double T0 = 9.8504;
-	double TL = 30.99;
+	double T0 = BRIERE_T0;
+	double TL = BRIERE_TL;
 	
 	// if temperature is above max or below min, no development
 	if (T > TL || T < T0)
@@ -118,15 +118,15 @@ double solveDev_Briere_Juvenile(double T, double devMult) {
 
 // method to compute the stage-specific mortality at the given temperature
 // similar idea to development - the mortality is calculated via the same equation, but 
-// with stage dependent values which are passed in via the specified stage and
-// the parameters object
-double solveMortality(double T, const Parameters &params, std::string stage) {		
+// with stage dependent values which are passed in via the specified stage index and
+// the compiled parameters
+double solveMortality(double T, const CompiledParameters &params, int stage) {		
 	
-	std::vector<double> betas = params.getMortBetas(stage);
-	double Tlower = params.getParameter(stage + " mortality min temp");
-	double Tupper = params.getParameter(stage + " mortality max temp");
-	double maxM = params.getParameter(stage + " mortality max");
-	double tau = params.getParameter(stage + " mortality tau");
+	const double* betas = params.mortalityBetas[stage];
+	double Tlower = params.mortalityMinTemp[stage];
+	double Tupper = params.mortalityMaxTemp[stage];
+	double maxM = params.mortalityMax[stage];
+	double tau = params.mortalityTau[stage];
 	
 	if ((!(Tlower <= T && T <= Tupper))) // if temperature is not within tolerable range, max mortality is reached
 		return maxM; 
@@ -152,10 +152,10 @@ double getGT(double baseTemp, double currentTemp) {
 // method for computing the effect of fruit quality on development
 // this is a multiplier for development (as specified in the model explanation)
 // relevant constants are passed in via a parameters object
-double solveDevelopmentPlantEffect(double fruitQConstant, double currentQuality, const Parameters &params) {
+double solveDevelopmentPlantEffect(double fruitQConstant, double currentQuality, const CompiledParameters &params) {
 	
-	double m = params.getParameter("fruit m");
-	double n = params.getParameter("fruit n");
+	double m = params.fruitM;
+	double n = params.fruitN;
 	
 	double ratio = pow((currentQuality / fruitQConstant), n);
 	double effect = m * ratio * pow((1 + ratio), -1) + 1 - m;
@@ -166,11 +166,11 @@ double solveDevelopmentPlantEffect(double fruitQConstant, double currentQuality,
 // method for computing the stage-specific effect of fruit quality on mortality
 // this is an additive effect on mortality (as specified in the model explanation)
 // relevant constants are passed in via a parameters object
-// here stage is also passed in, since the effect is stage-specific
-double solveMortalityPlantEffect(double fruitQConstant, double currentQuality, const Parameters &params, std::string stage) {
+// here the stage index is also passed in, since the effect is stage-specific
+double solveMortalityPlantEffect(double fruitQConstant, double currentQuality, const CompiledParameters &params, int stage) {
 	
-	double n = params.getParameter("fruit n");
-	double maxMort = params.getParameter(stage + " mortality max");
+	double n = params.fruitN;
+	double maxMort = params.mortalityMax[stage];
 	
 	double m = 0.1 * maxMort;
 	
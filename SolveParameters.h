@@ -3,7 +3,7 @@
 
 #include <cmath>
 #include <limits>
-#include "Parameters.h"
+#include "CompiledParameters.h"
 
 /*
 
@@ -13,7 +13,11 @@
 
 */ 
 
-double solveSpecificFertility(double T, const Parameters &params);
+// temperature limits of the Briere development equation (no development outside of these)
+const double BRIERE_T0 = 9.8504;
+const double BRIERE_TL = 30.99;
+
+double solveSpecificFertility(double T, const CompiledParameters &params);
 
 double solveFertilityDiapauseEffect(double hours);
 
@@ -23,13 +27,13 @@ int solveDiapauseMultS2(double hours, int s1prev, int s2prev, double daylightHou
 
 double solveDev_Briere_Juvenile(double T, double devMult);
 
-double solveMortality(double T, const Parameters &params, std::string stage);
+double solveMortality(double T, const CompiledParameters &params, int stage);
 
 double getGT(double baseTemp, double currentTemp);
 
-double solveDevelopmentPlantEffect(double fruitQConstant, double currentQuality, const Parameters &params);
+double solveDevelopmentPlantEffect(double fruitQConstant, double currentQuality, const CompiledParameters &params);
 
-double solveMortalityPlantEffect(double fruitQConstant, double currentQuality, const Parameters &params, std::string stage);
+double solveMortalityPlantEffect(double fruitQConstant, double currentQuality, const CompiledParameters &params, int stage);
 
 
 #endif
\ No newline at end of file
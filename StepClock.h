@@ -0,0 +1,61 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef STEP_CLOCK_H
+#define STEP_CLOCK_H
+
+#include <cmath>
+
+/*
+
+	This struct is the simulation clock: the current day, and the current step (of length dt)
+	within the day.  Both are integers, so the day of a step is always exact (adding dt to a double
+	time 20 times a day drifts, so the day derived from it with (int) can be off by one step), and
+	nothing needs to be rounded every step.  The time as a double (i.e. for the output) is only
+	derived from the clock when it is recorded.
+
+	The steps have to divide a day evenly, so dt is rounded to the nearest 1/n of a day
+	(0.05 is 20 steps per day, and 1 is a single step per day).
+
+*/
+
+struct StepClock {
+
+	int day; // current day (since the start of the simulation)
+	int substep; // current step within the day (0 .. stepsPerDay - 1)
+	int stepsPerDay; // number of steps per day
+	double dt; // length of a step (1 / stepsPerDay)
+
+	StepClock(double dtNew = 0.05) : day(0), substep(0) { setDT(dtNew); }
+
+	// method to set the step length (rounded so the steps divide a day evenly)
+	void setDT(double dtNew) {
+		stepsPerDay = (dtNew > 0 && dtNew < 1) ? (int) (1 / dtNew + 0.5) : 1;
+		dt = 1.0 / stepsPerDay;
+	}
+
+	void reset() { day = 0; substep = 0; }
+
+	// method to move the clock forward one step
+	void advance() {
+		if (++ substep == stepsPerDay) {
+			substep = 0;
+			day ++;
+		}
+	}
+
+	// method to get the number of steps in the specified number of days (rounded up to a whole step)
+	long getNumSteps(double numDays) const { return numDays > 0 ? (long) std::ceil(numDays * stepsPerDay - 1E-9) : 0; }
+
+	// the current time, in days
+	double getTime() const { return day + substep * dt; }
+
+};
+
+#endif
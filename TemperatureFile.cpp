@@ -0,0 +1,202 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "TemperatureFile.h"
+#include <charconv>
+#include <functional>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+
+	This file contains the methods to read the temperature text files (see TemperatureFile.h).
+
+*/
+
+static std::string cacheDirectory; // directory of the parsed temperatures cache (empty if there's no cache)
+
+// header of a cache file, followed by the path of the temperature file and then the temperatures (as doubles)
+struct CacheHeader {
+	char magic[8]; // "SWDTEMP1"
+	int64_t sourceSize; // size and modification time of the temperature file when it was parsed
+	int64_t sourceSeconds;
+	int64_t sourceNanoseconds;
+	int64_t numValues;
+	int32_t pathLength;
+	int32_t hasNan;
+};
+
+static const char CACHE_MAGIC[8] = {'S', 'W', 'D', 'T', 'E', 'M', 'P', '1'};
+
+// method to check whether a character is whitespace (as skipped by >>)
+static inline bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// method to parse the temperature values in the text from text to end into temps, the same way as reading them with >>
+// (std::from_chars doesn't take a leading +, which >> does, and takes nan and inf, which >> doesn't)
+// returns true if any of the temperatures are NaN
+bool parseTemperatures(const char *text, const char *end, std::vector<double> &temps) {
+	bool hasNan = false;
+	while (true) {
+		while (text < end && isSpace(*text))
+			text ++;
+		if (text == end)
+			break;
+
+		const char *start = text;
+		if (*start == '+' && start + 1 < end && *(start + 1) != '-')
+			start ++;
+		char first = (*start == '-' && start + 1 < end) ? *(start + 1) : *start;
+		if (!((first >= '0' && first <= '9') || first == '.')) // (i.e. nan or inf, or not a number at all)
+			break;
+
+		double v;
+		std::from_chars_result result = std::from_chars(start, end, v);
+		if (result.ec != std::errc()) // not a number, or out of range (which >> also stops at)
+			break;
+
+		temps.push_back(v);
+		if (v != v)
+			hasNan = true;
+		text = result.ptr;
+	}
+	return hasNan;
+}
+
+// method to set the directory to cache the parsed temperature files in (it must already exist)
+// an empty directory turns off the cache (the default)
+// note: this is read by every thread reading temperatures, so set it before a run, not during one
+void setTemperatureCache(const std::string &directory) {
+	cacheDirectory = directory;
+}
+
+// method to get the directory of the parsed temperatures cache (empty if there's no cache)
+std::string getTemperatureCache() {
+	return cacheDirectory;
+}
+
+// method to get the name of the cache file for the temperature file at the specified (absolute) path
+static std::string getCacheFileName(const std::string &path) {
+	std::stringstream sstm;
+	sstm << cacheDirectory << "/" << std::hex << std::hash<std::string>()(path) << ".tcache";
+	return sstm.str();
+}
+
+// method to read the temperatures of the temperature file at the specified path (with the specified size and modification
+// time) from its cache file into temps, if there is one and it is up to date
+// returns true if the temperatures were read (and sets hasNan)
+static bool readCache(const std::string &path, const struct stat &info, std::vector<double> &temps, bool &hasNan) {
+	int fd = open(getCacheFileName(path).c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	CacheHeader header;
+	std::string cachedPath;
+	bool valid = read(fd, &header, sizeof(header)) == sizeof(header) && memcmp(header.magic, CACHE_MAGIC, 8) == 0 &&
+				 header.sourceSize == info.st_size && header.sourceSeconds == info.st_mtim.tv_sec &&
+				 header.sourceNanoseconds == info.st_mtim.tv_nsec && header.pathLength == path.size() && header.numValues >= 0;
+	if (valid) {
+		cachedPath.resize(header.pathLength);
+		valid = read(fd, &cachedPath[0], header.pathLength) == header.pathLength && cachedPath == path; // (in case two paths have the same hash)
+	}
+	if (valid) {
+		size_t start = temps.size();
+		temps.resize(start + header.numValues);
+		ssize_t numBytes = header.numValues * sizeof(double);
+		valid = numBytes == 0 || read(fd, &temps[start], numBytes) == numBytes;
+		if (!valid)
+			temps.resize(start);
+		hasNan = header.hasNan != 0;
+	}
+
+	close(fd);
+	return valid;
+}
+
+// method to write the parsed temperatures of the temperature file at the specified path to its cache file
+// the file is written under a temporary name and then renamed, so other threads and processes never see half a file
+static void writeCache(const std::string &path, const struct stat &info, const double *temps, size_t numValues, bool hasNan) {
+	CacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, 8);
+	header.sourceSize = info.st_size;
+	header.sourceSeconds = info.st_mtim.tv_sec;
+	header.sourceNanoseconds = info.st_mtim.tv_nsec;
+	header.numValues = numValues;
+	header.pathLength = path.size();
+	header.hasNan = hasNan;
+
+	std::string cacheFileName = getCacheFileName(path);
+	std::stringstream sstm;
+	sstm << cacheFileName << ".tmp" << getpid() << "_" << std::hash<std::thread::id>()(std::this_thread::get_id());
+	std::string tempFileName = sstm.str();
+
+	int fd = open(tempFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return; // (the cache is only an optimization, so failing to write it isn't an error)
+
+	ssize_t numBytes = numValues * sizeof(double);
+	bool written = write(fd, &header, sizeof(header)) == sizeof(header) && write(fd, path.data(), path.size()) == path.size() &&
+				   (numBytes == 0 || write(fd, temps, numBytes) == numBytes);
+	close(fd);
+
+	if (!written || rename(tempFileName.c_str(), cacheFileName.c_str()) != 0)
+		unlink(tempFileName.c_str());
+}
+
+// method to read in the temperature values (one per day, separated by whitespace) from the specified file, adding them to temps
+// the file is memory-mapped and parsed in place (see parseTemperatures), or the parsed values are read from the cache if
+// there is one (see setTemperatureCache); a missing file has no temperatures
+// returns true if any of the temperatures are NaN
+bool readTemperatureFile(const std::string &fileName, std::vector<double> &temps) {
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		return false;
+	}
+
+	// look for the temperatures in the cache
+	std::string path;
+	bool hasNan = false;
+	if (cacheDirectory.size() > 0) {
+		char absolutePath[PATH_MAX];
+		path = realpath(fileName.c_str(), absolutePath) ? absolutePath : fileName;
+		if (readCache(path, info, temps, hasNan)) {
+			close(fd);
+			return hasNan;
+		}
+	}
+
+	// parse the file
+	size_t start = temps.size();
+	if (info.st_size > 0) {
+		void *text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (text != MAP_FAILED) {
+			madvise(text, info.st_size, MADV_SEQUENTIAL);
+			hasNan = parseTemperatures((const char *) text, (const char *) text + info.st_size, temps);
+			munmap(text, info.st_size);
+		}
+	}
+	close(fd);
+
+	if (cacheDirectory.size() > 0)
+		writeCache(path, info, temps.size() > start ? &temps[start] : NULL, temps.size() - start, hasNan);
+
+	return hasNan;
+}
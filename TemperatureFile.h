@@ -0,0 +1,36 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef TEMPERATURE_FILE_H
+#define TEMPERATURE_FILE_H
+
+#include <vector>
+#include <string>
+
+/*
+
+	Header file for the TemperatureFile.cpp methods, which read the per-day temperature text files
+	(one value per day, separated by whitespace) used by the single and multicell simulators.
+
+	The files are memory-mapped and parsed with std::from_chars, which gives the same values as reading
+	them with >> (and stops at the same place, the first value which isn't a number), much faster.
+
+	Optionally, the parsed temperatures can be cached on disk (see setTemperatureCache): the cache file of a
+	temperature file is keyed by its path, size and modification time, so as long as the temperature file
+	doesn't change, later reads of it (in the same run or later ones) skip the parsing entirely.
+
+*/
+
+bool readTemperatureFile(const std::string &fileName, std::vector<double> &temps);
+bool parseTemperatures(const char *text, const char *end, std::vector<double> &temps);
+
+void setTemperatureCache(const std::string &directory);
+std::string getTemperatureCache();
+
+#endif
@@ -0,0 +1,165 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "TemperaturePrefetcher.h"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+
+	Implementation of the TemperaturePrefetcher class.
+	The class definition and description are included in the TemperaturePrefetcher header file.
+
+*/
+
+// constructor for the TemperaturePrefetcher: starts numReaders reader threads (none to read every cell in its worker),
+// which read the cells of the grid (of numCells cells) in the specified order, keeping at most depth1 cells ahead of the workers
+TemperaturePrefetcher::TemperaturePrefetcher(const std::vector<std::vector<std::string>> &tempsFiles1, int numCells, int numCols1, const std::vector<int> &order1, int depth1, int numReaders) : tempsFiles(tempsFiles1), numCols(numCols1), order(order1), depth(depth1 > 0 ? depth1 : 1), next(0), numBuffered(0), stopping(false), waitTime(0), numMissed(0) {
+	states.assign(numCells, PENDING);
+	temps.resize(numCells);
+	hasNan.assign(numCells, false);
+
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&cellRead, NULL);
+	pthread_cond_init(&cellTaken, NULL);
+
+	if (tempsFiles.size() == 0) // (nothing to read)
+		numReaders = 0;
+	readers.resize(numReaders > 0 ? numReaders : 0);
+	for (int i = 0; i < readers.size(); i ++) {
+		int rc = pthread_create(&readers[i], NULL, readerThread, (void *)this);
+		if (rc) {
+	        std::cout << "Error:unable to create thread," << rc << std::endl;
+	        exit(-1);
+    	}
+	}
+}
+
+// destructor for the TemperaturePrefetcher: the readers are stopped and joined
+TemperaturePrefetcher::~TemperaturePrefetcher() {
+	pthread_mutex_lock(&lock);
+	stopping = true;
+	pthread_cond_broadcast(&cellTaken);
+	pthread_mutex_unlock(&lock);
+
+	for (int i = 0; i < readers.size(); i ++)
+		pthread_join(readers[i], NULL);
+
+	pthread_mutex_destroy(&lock);
+	pthread_cond_destroy(&cellRead);
+	pthread_cond_destroy(&cellTaken);
+}
+
+// method to take the temperatures of the specified cell (numbered row by row) into cellTemps, for a worker
+// if the cell has been read ahead it is moved out of the buffer, if it is being read this waits for it, and otherwise
+// the cell is read here
+// returns true if any of the temperatures are NaN
+bool TemperaturePrefetcher::take(int cell, std::vector<double> &cellTemps) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool cellHasNan;
+
+	pthread_mutex_lock(&lock);
+	if (states[cell] == PENDING) { // the readers haven't got to it, so read it here (they'll skip it)
+		states[cell] = TAKEN;
+		numMissed ++;
+		pthread_mutex_unlock(&lock);
+
+		cellHasNan = readCell(cell, cellTemps);
+
+		pthread_mutex_lock(&lock);
+	} else {
+		while (states[cell] == READING)
+			pthread_cond_wait(&cellRead, &lock);
+
+		cellTemps = std::move(temps[cell]);
+		cellHasNan = hasNan[cell];
+		states[cell] = TAKEN;
+		numBuffered --;
+		pthread_cond_signal(&cellTaken); // (there is room to read another cell ahead)
+	}
+	waitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	pthread_mutex_unlock(&lock);
+
+	return cellHasNan;
+}
+
+// this method is the entry point of each reader thread, and the threadarg is a reference to the prefetcher
+void* TemperaturePrefetcher::readerThread(void *threadarg) {
+	((TemperaturePrefetcher *) threadarg)->readAhead();
+	pthread_exit(NULL);
+}
+
+// method to read the cells in order (skipping any the workers got to first), while there is room in the buffer,
+// until they have all been read or the prefetcher is stopped
+void TemperaturePrefetcher::readAhead() {
+	pthread_mutex_lock(&lock);
+	while (true) {
+		while (!stopping && numBuffered >= depth && next < order.size())
+			pthread_cond_wait(&cellTaken, &lock);
+		if (stopping || next >= order.size())
+			break;
+
+		int cell = order[next ++];
+		if (states[cell] != PENDING)
+			continue;
+		states[cell] = READING;
+		numBuffered ++;
+		int ahead = next + depth - 1 < order.size() ? order[next + depth - 1] : -1; // last cell the buffer will reach
+		pthread_mutex_unlock(&lock);
+
+		if (ahead >= 0)
+			adviseCell(ahead); // (so the kernel starts reading it from the disk already)
+		std::vector<double> cellTemps;
+		bool cellHasNan = readCell(cell, cellTemps);
+
+		pthread_mutex_lock(&lock);
+		temps[cell] = std::move(cellTemps);
+		hasNan[cell] = cellHasNan;
+		states[cell] = READY;
+		pthread_cond_broadcast(&cellRead);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+// method to read in the temperature values for the specified cell
+// if there are no temperature files, the cell is run at a constant 15 degrees
+// returns true if any of the temperatures are NaN
+bool TemperaturePrefetcher::readCell(int cell, std::vector<double> &cellTemps) const {
+	if (tempsFiles.size() == 0) {
+		cellTemps.push_back(15); // if no temps file, run at a constant 15 degrees (the sim can be run with no temp file if you really want)
+		return false;
+	}
+	return readTemperatureFile(tempsFiles[cell / numCols][cell % numCols], cellTemps);
+}
+
+// method to tell the kernel the temperature file of the specified cell will be needed soon, so it can read it ahead
+void TemperaturePrefetcher::adviseCell(int cell) const {
+	int fd = open(tempsFiles[cell / numCols][cell % numCols].c_str(), O_RDONLY);
+	if (fd >= 0) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		close(fd);
+	}
+}
+
+// method to get the total time the workers waited for temperatures (or read them themselves) so far, in seconds
+double TemperaturePrefetcher::getWaitTime() {
+	pthread_mutex_lock(&lock);
+	double time = waitTime;
+	pthread_mutex_unlock(&lock);
+	return time;
+}
+
+// method to get the number of cells the workers had to read themselves (because the readers hadn't got to them)
+int TemperaturePrefetcher::getNumMissed() {
+	pthread_mutex_lock(&lock);
+	int missed = numMissed;
+	pthread_mutex_unlock(&lock);
+	return missed;
+}
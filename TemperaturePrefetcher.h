@@ -0,0 +1,81 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef TEMPERATURE_PREFETCHER_H
+#define TEMPERATURE_PREFETCHER_H
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include "TemperatureFile.h"
+
+/*
+
+	Header file for TemperaturePrefetcher.cpp.  Contains the TemperaturePrefetcher class definition,
+	described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+/*
+	This class describes a TemperaturePrefetcher object, which reads the temperature files of the cells of
+	a multicell simulation ahead of the worker threads that need them.
+
+	Reader threads read and parse the files in the order the workers are expected to need them (see
+	WorkerPool::getTaskOrder), into a buffer of at most depth cells, and the workers take them out with take.
+	If a worker needs a cell the readers haven't got to yet (i.e. it stole a task from the end of another
+	worker's queue), it reads it itself.  With no reader threads, every cell is read by its worker.
+
+	The time the workers spend waiting for temperatures (or reading them themselves) is added up, to help
+	choose the depth and number of readers.
+*/
+class TemperaturePrefetcher {
+
+	enum CellState { PENDING, READING, READY, TAKEN };
+
+	const std::vector<std::vector<std::string>> &tempsFiles; // temperature file of each cell (no files: constant 15 degrees)
+	int numCols; // (the cells are numbered row by row)
+	std::vector<int> order; // order to read the cells in (cells not in it, i.e. masked cells, are never read)
+	int depth; // max cells read ahead (read or being read, but not taken yet)
+
+	std::vector<CellState> states; // state of each cell
+	std::vector<std::vector<double>> temps; // temperatures of each cell read but not taken yet
+	std::vector<bool> hasNan; // whether each cell read has NaN temperatures
+
+	pthread_mutex_t lock; // lock for all the state
+	pthread_cond_t cellRead; // signalled when a cell has been read
+	pthread_cond_t cellTaken; // signalled when a cell has been taken out of the buffer (or the readers should stop)
+	int next; // position in order of the next cell to read
+	int numBuffered; // cells read or being read, but not taken yet
+	bool stopping;
+	double waitTime; // total time the workers waited for temperatures so far, in seconds
+	int numMissed; // cells the workers had to read themselves
+
+	std::vector<pthread_t> readers;
+	static void* readerThread(void *threadarg);
+	void readAhead();
+	bool readCell(int cell, std::vector<double> &cellTemps) const;
+	void adviseCell(int cell) const;
+
+public:
+
+	TemperaturePrefetcher(const std::vector<std::vector<std::string>> &tempsFiles1, int numCells, int numCols1, const std::vector<int> &order1, int depth1, int numReaders);
+	~TemperaturePrefetcher();
+
+	TemperaturePrefetcher(const TemperaturePrefetcher&) = delete;
+	TemperaturePrefetcher& operator=(const TemperaturePrefetcher&) = delete;
+
+	bool take(int cell, std::vector<double> &cellTemps);
+
+	double getWaitTime();
+	int getNumMissed();
+
+};
+
+#endif
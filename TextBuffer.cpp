@@ -0,0 +1,91 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "TextBuffer.h"
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+
+	Implementation of the TextBuffer class.  The class definition and description are included in the
+	TextBuffer header file.
+
+*/
+
+static const int MAX_NUMBER_LENGTH = 32; // (longer than any double with 6 significant digits, or any long)
+
+// constructor for an empty TextBuffer, with room for capacity characters before it needs to grow
+TextBuffer::TextBuffer(size_t capacity) : text(capacity > 0 ? capacity : 1), length(0) {}
+
+// method to make room for extra more characters at the end of the buffer
+// returns the end of the text (where they go)
+char* TextBuffer::reserve(size_t extra) {
+	if (length + extra > text.size())
+		text.resize(std::max(length + extra, 2 * text.size()));
+	return text.data() + length;
+}
+
+// method to add a double, formatted as an ostream does by default (%g with 6 significant digits)
+TextBuffer& TextBuffer::operator<<(double value) {
+	char *start = reserve(MAX_NUMBER_LENGTH);
+	std::to_chars_result result = std::to_chars(start, start + MAX_NUMBER_LENGTH, value, std::chars_format::general, 6);
+	length = result.ptr - text.data();
+	return *this;
+}
+
+// method to add an int
+TextBuffer& TextBuffer::operator<<(int value) {
+	return *this << (long) value;
+}
+
+// method to add a long
+TextBuffer& TextBuffer::operator<<(long value) {
+	char *start = reserve(MAX_NUMBER_LENGTH);
+	std::to_chars_result result = std::to_chars(start, start + MAX_NUMBER_LENGTH, value);
+	length = result.ptr - text.data();
+	return *this;
+}
+
+// method to add a string
+TextBuffer& TextBuffer::operator<<(const char *value) {
+	size_t size = strlen(value);
+	memcpy(reserve(size), value, size);
+	length += size;
+	return *this;
+}
+
+// same as above, for a std::string
+TextBuffer& TextBuffer::operator<<(const std::string &value) {
+	memcpy(reserve(value.size()), value.data(), value.size());
+	length += value.size();
+	return *this;
+}
+
+// method to write the text to the specified file (replacing it, if it exists) with a single write
+// returns false if the file couldn't be written
+bool TextBuffer::writeFile(const std::string &fileName) const {
+	int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666); // (the same permissions as an ofstream)
+	if (fd < 0)
+		return false;
+
+	const char *bytes = text.data();
+	size_t remaining = length;
+	while (remaining > 0) {
+		ssize_t written = write(fd, bytes, remaining);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			break;
+		bytes += written;
+		remaining -= written;
+	}
+	return close(fd) == 0 && remaining == 0;
+}
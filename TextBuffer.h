@@ -0,0 +1,61 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/*
+
+	Header file for TextBuffer.cpp.  Contains the TextBuffer class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+
+/*
+	This class describes a TextBuffer object, which formats the text output files (the data and summary files)
+	in memory, to be written to the file in one go.
+
+	Values are added with <<, like an ostream, and formatted exactly as an ostream with the default settings
+	formats them (doubles with 6 significant digits, as printf's %g), but with std::to_chars straight into the
+	buffer, so there is no stream (or locale) machinery per value, and no stringstream per line.
+	The buffer only grows, so a buffer reused for many files (i.e. by a writer thread, with clear between files)
+	stops allocating memory after the first few.
+*/
+class TextBuffer {
+
+	std::vector<char> text;
+	size_t length; // characters used so far
+
+	char* reserve(size_t extra);
+
+public:
+
+	TextBuffer(size_t capacity = 1 << 16);
+
+	void clear() { length = 0; }
+	size_t size() const { return length; }
+	const char* data() const { return text.data(); }
+	std::string str() const { return std::string(text.data(), length); }
+
+	TextBuffer& operator<<(double value);
+	TextBuffer& operator<<(int value);
+	TextBuffer& operator<<(long value);
+	TextBuffer& operator<<(const char *value);
+	TextBuffer& operator<<(const std::string &value);
+
+	bool writeFile(const std::string &fileName) const;
+
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "UtilityMethods.h"
+#include <cerrno>
+#include <unistd.h>
 
 /*
 
@@ -44,6 +46,30 @@ double sumDoubleArray(const double toSum[], int len) {
 	return sum;
 }
 
+// method to write all the specified bytes to a file descriptor (retrying partial and interrupted writes)
+// returns false if the write failed
+bool writeFully(int fd, const char *bytes, size_t size) {
+	while (size > 0) {
+		ssize_t written = ::write(fd, bytes, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+		bytes += written;
+		size -= written;
+	}
+	return true;
+}
+
+// method to replace every occurrence of key in text with the specified number (i.e. {row} in a file name pattern)
+std::string replaceAll(std::string text, const std::string &key, int number) {
+	std::stringstream sstm;
+	sstm << number;
+	for (size_t pos = text.find(key); pos != std::string::npos; pos = text.find(key, pos))
+		text.replace(pos, key.size(), sstm.str());
+	return text;
+}
+
 
 
 // implementation of the + operator overloading for commutative catenation 
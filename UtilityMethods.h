@@ -23,6 +23,10 @@ std::vector<double> copyDoubleArray(const double toCopy[], int len);
 
 double sumDoubleArray(const double toSum[], int len);
 
+bool writeFully(int fd, const char *bytes, size_t size);
+
+std::string replaceAll(std::string text, const std::string &key, int number);
+
 
 
 // the singular purpose of this class is to allow the easy catenation of strings
@@ -0,0 +1,191 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+#include "WorkerPool.h"
+#include <thread>
+#include <iostream>
+#include <cstdlib>
+
+/*
+
+	Implementation of the WorkerPool class.  The class definition and description are included
+	in the WorkerPool header file.
+
+*/
+
+// constructor for the WorkerPool: starts numWorkers worker threads (at least one), which wait for tasks
+WorkerPool::WorkerPool(int numWorkers) : function(NULL), arg(NULL), numQueued(0), numUnclaimed(0), stopping(false), numStarted(0) {
+	if (numWorkers < 1)
+		numWorkers = 1;
+
+	queues.resize(numWorkers);
+	queueLocks.resize(numWorkers);
+	for (int w = 0; w < numWorkers; w ++)
+		pthread_mutex_init(&queueLocks[w], NULL);
+	pthread_mutex_init(&stateLock, NULL);
+	pthread_cond_init(&tasksAdded, NULL);
+	pthread_cond_init(&taskFinished, NULL);
+
+	workers.resize(numWorkers);
+	for (int w = 0; w < numWorkers; w ++) {
+		int rc = pthread_create(&workers[w], NULL, workerThread, (void *)this);
+		if (rc) {
+	        std::cout << "Error:unable to create thread," << rc << std::endl;
+	        exit(-1);
+    	}
+	}
+}
+
+// destructor for the WorkerPool: the workers finish any tasks left, and are joined
+WorkerPool::~WorkerPool() {
+	pthread_mutex_lock(&stateLock);
+	stopping = true;
+	pthread_cond_broadcast(&tasksAdded);
+	pthread_mutex_unlock(&stateLock);
+
+	for (int w = 0; w < workers.size(); w ++)
+		pthread_join(workers[w], NULL);
+
+	for (int w = 0; w < queueLocks.size(); w ++)
+		pthread_mutex_destroy(&queueLocks[w]);
+	pthread_mutex_destroy(&stateLock);
+	pthread_cond_destroy(&tasksAdded);
+	pthread_cond_destroy(&taskFinished);
+}
+
+// method to get the number of workers to use by default: one per hardware thread of the machine
+// (2 if the number of hardware threads can't be found)
+int WorkerPool::getDefaultNumWorkers() {
+	int numCores = std::thread::hardware_concurrency();
+	return numCores > 0 ? numCores : 2;
+}
+
+// method to get the order the tasks of a job of numTasks tasks are expected to be started in by numWorkers workers
+// (the first task of each worker's block, then the second task of each block, etc), i.e. for reading their inputs ahead
+// the actual order varies with the time each task takes, and the tasks stolen from the ends of the blocks
+std::vector<int> WorkerPool::getTaskOrder(int numTasks, int numWorkers) {
+	std::vector<int> order;
+	order.reserve(numTasks);
+	for (int k = 0; order.size() < numTasks; k ++) {
+		for (int w = 0; w < numWorkers; w ++) {
+			int task = (long) numTasks * w / numWorkers + k;
+			if (task < (long) numTasks * (w + 1) / numWorkers)
+				order.push_back(task);
+		}
+	}
+	return order;
+}
+
+// method to submit a job of numTasks tasks, numbered 0 .. numTasks - 1: functionNew(task, argNew) is run for each
+// task by one of the workers
+// the tasks are split into contiguous blocks, one block per worker queue (see the class description)
+// note: all the tasks of the previous job must have been handed back (with waitForTask) first
+void WorkerPool::submit(int numTasks, TaskFunction functionNew, void *argNew) {
+	pthread_mutex_lock(&stateLock);
+	function = functionNew;
+	arg = argNew;
+
+	int numWorkers = workers.size();
+	for (int w = 0; w < numWorkers; w ++) {
+		pthread_mutex_lock(&queueLocks[w]);
+		for (int task = (long) numTasks * w / numWorkers; task < (long) numTasks * (w + 1) / numWorkers; task ++)
+			queues[w].push_back(task);
+		pthread_mutex_unlock(&queueLocks[w]);
+	}
+
+	numQueued += numTasks;
+	numUnclaimed += numTasks;
+	pthread_cond_broadcast(&tasksAdded);
+	pthread_mutex_unlock(&stateLock);
+}
+
+// method to wait for the next task of the job to finish
+// returns the number of the task (in the order they finish), or -1 once every task has been handed back
+int WorkerPool::waitForTask() {
+	pthread_mutex_lock(&stateLock);
+	while (finished.empty() && numUnclaimed > 0)
+		pthread_cond_wait(&taskFinished, &stateLock);
+
+	int task = -1;
+	if (!finished.empty()) {
+		task = finished.front();
+		finished.pop_front();
+		numUnclaimed --;
+	}
+	pthread_mutex_unlock(&stateLock);
+	return task;
+}
+
+// this method is the entry point of each worker thread, and the threadarg is a reference to the pool
+void* WorkerPool::workerThread(void *threadarg) {
+	WorkerPool *pool = (WorkerPool *) threadarg;
+
+	pthread_mutex_lock(&pool->stateLock);
+	int worker = pool->numStarted ++; // (the workers' queues are numbered in the order they start)
+	pthread_mutex_unlock(&pool->stateLock);
+
+	pool->work(worker);
+	pthread_exit(NULL);
+}
+
+// method to run the tasks of the specified worker, until the pool is stopped
+void WorkerPool::work(int worker) {
+	while (true) {
+
+		int task;
+		if (takeTask(worker, task)) {
+			function(task, arg);
+
+			pthread_mutex_lock(&stateLock);
+			finished.push_back(task);
+			pthread_cond_signal(&taskFinished);
+			pthread_mutex_unlock(&stateLock);
+			continue;
+		}
+
+		// no tasks left to take, so wait for more (another worker may have taken the last one first)
+		pthread_mutex_lock(&stateLock);
+		while (numQueued == 0 && !stopping)
+			pthread_cond_wait(&tasksAdded, &stateLock);
+		bool done = (numQueued == 0 && stopping);
+		pthread_mutex_unlock(&stateLock);
+
+		if (done)
+			return;
+	}
+}
+
+// method to take a task for the specified worker: the next one from its own queue, or else the last one from
+// the next worker's queue which has any
+// returns false if every queue is empty
+bool WorkerPool::takeTask(int worker, int &task) {
+	int numWorkers = queues.size();
+	bool found = false;
+
+	for (int i = 0; i < numWorkers && !found; i ++) {
+		int w = (worker + i) % numWorkers;
+		pthread_mutex_lock(&queueLocks[w]);
+		if (!queues[w].empty()) {
+			if (w == worker) {
+				task = queues[w].front();
+				queues[w].pop_front();
+			} else { // steal (from the other end, away from where the owner is working)
+				task = queues[w].back();
+				queues[w].pop_back();
+			}
+			found = true;
+		}
+		pthread_mutex_unlock(&queueLocks[w]);
+	}
+
+	if (found) {
+		pthread_mutex_lock(&stateLock);
+		numQueued --;
+		pthread_mutex_unlock(&stateLock);
+	}
+	return found;
+}
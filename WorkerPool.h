@@ -0,0 +1,79 @@
+/*
+This file is part of the dsPopSim software and is subject to the license distributed
+with the software (see LICENSE.txt and CITATION.txt).
+Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+All rights reserved.
+*/
+
+
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
+/*
+
+	Header file for WorkerPool.cpp.  Contains the WorkerPool class definition, described below.
+	Method definitions are included in the cpp file, along with descriptions of the code.
+
+*/
+
+// function run for each task (the task number, and the argument passed to WorkerPool::submit)
+typedef void (*TaskFunction)(int task, void *arg);
+
+/*
+	This class describes a WorkerPool object, which is a fixed set of worker threads that run numbered
+	tasks (i.e. the cells of a multicell simulation) until the pool is destroyed.
+
+	The tasks of a job are split into contiguous blocks, one per worker, and each worker has its own queue.
+	A worker takes its own tasks in order from the front of its queue, and when its queue is empty it steals
+	from the back of another worker's queue, so the workers all stay busy until the last tasks, even if some
+	tasks take much longer than others (there is no barrier between groups of tasks).
+
+	The finished tasks are handed back to the submitting thread as they finish, with waitForTask.
+*/
+class WorkerPool {
+
+	std::vector<pthread_t> workers;
+	std::vector<std::deque<int>> queues; // tasks not started yet, for each worker
+	std::vector<pthread_mutex_t> queueLocks; // lock of each queue
+
+	pthread_mutex_t stateLock; // lock for the rest of the state (below)
+	pthread_cond_t tasksAdded; // signalled when tasks are submitted (or the pool is stopping)
+	pthread_cond_t taskFinished; // signalled when a task finishes
+
+	TaskFunction function; // function and argument of the current job
+	void *arg;
+	int numQueued; // tasks not taken by a worker yet
+	int numUnclaimed; // tasks submitted, but not handed back by waitForTask yet
+	std::deque<int> finished; // finished tasks, not handed back yet
+	bool stopping;
+	int numStarted; // worker threads started so far (so each can find its queue)
+
+	static void* workerThread(void *threadarg);
+	void work(int worker);
+	bool takeTask(int worker, int &task);
+
+public:
+
+	WorkerPool(int numWorkers);
+	~WorkerPool();
+
+	// (the threads refer to the pool, so it can't be copied)
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void submit(int numTasks, TaskFunction functionNew, void *argNew);
+	int waitForTask();
+
+	int getNumWorkers() const { return workers.size(); }
+
+	static int getDefaultNumWorkers();
+	static std::vector<int> getTaskOrder(int numTasks, int numWorkers);
+
+};
+
+#endif
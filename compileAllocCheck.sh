@@ -0,0 +1,28 @@
+#This file is part of the dsPopSim software and is subject to the license distributed
+#with the software (see LICENSE.txt and CITATION.txt).  
+#Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+#All rights reserved.
+
+#Builds singleSim and ensembleSim with the allocation check on (see AllocationCounter.h), and runs them: a run
+#that allocates while stepping a cell fails its assert.  The ensemble is run on 4 threads, so cells are stepped
+#on several threads at once.
+
+set -e
+
+g++ -std=c++17 -O2 -pthread -DSWD_ALLOC_CHECK SingleCellRunner.cpp SWDSimulatorSingle.cpp SWDCellSingle.cpp SWDPopulation.cpp Parameters.cpp CompiledParameters.cpp RateTable.cpp PhotoperiodTable.cpp UtilityMethods.cpp AllocationCounter.cpp SolveParameters.cpp Daylight.cpp EulersMethod.cpp ExponentialMethod.cpp RungeKuttaMethod.cpp SWDCellMulti.cpp SWDCellBatch.cpp WorkerPool.cpp TemperatureFile.cpp TemperaturePrefetcher.cpp ClimateCube.cpp GridMask.cpp GridOutputFile.cpp ResultsFile.cpp TextBuffer.cpp SWDSimulatorMulti.cpp -o singleSimAllocCheck
+g++ -std=c++17 -O2 -pthread -DSWD_ALLOC_CHECK EnsembleRunner.cpp SWDEnsemble.cpp SWDSimulatorSingle.cpp SWDCellSingle.cpp SWDPopulation.cpp Parameters.cpp CompiledParameters.cpp RateTable.cpp PhotoperiodTable.cpp UtilityMethods.cpp AllocationCounter.cpp SolveParameters.cpp Daylight.cpp EulersMethod.cpp ExponentialMethod.cpp RungeKuttaMethod.cpp WorkerPool.cpp TemperatureFile.cpp TextBuffer.cpp -o ensembleSimAllocCheck
+
+for integrator in euler exponential rk45; do
+	./singleSimAllocCheck 0 configParams.txt clark_2003.txt 0 0 allocCheckOutput.txt -1 10 $integrator > /dev/null
+done
+
+echo "initial females1, fruit time lag" > allocCheckVariants.csv
+for females in 5 10 20 40 80 160 320 640; do
+	for lag in 30 35 40 45 50 55 60 65; do
+		echo "$females, $lag" >> allocCheckVariants.csv
+	done
+done
+./ensembleSimAllocCheck 0 configParams.txt clark_2003.txt allocCheckVariants.csv 0 0 allocCheckOutput.txt -1 10 4 > /dev/null
+
+rm -f allocCheckOutput.txt allocCheckVariants.csv
+echo "Allocation check passed"
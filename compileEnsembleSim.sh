@@ -0,0 +1,6 @@
+#This file is part of the dsPopSim software and is subject to the license distributed
+#with the software (see LICENSE.txt and CITATION.txt).  
+#Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+#All rights reserved.
+
+g++ -std=c++17 -O2 -pthread EnsembleRunner.cpp SWDEnsemble.cpp SWDSimulatorSingle.cpp SWDCellSingle.cpp SWDPopulation.cpp Parameters.cpp CompiledParameters.cpp RateTable.cpp PhotoperiodTable.cpp UtilityMethods.cpp AllocationCounter.cpp SolveParameters.cpp Daylight.cpp EulersMethod.cpp ExponentialMethod.cpp RungeKuttaMethod.cpp WorkerPool.cpp TemperatureFile.cpp TextBuffer.cpp -o ensembleSim
@@ -0,0 +1,6 @@
+#This file is part of the dsPopSim software and is subject to the license distributed
+#with the software (see LICENSE.txt and CITATION.txt).  
+#Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
+#All rights reserved.
+
+g++ -std=c++17 -O2 -pthread ExtractGridOutput.cpp GridOutputFile.cpp UtilityMethods.cpp -o extractGridOutput
@@ -3,4 +3,4 @@
 #Copyright (c) 2016, Aaron B. Langille, Ellen M. Arteca, Jonathan A. Newman
 #All rights reserved.
 
-g++ -std=c++11 -pthread MultiCellRCP_demo.cpp SWDSimulatorSingle.cpp SWDCellSingle.cpp SWDPopulation.cpp Parameters.cpp UtilityMethods.cpp SolveParameters.cpp Daylight.cpp EulersMethod.cpp SWDCellMulti.cpp SWDSimulatorMulti.cpp -o multiSimDemo
+g++ -std=c++17 -O2 -pthread MultiCellRCP_demo.cpp SWDSimulatorSingle.cpp SWDCellSingle.cpp SWDPopulation.cpp Parameters.cpp CompiledParameters.cpp RateTable.cpp PhotoperiodTable.cpp UtilityMethods.cpp AllocationCounter.cpp SolveParameters.cpp Daylight.cpp EulersMethod.cpp ExponentialMethod.cpp RungeKuttaMethod.cpp SWDCellMulti.cpp SWDCellBatch.cpp WorkerPool.cpp TemperatureFile.cpp TemperaturePrefetcher.cpp ClimateCube.cpp GridMask.cpp GridOutputFile.cpp ResultsFile.cpp TextBuffer.cpp SWDSimulatorMulti.cpp -o multiSimDemo